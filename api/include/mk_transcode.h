@@ -107,6 +107,18 @@ API_EXPORT void API_CALL mk_decoder_decode(mk_decoder ctx, mk_frame frame, int a
  */
 API_EXPORT void API_CALL mk_decoder_set_max_async_frame_size(mk_decoder ctx, size_t size);
 
+/**
+ * 获取异步解码待解码的帧个数(队列深度)
+ * Get the number of frames waiting to be decoded asynchronously (queue depth)
+ */
+API_EXPORT size_t API_CALL mk_decoder_get_async_frame_size(mk_decoder ctx);
+
+/**
+ * 获取异步解码因积压而丢弃的帧数
+ * Get the number of frames dropped due to asynchronous decoding backlog
+ */
+API_EXPORT uint64_t API_CALL mk_decoder_get_drop_count(mk_decoder ctx);
+
 /**
  * 设置解码输出回调
  * @param ctx 解码器
@@ -56,6 +56,16 @@ API_EXPORT void API_CALL mk_decoder_set_max_async_frame_size(mk_decoder ctx, siz
     ((FFmpegDecoder *) ctx)->setMaxTaskSize(size);
 }
 
+API_EXPORT size_t API_CALL mk_decoder_get_async_frame_size(mk_decoder ctx) {
+    assert(ctx);
+    return ((FFmpegDecoder *) ctx)->getTaskSize();
+}
+
+API_EXPORT uint64_t API_CALL mk_decoder_get_drop_count(mk_decoder ctx) {
+    assert(ctx);
+    return ((FFmpegDecoder *) ctx)->getDropCount();
+}
+
 API_EXPORT void API_CALL mk_decoder_set_cb(mk_decoder ctx, on_mk_decode cb, void *user_data) {
     mk_decoder_set_cb2(ctx, cb, user_data, nullptr);
 }
@@ -9,12 +9,24 @@
  */
 
 #include "AACRtp.h"
+#include "Common/config.h"
 
 namespace mediakit{
 
 bool AACRtpEncoder::inputFrame(const Frame::Ptr &frame) {
     auto ptr = (char *)frame->data() + frame->prefixSize();
     auto size = frame->size() - frame->prefixSize();
+    GET_CONFIG(uint32_t, aggregate_ms, Rtp::kAacAggregateMS);
+    // 2字节AU-headers-length，每个au有2字节AU-header
+    // 2-byte AU-headers-length, each au has a 2-byte AU-header
+    if (aggregate_ms && size + 4 <= getRtpInfo().getMaxSize()) {
+        aggregate(ptr, size, frame->dts(), aggregate_ms);
+        return true;
+    }
+    // 该au需要分片，先输出之前合并的au
+    // This au needs to be fragmented, output the previously merged au first
+    flush();
+
     auto remain_size = size;
     auto max_size = getRtpInfo().getMaxSize() - 4;
     while (remain_size > 0) {
@@ -40,6 +52,56 @@ void AACRtpEncoder::outputRtp(const char *data, size_t len, size_t total_len, bo
     RtpCodec::inputRtp(std::move(rtp), false);
 }
 
+void AACRtpEncoder::aggregate(const char *data, size_t len, uint64_t dts, uint32_t max_ms) {
+    // 相邻au的时间戳增量，时间戳回退或跳跃时视为未知
+    // Timestamp increment of adjacent au, regarded as unknown when the timestamp goes back or jumps
+    uint64_t au_duration = (!_last_dts || dts < _last_dts || dts - _last_dts > 100) ? 0 : dts - _last_dts;
+    if (!_au_sizes.empty()) {
+        auto bytes = 2 + 2 * (_au_sizes.size() + 1) + _aus.size() + len;
+        if ((!au_duration && dts != _last_dts) || dts + au_duration - _first_dts > max_ms || bytes > getRtpInfo().getMaxSize()) {
+            // 时间戳不连续、超过时长限制或超过mtu，先输出之前合并的au
+            // Discontinuous timestamp, exceeding the duration limit or the mtu, output the previously merged au first
+            flush();
+        }
+    }
+    if (_au_sizes.empty()) {
+        // rfc3640 rtp时间戳为包内第一个au的时间戳
+        // rfc3640 the rtp timestamp is the timestamp of the first au in the packet
+        _first_dts = dts;
+    }
+    _au_sizes.emplace_back(len);
+    _aus.append(data, len);
+    _last_dts = dts;
+    if (au_duration && dts + 2 * au_duration - _first_dts > max_ms) {
+        // 再合并一个au将超过时长限制，立即输出，避免增加一帧延时
+        // Merging one more au will exceed the duration limit, output immediately to avoid adding one frame delay
+        flush();
+    }
+}
+
+void AACRtpEncoder::flush() {
+    if (_au_sizes.empty()) {
+        return;
+    }
+    auto au_count = _au_sizes.size();
+    auto rtp = getRtpInfo().makeRtp(TrackAudio, nullptr, 2 + 2 * au_count + _aus.size(), true, _first_dts);
+    auto payload = rtp->data() + RtpPacket::kRtpTcpHeaderSize + RtpPacket::kRtpHeaderSize;
+    // AU-headers-length，单位bit，每个AU-header为13bit长度+3bit索引
+    // AU-headers-length, in bits, each AU-header is 13-bit size + 3-bit index
+    payload[0] = ((au_count * 16) >> 8) & 0xFF;
+    payload[1] = (au_count * 16) & 0xFF;
+    auto au_header = payload + 2;
+    for (auto size : _au_sizes) {
+        au_header[0] = (size >> 5) & 0xFF;
+        au_header[1] = ((size & 0x1F) << 3) & 0xFF;
+        au_header += 2;
+    }
+    memcpy(au_header, _aus.data(), _aus.size());
+    _au_sizes.clear();
+    _aus.clear();
+    RtpCodec::inputRtp(std::move(rtp), false);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////
 
 AACRtpDecoder::AACRtpDecoder() {
@@ -88,43 +150,63 @@ bool AACRtpDecoder::inputRtp(const RtpPacket::Ptr &rtp, bool key_pos) {
         return false;
     }
 
-    if (!_last_dts) {
-        // 记录第一个时间戳  [AUTO-TRANSLATED:2e85b398]
-        // Record the first timestamp
-        _last_dts = stamp;
+    if (!_frame->_buffer.empty() && _frame->_dts != stamp) {
+        // 上个au的分片不完整(丢包)，丢弃之
+        // The fragments of the previous au are incomplete (packet loss), discard it
+        WarnL << "drop incomplete aac frame, size:" << _frame->size() << ", rtp:\r\n" << rtp->dumpString();
+        _frame->_buffer.clear();
     }
 
-    // 每个audio unit时间戳增量  [AUTO-TRANSLATED:0345240c]
-    // Timestamp increment for each audio unit
-    auto dts_inc = static_cast<int64_t>(stamp - _last_dts) / au_header_count;
-    if (dts_inc < 0 || dts_inc > 100) {
-        // 时间戳增量异常，忽略  [AUTO-TRANSLATED:d2750ef8]
-        // Timestamp increment anomaly, ignore
-        dts_inc = 0;
+    // rfc3640 rtp时间戳为包内第一个au的时间戳，其后每个au的时间戳增量由上个rtp包的时间戳差值与其au个数计算
+    // rfc3640 the rtp timestamp is that of the first au in the packet, the timestamp increment of each subsequent au
+    // is calculated from the timestamp difference of the previous rtp packet and its au count
+    int64_t stamp_diff = stamp - _last_dts;
+    size_t au_count = _last_au_count;
+    if (!_last_dts || !au_count || stamp_diff <= 0 || stamp_diff > 100 * (int64_t)au_count) {
+        // 时间戳增量未知或异常，按每个au 1024个采样估算
+        // The timestamp increment is unknown or abnormal, estimate by 1024 samples per au
+        stamp_diff = rtp->sample_rate ? 1024 * 1000 / rtp->sample_rate : 0;
+        au_count = 1;
     }
 
     for (auto i = 0u; i < (size_t)au_header_count; ++i) {
         // 之后的2字节是AU_HEADER,其中高13位表示一帧AAC负载的字节长度，低3位无用  [AUTO-TRANSLATED:404eb444]
         // The following 2 bytes are AU_HEADER, where the high 13 bits represent the byte length of one frame of AAC payload, and the low 3 bits are useless
-        auto size = ((au_header_ptr[0] << 8) | au_header_ptr[1]) >> 3;
-        auto len = std::min<int>(size, end - ptr);
-        if (len <= 0) {
+        size_t size = ((au_header_ptr[0] << 8) | au_header_ptr[1]) >> 3;
+        au_header_ptr += 2;
+        if (size <= _frame->size()) {
+            WarnL << "invalid aac au size:" << size << ", rtp:\r\n" << rtp->dumpString();
+            _frame->_buffer.clear();
+            break;
+        }
+        auto need = size - _frame->size();
+        auto len = std::min<size_t>(need, end - ptr);
+        if (!len) {
+            break;
+        }
+        if (len < need && au_header_count > 1) {
+            // 多au的rtp包只能包含完整的au，数据不够说明该包已损坏
+            // A multi-au rtp packet can only contain complete au, insufficient data means the packet is corrupted
+            WarnL << "invalid multi-au aac rtp, au size:" << size << ", remain:" << len << ", rtp:\r\n" << rtp->dumpString();
+            _frame->_buffer.clear();
             break;
         }
+        if (_frame->_buffer.empty()) {
+            // 设置当前audio unit时间戳  [AUTO-TRANSLATED:eee18d6e]
+            // Set the current audio unit timestamp
+            _frame->_dts = stamp + i * stamp_diff / au_count;
+        }
         _frame->_buffer.append((char *)ptr, len);
         ptr += len;
-        au_header_ptr += 2;
 
-        if (_frame->size() >= (size_t)size) {
-            // 设置当前audio unit时间戳  [AUTO-TRANSLATED:eee18d6e]
-            // Set the current audio unit timestamp
-            _frame->_dts = _last_dts + i * dts_inc;
+        if (_frame->size() >= size) {
             flushData();
         }
     }
     // 记录上次时间戳  [AUTO-TRANSLATED:a830d69f]
     // Record the last timestamp
     _last_dts = stamp;
+    _last_au_count = au_header_count;
     return false;
 }
 
@@ -45,6 +45,7 @@ private:
 
 private:
     uint64_t _last_dts = 0;
+    size_t _last_au_count = 0;
     FrameImp::Ptr _frame;
 };
 
@@ -70,9 +71,23 @@ public:
      */
     bool inputFrame(const Frame::Ptr &frame) override;
 
+    /**
+     * 输出合并的au
+     * Output the merged au
+     */
+    void flush() override;
+
 private:
     void outputRtp(const char *data, size_t len, size_t total_len, bool mark, uint64_t stamp);
+    void aggregate(const char *data, size_t len, uint64_t dts, uint32_t max_ms);
 
+private:
+    // 待合并输出的au
+    // The au to be merged and output
+    uint64_t _first_dts = 0;
+    uint64_t _last_dts = 0;
+    std::vector<uint16_t> _au_sizes;
+    std::string _aus;
 };
 
 }//namespace mediakit
@@ -0,0 +1,448 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "AV1.h"
+#include "AV1Rtp.h"
+#include "AV1Rtmp.h"
+#include "Rtsp/Rtsp.h"
+#include "Util/util.h"
+#include "Extension/Factory.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+size_t readLeb128(const uint8_t *ptr, size_t size, uint64_t &value) {
+    value = 0;
+    for (size_t i = 0; i < 8 && i < size; ++i) {
+        value |= (uint64_t)(ptr[i] & 0x7f) << (i * 7);
+        if (!(ptr[i] & 0x80)) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+void writeLeb128(string &out, uint64_t value) {
+    do {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        out.push_back((char)(value ? (byte | 0x80) : byte));
+    } while (value);
+}
+
+size_t leb128Size(uint64_t value) {
+    size_t ret = 1;
+    while (value >>= 7) {
+        ++ret;
+    }
+    return ret;
+}
+
+bool splitAV1(const uint8_t *ptr, size_t size, const function<bool(uint8_t, const uint8_t *, size_t, const uint8_t *, size_t)> &cb) {
+    auto end = ptr + size;
+    while (ptr < end) {
+        // obu_header: forbidden_bit(1) obu_type(4) obu_extension_flag(1) obu_has_size_field(1) reserved(1)
+        uint8_t type = (ptr[0] >> 3) & 0x0f;
+        size_t header_size = (ptr[0] & 0x04) ? 2 : 1;
+        if ((ptr[0] & 0x80) || ptr + header_size > end) {
+            return false;
+        }
+        uint64_t payload_size = end - ptr - header_size;
+        if (ptr[0] & 0x02) {
+            auto bytes = readLeb128(ptr + header_size, end - ptr - header_size, payload_size);
+            if (!bytes) {
+                return false;
+            }
+            header_size += bytes;
+        }
+        if (payload_size > (uint64_t)(end - ptr - header_size)) {
+            return false;
+        }
+        auto obu_size = header_size + payload_size;
+        if (!cb(type, ptr, obu_size, ptr + header_size, payload_size)) {
+            return true;
+        }
+        ptr += obu_size;
+    }
+    return true;
+}
+
+bool isAV1KeyFrame(const uint8_t *ptr, size_t size) {
+    bool ret = false;
+    splitAV1(ptr, size, [&](uint8_t type, const uint8_t *, size_t, const uint8_t *payload, size_t payload_size) {
+        if (type != OBU_FRAME && type != OBU_FRAME_HEADER) {
+            return true;
+        }
+        // uncompressed_header: show_existing_frame(1) frame_type(2), KEY_FRAME为0
+        // uncompressed_header: show_existing_frame(1) frame_type(2), KEY_FRAME is 0
+        ret = payload_size && !(payload[0] & 0x80) && ((payload[0] >> 5) & 0x03) == 0;
+        return false;
+    });
+    return ret;
+}
+
+bool isAV1ConfigFrame(const uint8_t *ptr, size_t size) {
+    bool have_seq_header = false;
+    bool have_frame = false;
+    splitAV1(ptr, size, [&](uint8_t type, const uint8_t *, size_t, const uint8_t *, size_t) {
+        switch (type) {
+            case OBU_SEQUENCE_HEADER: have_seq_header = true; break;
+            case OBU_FRAME:
+            case OBU_FRAME_HEADER:
+            case OBU_TILE_GROUP: have_frame = true; break;
+            default: break;
+        }
+        return !have_frame;
+    });
+    return have_seq_header && !have_frame;
+}
+
+namespace {
+
+class BitReader {
+public:
+    BitReader(const uint8_t *ptr, size_t size) : _ptr(ptr), _bits(size * 8) {}
+
+    uint32_t read(int n) {
+        uint32_t ret = 0;
+        while (n--) {
+            ret <<= 1;
+            if (_pos < _bits) {
+                ret |= (_ptr[_pos >> 3] >> (7 - (_pos & 7))) & 0x01;
+            }
+            ++_pos;
+        }
+        return ret;
+    }
+
+    uint32_t uvlc() {
+        int leading_zeros = 0;
+        while (!read(1)) {
+            if (++leading_zeros >= 32 || overflow()) {
+                return UINT32_MAX;
+            }
+        }
+        return leading_zeros ? read(leading_zeros) + (1u << leading_zeros) - 1 : 0;
+    }
+
+    bool overflow() const { return _pos > _bits; }
+
+private:
+    const uint8_t *_ptr;
+    size_t _bits;
+    size_t _pos = 0;
+};
+
+} // namespace
+
+bool parseAV1SequenceHeader(const uint8_t *payload, size_t size, AV1SequenceHeader &info) {
+    // 参考av1-spec 5.5 Sequence header OBU syntax
+    // Refer to av1-spec 5.5 Sequence header OBU syntax
+    BitReader bits(payload, size);
+    info = AV1SequenceHeader();
+    info.seq_profile = bits.read(3);
+    bits.read(1); // still_picture
+    auto reduced_still_picture_header = bits.read(1);
+    if (reduced_still_picture_header) {
+        info.seq_level_idx_0 = bits.read(5);
+    } else {
+        uint32_t buffer_delay_length = 0;
+        auto decoder_model_info_present = 0;
+        if (bits.read(1)) {
+            // timing_info
+            auto num_units_in_display_tick = bits.read(32);
+            auto time_scale = bits.read(32);
+            if (bits.read(1)) {
+                // equal_picture_interval
+                auto num_ticks_per_picture = bits.uvlc() + 1ull;
+                if (num_units_in_display_tick && num_ticks_per_picture) {
+                    info.fps = (float)((double)time_scale / num_units_in_display_tick / num_ticks_per_picture);
+                }
+            }
+            decoder_model_info_present = bits.read(1);
+            if (decoder_model_info_present) {
+                buffer_delay_length = bits.read(5) + 1;
+                bits.read(32); // num_units_in_decoding_tick
+                bits.read(10); // buffer_removal_time_length_minus_1, frame_presentation_time_length_minus_1
+            }
+        }
+        auto initial_display_delay_present = bits.read(1);
+        auto operating_points_cnt = bits.read(5) + 1;
+        for (uint32_t i = 0; i < operating_points_cnt; ++i) {
+            bits.read(12); // operating_point_idc
+            auto seq_level_idx = bits.read(5);
+            auto seq_tier = seq_level_idx > 7 ? bits.read(1) : 0;
+            if (i == 0) {
+                info.seq_level_idx_0 = seq_level_idx;
+                info.seq_tier_0 = seq_tier;
+            }
+            if (decoder_model_info_present && bits.read(1)) {
+                // decoder_buffer_delay, encoder_buffer_delay, low_delay_mode_flag
+                bits.read(buffer_delay_length);
+                bits.read(buffer_delay_length);
+                bits.read(1);
+            }
+            if (initial_display_delay_present && bits.read(1)) {
+                bits.read(4); // initial_display_delay_minus_1
+            }
+        }
+    }
+
+    auto frame_width_bits = bits.read(4) + 1;
+    auto frame_height_bits = bits.read(4) + 1;
+    info.width = bits.read(frame_width_bits) + 1;
+    info.height = bits.read(frame_height_bits) + 1;
+
+    if (!reduced_still_picture_header && bits.read(1)) {
+        // frame_id_numbers_present_flag: delta_frame_id_length_minus_2, additional_frame_id_length_minus_1
+        bits.read(7);
+    }
+    bits.read(3); // use_128x128_superblock, enable_filter_intra, enable_intra_edge_filter
+    if (!reduced_still_picture_header) {
+        bits.read(4); // enable_interintra_compound, enable_masked_compound, enable_warped_motion, enable_dual_filter
+        auto enable_order_hint = bits.read(1);
+        if (enable_order_hint) {
+            bits.read(2); // enable_jnt_comp, enable_ref_frame_mvs
+        }
+        auto seq_force_screen_content_tools = bits.read(1) ? 2 : bits.read(1);
+        if (seq_force_screen_content_tools > 0 && !bits.read(1)) {
+            bits.read(1); // seq_force_integer_mv
+        }
+        if (enable_order_hint) {
+            bits.read(3); // order_hint_bits_minus_1
+        }
+    }
+    bits.read(3); // enable_superres, enable_cdef, enable_restoration
+
+    // color_config
+    info.high_bitdepth = bits.read(1);
+    if (info.seq_profile == 2 && info.high_bitdepth) {
+        info.twelve_bit = bits.read(1);
+    }
+    info.mono_chrome = info.seq_profile == 1 ? 0 : bits.read(1);
+    uint32_t color_primaries = 2, transfer_characteristics = 2, matrix_coefficients = 2;
+    if (bits.read(1)) {
+        color_primaries = bits.read(8);
+        transfer_characteristics = bits.read(8);
+        matrix_coefficients = bits.read(8);
+    }
+    if (info.mono_chrome) {
+        info.chroma_subsampling_x = info.chroma_subsampling_y = 1;
+    } else if (color_primaries == 1 /*CP_BT_709*/ && transfer_characteristics == 13 /*TC_SRGB*/ && matrix_coefficients == 0 /*MC_IDENTITY*/) {
+        info.chroma_subsampling_x = info.chroma_subsampling_y = 0;
+    } else {
+        bits.read(1); // color_range
+        if (info.seq_profile == 0) {
+            info.chroma_subsampling_x = info.chroma_subsampling_y = 1;
+        } else if (info.seq_profile == 1) {
+            info.chroma_subsampling_x = info.chroma_subsampling_y = 0;
+        } else if (info.twelve_bit) {
+            info.chroma_subsampling_x = bits.read(1);
+            info.chroma_subsampling_y = info.chroma_subsampling_x ? bits.read(1) : 0;
+        } else {
+            info.chroma_subsampling_x = 1;
+            info.chroma_subsampling_y = 0;
+        }
+        if (info.chroma_subsampling_x && info.chroma_subsampling_y) {
+            info.chroma_sample_position = bits.read(2);
+        }
+    }
+    return !bits.overflow();
+}
+
+bool AV1Track::updateSequenceHeader(const uint8_t *obu, size_t obu_size, const uint8_t *payload, size_t payload_size) {
+    if (_seq_header.size() == obu_size && !memcmp(_seq_header.data(), obu, obu_size)) {
+        return true;
+    }
+    AV1SequenceHeader info;
+    if (!parseAV1SequenceHeader(payload, payload_size, info)) {
+        WarnL << "Invalid av1 sequence header: " << hexdump(obu, obu_size);
+        return false;
+    }
+    _info = info;
+    if (obu[0] & 0x02) {
+        _seq_header.assign((char *)obu, obu_size);
+    } else {
+        // 补全obu_size，保证可以直接拼接到时序单元中
+        // Add obu_size so that it can be directly inserted into a temporal unit
+        _seq_header.assign(1, (char)(obu[0] | 0x02));
+        _seq_header.append((char *)obu + 1, payload - obu - 1);
+        writeLeb128(_seq_header, payload_size);
+        _seq_header.append((char *)payload, payload_size);
+    }
+    return true;
+}
+
+bool AV1Track::inputFrame(const Frame::Ptr &frame) {
+    auto ptr = (uint8_t *)frame->data() + frame->prefixSize();
+    auto size = frame->size() - frame->prefixSize();
+    bool have_seq_header = false;
+    splitAV1(ptr, size, [&](uint8_t type, const uint8_t *obu, size_t obu_size, const uint8_t *payload, size_t payload_size) {
+        if (type == OBU_SEQUENCE_HEADER) {
+            have_seq_header = updateSequenceHeader(obu, obu_size, payload, payload_size);
+        }
+        return !have_seq_header;
+    });
+
+    if (!ready()) {
+        return false;
+    }
+    if (have_seq_header || !frame->keyFrame()) {
+        return VideoTrack::inputFrame(frame);
+    }
+
+    // 关键帧前缺少序列头时插入，保证从该关键帧开始可以解码；序列头应紧跟在时序分隔符之后
+    // Insert the sequence header before a key frame lacking it so that decoding can start there; it should follow the temporal delimiter
+    size_t td_size = 0;
+    splitAV1(ptr, size, [&](uint8_t type, const uint8_t *, size_t obu_size, const uint8_t *, size_t) {
+        td_size = type == OBU_TEMPORAL_DELIMITER ? obu_size : 0;
+        return false;
+    });
+    auto merged = FrameImp::create<AV1Frame>();
+    merged->_dts = frame->dts();
+    merged->_pts = frame->pts();
+    merged->setIndex(frame->getIndex());
+    merged->_buffer.reserve(size + _seq_header.size());
+    merged->_buffer.assign((char *)ptr, td_size);
+    merged->_buffer.append(_seq_header);
+    merged->_buffer.append((char *)ptr + td_size, size - td_size);
+    return VideoTrack::inputFrame(merged);
+}
+
+Buffer::Ptr AV1Track::getExtraData() const {
+    CHECK(ready());
+    // AV1CodecConfigurationRecord
+    string extra_data;
+    extra_data.push_back((char)0x81); // marker(1), version(7)
+    extra_data.push_back((char)((_info.seq_profile << 5) | (_info.seq_level_idx_0 & 0x1f)));
+    extra_data.push_back((char)((_info.seq_tier_0 << 7) | (_info.high_bitdepth << 6) | (_info.twelve_bit << 5) | (_info.mono_chrome << 4)
+                                | (_info.chroma_subsampling_x << 3) | (_info.chroma_subsampling_y << 2) | (_info.chroma_sample_position & 0x03)));
+    extra_data.push_back(0); // reserved(3), initial_presentation_delay_present(1), reserved(4)
+    // configOBUs
+    extra_data.append(_seq_header);
+    return std::make_shared<BufferString>(std::move(extra_data));
+}
+
+void AV1Track::setExtraData(const uint8_t *data, size_t size) {
+    if (size < 4 || data[0] != 0x81) {
+        WarnL << "Invalid AV1CodecConfigurationRecord: " << hexdump(data, size);
+        return;
+    }
+    splitAV1(data + 4, size - 4, [&](uint8_t type, const uint8_t *obu, size_t obu_size, const uint8_t *payload, size_t payload_size) {
+        if (type != OBU_SEQUENCE_HEADER) {
+            return true;
+        }
+        updateSequenceHeader(obu, obu_size, payload, payload_size);
+        return false;
+    });
+}
+
+bool AV1Track::update() {
+    if (_seq_header.empty()) {
+        return false;
+    }
+    bool ret = false;
+    splitAV1((uint8_t *)_seq_header.data(), _seq_header.size(), [&](uint8_t, const uint8_t *, size_t, const uint8_t *payload, size_t payload_size) {
+        ret = parseAV1SequenceHeader(payload, payload_size, _info);
+        return false;
+    });
+    return ret;
+}
+
+/**
+ * av1类型sdp
+ * av1 type sdp
+ */
+class AV1Sdp : public Sdp {
+public:
+    /**
+     * 构造函数
+     * @param info 序列头信息，为空时不生成fmtp
+     * @param payload_type rtp payload type
+     * @param bitrate 比特率
+     * Constructor
+     * @param info Sequence header information, fmtp is omitted when empty
+     * @param payload_type rtp payload type
+     * @param bitrate Bitrate
+     */
+    AV1Sdp(const AV1SequenceHeader *info, int payload_type, int bitrate) : Sdp(90000, payload_type) {
+        _printer << "m=video 0 RTP/AVP " << payload_type << "\r\n";
+        if (bitrate) {
+            _printer << "b=AS:" << bitrate << "\r\n";
+        }
+        _printer << "a=rtpmap:" << payload_type << " " << getCodecName(CodecAV1) << "/" << 90000 << "\r\n";
+        if (info) {
+            // 参考RTP Payload Format For AV1 7.2.1
+            // Refer to RTP Payload Format For AV1 7.2.1
+            _printer << "a=fmtp:" << payload_type << " profile=" << (int)info->seq_profile << ";level-idx=" << (int)info->seq_level_idx_0
+                     << ";tier=" << (int)info->seq_tier_0 << "\r\n";
+        }
+    }
+
+    string getSdp() const override { return _printer; }
+
+private:
+    _StrPrinter _printer;
+};
+
+Sdp::Ptr AV1Track::getSdp(uint8_t payload_type) const {
+    return std::make_shared<AV1Sdp>(ready() ? &_info : nullptr, payload_type, getBitRate() >> 10);
+}
+
+namespace {
+
+CodecId getCodec() {
+    return CodecAV1;
+}
+
+Track::Ptr getTrackByCodecId(int sample_rate, int channels, int sample_bit) {
+    return std::make_shared<AV1Track>();
+}
+
+Track::Ptr getTrackBySdp(const SdpTrack::Ptr &track) {
+    // 序列头在后续rtp中恢复
+    // The sequence header is recovered from the subsequent rtp
+    return std::make_shared<AV1Track>();
+}
+
+RtpCodec::Ptr getRtpEncoderByCodecId(uint8_t pt) {
+    return std::make_shared<AV1RtpEncoder>();
+}
+
+RtpCodec::Ptr getRtpDecoderByCodecId() {
+    return std::make_shared<AV1RtpDecoder>();
+}
+
+RtmpCodec::Ptr getRtmpEncoderByTrack(const Track::Ptr &track) {
+    return std::make_shared<AV1RtmpEncoder>(track);
+}
+
+RtmpCodec::Ptr getRtmpDecoderByTrack(const Track::Ptr &track) {
+    return std::make_shared<AV1RtmpDecoder>(track);
+}
+
+Frame::Ptr getFrameFromPtr(const char *data, size_t bytes, uint64_t dts, uint64_t pts) {
+    return std::make_shared<AV1FrameNoCacheAble>((char *)data, bytes, dts, pts, 0);
+}
+
+} // namespace
+
+CodecPlugin av1_plugin = { getCodec,
+                           getTrackByCodecId,
+                           getTrackBySdp,
+                           getRtpEncoderByCodecId,
+                           getRtpDecoderByCodecId,
+                           getRtmpEncoderByTrack,
+                           getRtmpDecoderByTrack,
+                           getFrameFromPtr };
+
+} // namespace mediakit
@@ -0,0 +1,176 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_AV1_H
+#define ZLMEDIAKIT_AV1_H
+
+#include <functional>
+#include "Extension/Frame.h"
+#include "Extension/Track.h"
+
+namespace mediakit {
+
+enum AV1ObuType : uint8_t {
+    OBU_SEQUENCE_HEADER = 1,
+    OBU_TEMPORAL_DELIMITER = 2,
+    OBU_FRAME_HEADER = 3,
+    OBU_TILE_GROUP = 4,
+    OBU_METADATA = 5,
+    OBU_FRAME = 6,
+    OBU_REDUNDANT_FRAME_HEADER = 7,
+    OBU_TILE_LIST = 8,
+    OBU_PADDING = 15,
+};
+
+/**
+ * 读取leb128编码的整数
+ * @return 消耗的字节数，失败返回0
+ * Read a leb128 encoded integer
+ * @return Number of bytes consumed, 0 on failure
+ */
+size_t readLeb128(const uint8_t *ptr, size_t size, uint64_t &value);
+
+/**
+ * 以leb128编码追加整数
+ * Append an integer encoded as leb128
+ */
+void writeLeb128(std::string &out, uint64_t value);
+
+/**
+ * 整数leb128编码后的字节数
+ * Number of bytes of an integer encoded as leb128
+ */
+size_t leb128Size(uint64_t value);
+
+/**
+ * 遍历Low Overhead Bitstream格式(obu_has_size_field为1，最后一个obu可省略obu_size)的obu
+ * @param cb 参数依次为obu类型、obu(含obu头)、obu长度、obu负载、负载长度；返回false时停止遍历
+ * @return 数据是否完整合法
+ * Iterate the obus of a Low Overhead Bitstream (obu_has_size_field is 1, the last obu may omit obu_size)
+ * @param cb Arguments are obu type, obu (including obu header), obu size, obu payload, payload size; return false to stop
+ * @return Whether the data is complete and valid
+ */
+bool splitAV1(const uint8_t *ptr, size_t size,
+              const std::function<bool(uint8_t type, const uint8_t *obu, size_t obu_size, const uint8_t *payload, size_t payload_size)> &cb);
+
+/**
+ * 判断时序单元是否为关键帧(包含frame_type为KEY_FRAME且非show_existing_frame的帧头)
+ * Determine whether a temporal unit is a key frame (contains a frame header with frame_type KEY_FRAME that is not show_existing_frame)
+ */
+bool isAV1KeyFrame(const uint8_t *ptr, size_t size);
+
+/**
+ * 判断时序单元是否只包含序列头等配置obu，不包含帧数据
+ * Determine whether a temporal unit only contains configuration obus such as the sequence header, without frame data
+ */
+bool isAV1ConfigFrame(const uint8_t *ptr, size_t size);
+
+/**
+ * av1帧为一个完整的时序单元(Temporal Unit)，采用Low Overhead Bitstream格式，无前缀
+ * An av1 frame is a complete temporal unit in Low Overhead Bitstream format, without prefix
+ */
+template <typename Parent>
+class AV1FrameHelper : public Parent {
+public:
+    friend class FrameImp;
+    friend class toolkit::ResourcePool_l<AV1FrameHelper>;
+    using Ptr = std::shared_ptr<AV1FrameHelper>;
+
+    template <typename... ARGS>
+    AV1FrameHelper(ARGS &&...args) : Parent(std::forward<ARGS>(args)...) {
+        this->_codec_id = CodecAV1;
+    }
+
+    bool keyFrame() const override {
+        return isAV1KeyFrame((uint8_t *)this->data() + this->prefixSize(), this->size() - this->prefixSize());
+    }
+
+    bool configFrame() const override {
+        return isAV1ConfigFrame((uint8_t *)this->data() + this->prefixSize(), this->size() - this->prefixSize());
+    }
+};
+
+/**
+ * av1帧类
+ * av1 frame class
+ */
+using AV1Frame = AV1FrameHelper<FrameImp>;
+
+/**
+ * 防止内存拷贝的av1帧类
+ * av1 frame class that avoids memory copying
+ */
+using AV1FrameNoCacheAble = AV1FrameHelper<FrameFromPtr>;
+
+/**
+ * av1序列头中转封装需要的信息
+ * Information in the av1 sequence header needed for remuxing
+ */
+struct AV1SequenceHeader {
+    uint8_t seq_profile = 0;
+    uint8_t seq_level_idx_0 = 0;
+    uint8_t seq_tier_0 = 0;
+    uint8_t high_bitdepth = 0;
+    uint8_t twelve_bit = 0;
+    uint8_t mono_chrome = 0;
+    uint8_t chroma_subsampling_x = 0;
+    uint8_t chroma_subsampling_y = 0;
+    uint8_t chroma_sample_position = 0;
+    int width = 0;
+    int height = 0;
+    float fps = 0;
+};
+
+/**
+ * 解析序列头obu负载
+ * Parse the payload of a sequence header obu
+ */
+bool parseAV1SequenceHeader(const uint8_t *payload, size_t size, AV1SequenceHeader &info);
+
+/**
+ * av1视频通道
+ * av1 video channel
+ */
+class AV1Track : public VideoTrack {
+public:
+    using Ptr = std::shared_ptr<AV1Track>;
+
+    AV1Track() = default;
+
+    bool ready() const override { return !_seq_header.empty(); }
+    CodecId getCodecId() const override { return CodecAV1; }
+    int getVideoWidth() const override { return _info.width; }
+    int getVideoHeight() const override { return _info.height; }
+    float getVideoFps() const override { return _info.fps; }
+    bool inputFrame(const Frame::Ptr &frame) override;
+
+    /**
+     * 返回AV1CodecConfigurationRecord(av1C)，用于mp4、enhanced-rtmp
+     * Return AV1CodecConfigurationRecord (av1C), used by mp4 and enhanced-rtmp
+     */
+    toolkit::Buffer::Ptr getExtraData() const override;
+    void setExtraData(const uint8_t *data, size_t size) override;
+    bool update() override;
+
+private:
+    Sdp::Ptr getSdp(uint8_t payload_type) const override;
+    Track::Ptr clone() const override { return std::make_shared<AV1Track>(*this); }
+    bool updateSequenceHeader(const uint8_t *obu, size_t obu_size, const uint8_t *payload, size_t payload_size);
+
+private:
+    AV1SequenceHeader _info;
+    // 完整的序列头obu(含obu头与obu_size)
+    // The complete sequence header obu (including obu header and obu_size)
+    std::string _seq_header;
+};
+
+} // namespace mediakit
+
+#endif // ZLMEDIAKIT_AV1_H
@@ -0,0 +1,98 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "AV1Rtmp.h"
+#include "Rtmp/utils.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+void AV1RtmpDecoder::inputRtmp(const RtmpPacket::Ptr &pkt) {
+    RtmpPacketInfo info;
+    parseVideoRtmpPacket((uint8_t *)pkt->data(), pkt->size(), &info);
+    if (!info.is_enhanced || info.codec != CodecAV1) {
+        throw std::invalid_argument("Invalid enhanced-rtmp av1 packet!");
+    }
+
+    auto data = (uint8_t *)pkt->data() + RtmpPacketInfo::kEnhancedRtmpHeaderSize;
+    auto size = pkt->size() - RtmpPacketInfo::kEnhancedRtmpHeaderSize;
+    switch (info.video.pkt_type) {
+        case RtmpPacketType::PacketTypeSequenceStart: {
+            getTrack()->setExtraData(data, size);
+            break;
+        }
+
+        case RtmpPacketType::PacketTypeCodedFramesX:
+        case RtmpPacketType::PacketTypeCodedFrames: {
+            // av1没有CompositionTime Offset字段
+            // av1 has no CompositionTime Offset field
+            CHECK_RET(size > 1);
+            auto frame = FrameImp::create<AV1Frame>();
+            frame->_dts = pkt->time_stamp;
+            frame->_pts = pkt->time_stamp;
+            frame->_buffer.assign((char *)data, size);
+            RtmpCodec::inputFrame(frame);
+            break;
+        }
+
+        case RtmpPacketType::PacketTypeSequenceEnd: break;
+        default: WarnL << "Unknown pkt_type: " << (int)info.video.pkt_type; break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+bool AV1RtmpEncoder::inputFrame(const Frame::Ptr &frame) {
+    if (frame->configFrame()) {
+        // 序列头已经通过config包发送
+        // The sequence header has already been sent in the config packet
+        return false;
+    }
+    auto pkt = RtmpPacket::create();
+    pkt->buffer.resize(RtmpPacketInfo::kEnhancedRtmpHeaderSize);
+    auto header = (RtmpVideoHeaderEnhanced *)pkt->data();
+    header->enhanced = 1;
+    header->pkt_type = (int)RtmpPacketType::PacketTypeCodedFrames;
+    header->frame_type = frame->keyFrame() ? (int)RtmpFrameType::key_frame : (int)RtmpFrameType::inter_frame;
+    header->fourcc = htonl((uint32_t)RtmpVideoCodec::fourcc_av1);
+    pkt->buffer.append(frame->data() + frame->prefixSize(), frame->size() - frame->prefixSize());
+    pkt->body_size = pkt->buffer.size();
+    pkt->chunk_id = CHUNK_VIDEO;
+    pkt->stream_index = STREAM_MEDIA;
+    pkt->time_stamp = frame->dts();
+    pkt->type_id = MSG_VIDEO;
+    RtmpCodec::inputRtmp(pkt);
+    return true;
+}
+
+void AV1RtmpEncoder::makeConfigPacket() {
+    auto pkt = RtmpPacket::create();
+    pkt->buffer.resize(RtmpPacketInfo::kEnhancedRtmpHeaderSize);
+    auto header = (RtmpVideoHeaderEnhanced *)pkt->data();
+    header->enhanced = 1;
+    header->pkt_type = (int)RtmpPacketType::PacketTypeSequenceStart;
+    header->frame_type = (int)RtmpFrameType::key_frame;
+    header->fourcc = htonl((uint32_t)RtmpVideoCodec::fourcc_av1);
+
+    // AV1CodecConfigurationRecord
+    auto extra_data = getTrack()->getExtraData();
+    CHECK(extra_data);
+    pkt->buffer.append(extra_data->data(), extra_data->size());
+    pkt->body_size = pkt->buffer.size();
+    pkt->chunk_id = CHUNK_VIDEO;
+    pkt->stream_index = STREAM_MEDIA;
+    pkt->time_stamp = 0;
+    pkt->type_id = MSG_VIDEO;
+    RtmpCodec::inputRtmp(pkt);
+}
+
+} // namespace mediakit
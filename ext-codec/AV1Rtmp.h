@@ -0,0 +1,68 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_AV1RTMPCODEC_H
+#define ZLMEDIAKIT_AV1RTMPCODEC_H
+
+#include "AV1.h"
+#include "Rtmp/RtmpCodec.h"
+#include "Extension/Track.h"
+
+namespace mediakit {
+
+/**
+ * av1 Rtmp解码类，只支持增强型rtmp(fourcc为av01)
+ * 将 av1 over rtmp 解复用出 av1-Frame
+ * av1 Rtmp decoder class, only enhanced rtmp (fourcc av01) is supported
+ * Demultiplex av1-Frame from av1 over rtmp
+ */
+class AV1RtmpDecoder : public RtmpCodec {
+public:
+    using Ptr = std::shared_ptr<AV1RtmpDecoder>;
+
+    AV1RtmpDecoder(const Track::Ptr &track) : RtmpCodec(track) {}
+
+    /**
+     * 输入av1 Rtmp包
+     * @param rtmp Rtmp包
+     * Input av1 Rtmp packet
+     * @param rtmp Rtmp packet
+     */
+    void inputRtmp(const RtmpPacket::Ptr &rtmp) override;
+};
+
+/**
+ * av1 Rtmp打包类，始终采用增强型rtmp
+ * av1 Rtmp packaging class, enhanced rtmp is always used
+ */
+class AV1RtmpEncoder : public RtmpCodec {
+public:
+    using Ptr = std::shared_ptr<AV1RtmpEncoder>;
+
+    AV1RtmpEncoder(const Track::Ptr &track) : RtmpCodec(track) {}
+
+    /**
+     * 输入av1帧(时序单元)
+     * @param frame 帧数据
+     * Input av1 frame (temporal unit)
+     * @param frame Frame data
+     */
+    bool inputFrame(const Frame::Ptr &frame) override;
+
+    /**
+     * 生成config包(AV1CodecConfigurationRecord)
+     * Generate config packet (AV1CodecConfigurationRecord)
+     */
+    void makeConfigPacket() override;
+};
+
+} // namespace mediakit
+
+#endif // ZLMEDIAKIT_AV1RTMPCODEC_H
@@ -0,0 +1,265 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "AV1Rtp.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+/*
+ * RTP Payload Format For AV1 4.4 AV1 Aggregation Header
+ *  0 1 2 3 4 5 6 7
+ * +-+-+-+-+-+-+-+-+
+ * |Z|Y| W |N|-|-|-|
+ * +-+-+-+-+-+-+-+-+
+ * Z: 第一个obu元素是上个包最后一个obu的后续分片
+ * Y: 最后一个obu元素在下个包中继续
+ * W: obu元素个数，为0时每个元素都带leb128长度，否则最后一个元素省略长度
+ * N: 该包是新的编码视频序列的第一个包
+ * Z: The first obu element is the continuation of the last obu of the previous packet
+ * Y: The last obu element continues in the next packet
+ * W: Number of obu elements; when 0 every element has a leb128 length, otherwise the last element omits it
+ * N: The packet is the first packet of a new coded video sequence
+ */
+static constexpr uint8_t kAggregationZ = 0x80;
+static constexpr uint8_t kAggregationY = 0x40;
+static constexpr uint8_t kAggregationN = 0x08;
+
+static inline uint8_t obuType(uint8_t header) {
+    return (header >> 3) & 0x0f;
+}
+
+AV1RtpDecoder::AV1RtpDecoder() {
+    _frame = obtainFrame();
+}
+
+AV1Frame::Ptr AV1RtpDecoder::obtainFrame() {
+    return FrameImp::create<AV1Frame>();
+}
+
+void AV1RtpDecoder::resetFrame() {
+    _frame->_buffer.clear();
+    _obu.clear();
+    _fragment = false;
+}
+
+bool AV1RtpDecoder::inputRtp(const RtpPacket::Ptr &rtp, bool key_pos) {
+    auto seq = rtp->getSeq();
+    auto stamp = rtp->getStampMS();
+    auto lost = _last_seq && seq != (uint16_t)(_last_seq + 1);
+    _last_seq = seq;
+
+    auto new_tu = stamp != _stamp || _frame->_buffer.empty();
+    if (stamp != _stamp) {
+        if (!lost && !_tu_dropped && !_frame->_buffer.empty()) {
+            // 未收到mark位，时间戳变化时输出上个时序单元
+            // Mark bit not received, output the previous temporal unit when the timestamp changes
+            outputFrame(rtp);
+        }
+        resetFrame();
+        _stamp = stamp;
+        _tu_dropped = false;
+    }
+    if (lost) {
+        // 无法判断丢失的包属于哪个时序单元，因此都丢弃
+        // It is impossible to tell which temporal unit the lost packets belong to, so both are discarded
+        if (!_gop_dropped) {
+            WarnL << "start drop av1 gop, last seq:" << (uint16_t)(seq - 1) << ", rtp:\r\n" << rtp->dumpString();
+        }
+        _gop_dropped = true;
+        _tu_dropped = true;
+        resetFrame();
+    }
+    if (_tu_dropped) {
+        return false;
+    }
+
+    auto ret = decodeRtp(rtp, new_tu);
+    if (!_tu_dropped && rtp->getHeader()->mark) {
+        outputFrame(rtp);
+        resetFrame();
+    }
+    return ret;
+}
+
+bool AV1RtpDecoder::decodeRtp(const RtpPacket::Ptr &rtp, bool new_tu) {
+    auto size = rtp->getPayloadSize();
+    if (size <= 1) {
+        return false;
+    }
+    auto ptr = rtp->getPayload();
+    auto end = ptr + size;
+    auto aggregation_header = *ptr++;
+    auto w = (aggregation_header >> 4) & 0x03;
+    auto key_pos = false;
+
+    for (int i = 0; ptr < end; ++i) {
+        uint64_t len = end - ptr;
+        if (!w || i < w - 1) {
+            auto bytes = readLeb128(ptr, end - ptr, len);
+            if (!bytes || len > (uint64_t)(end - ptr - bytes)) {
+                WarnL << "invalid av1 obu element size, rtp:\r\n" << rtp->dumpString();
+                _gop_dropped = true;
+                _tu_dropped = true;
+                return false;
+            }
+            ptr += bytes;
+        }
+        auto last = ptr + len >= end;
+        auto continuation = i == 0 && (aggregation_header & kAggregationZ);
+        if (!continuation && _fragment) {
+            WarnL << "av1 obu fragment is not continued, rtp:\r\n" << rtp->dumpString();
+            _obu.clear();
+            _fragment = false;
+        }
+        if (continuation && !_fragment) {
+            // 分片开头已经丢失
+            // The beginning of the fragment has been lost
+            ptr += len;
+            continue;
+        }
+        if (i == 0 && !continuation && new_tu && len && obuType(*ptr) == OBU_SEQUENCE_HEADER) {
+            key_pos = true;
+        }
+        if (last && (aggregation_header & kAggregationY)) {
+            _obu.append((char *)ptr, len);
+            _fragment = true;
+        } else if (_fragment) {
+            _obu.append((char *)ptr, len);
+            appendObu((uint8_t *)_obu.data(), _obu.size());
+            _obu.clear();
+            _fragment = false;
+        } else if (len) {
+            appendObu(ptr, len);
+        }
+        ptr += len;
+    }
+    return key_pos || (new_tu && (aggregation_header & kAggregationN));
+}
+
+void AV1RtpDecoder::appendObu(const uint8_t *ptr, size_t size) {
+    auto header_size = (ptr[0] & 0x04) ? 2u : 1u;
+    if (size < header_size || obuType(ptr[0]) == OBU_TEMPORAL_DELIMITER) {
+        return;
+    }
+    auto &buffer = _frame->_buffer;
+    if (ptr[0] & 0x02) {
+        // 已经携带obu_size
+        // Already carries obu_size
+        buffer.append((char *)ptr, size);
+        return;
+    }
+    // 转换为Low Overhead Bitstream格式
+    // Convert to Low Overhead Bitstream format
+    buffer.push_back((char)(ptr[0] | 0x02));
+    buffer.append((char *)ptr + 1, header_size - 1);
+    string size_field;
+    writeLeb128(size_field, size - header_size);
+    buffer.append(size_field);
+    buffer.append((char *)ptr + header_size, size - header_size);
+}
+
+void AV1RtpDecoder::outputFrame(const RtpPacket::Ptr &rtp) {
+    auto frame = std::move(_frame);
+    _frame = obtainFrame();
+    if (frame->_buffer.empty()) {
+        return;
+    }
+    // 时序单元按解码顺序发送且每个只显示一帧，pts即dts
+    // Temporal units are sent in decoding order and each shows only one frame, so pts equals dts
+    frame->_dts = frame->_pts = _stamp;
+    if (frame->keyFrame() && _gop_dropped) {
+        _gop_dropped = false;
+        InfoL << "new gop received, rtp:\r\n" << rtp->dumpString();
+    }
+    if (!_gop_dropped || frame->configFrame()) {
+        RtpCodec::inputFrame(frame);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+void AV1RtpEncoder::flushPacket(uint64_t pts, bool fragment, bool is_mark, bool gop_pos) {
+    _packet[0] = (char)(_aggregation_header | (fragment ? kAggregationY : 0));
+    RtpCodec::inputRtp(getRtpInfo().makeRtp(TrackVideo, _packet.data(), _packet.size(), is_mark, pts), gop_pos);
+    // 下个包的第一个元素是当前obu的后续分片
+    // The first element of the next packet is the continuation of the current obu
+    _aggregation_header = fragment ? kAggregationZ : 0;
+    _packet.resize(1);
+}
+
+bool AV1RtpEncoder::inputFrame(const Frame::Ptr &frame) {
+    auto ptr = (uint8_t *)frame->data() + frame->prefixSize();
+    auto size = frame->size() - frame->prefixSize();
+    auto pts = frame->pts();
+    auto key = frame->keyFrame();
+    auto max_size = getRtpInfo().getMaxSize();
+    bool have_seq_header = false;
+    splitAV1(ptr, size, [&](uint8_t type, const uint8_t *, size_t, const uint8_t *, size_t) {
+        have_seq_header = type == OBU_SEQUENCE_HEADER;
+        return !have_seq_header;
+    });
+
+    // 关键帧且携带序列头时开始新的编码视频序列
+    // A key frame carrying the sequence header starts a new coded video sequence
+    auto gop_pos = key && have_seq_header;
+    _aggregation_header = gop_pos ? kAggregationN : 0;
+    _packet.assign(1, '\0');
+
+    splitAV1(ptr, size, [&](uint8_t type, const uint8_t *obu, size_t, const uint8_t *payload, size_t payload_size) {
+        switch (type) {
+            case OBU_TEMPORAL_DELIMITER:
+            case OBU_TILE_LIST:
+            case OBU_PADDING: return true;
+            default: break;
+        }
+        // obu元素去掉obu_size
+        // The obu element drops obu_size
+        size_t header_size = (obu[0] & 0x04) ? 2 : 1;
+        uint8_t header[2] = { (uint8_t)(obu[0] & ~0x02), (uint8_t)(header_size == 2 ? obu[1] : 0) };
+        size_t element_size = header_size + payload_size;
+        size_t offset = 0;
+        while (offset < element_size) {
+            auto space = max_size - _packet.size();
+            if (space <= leb128Size(space)) {
+                flushPacket(pts, false, false, gop_pos);
+                gop_pos = false;
+                continue;
+            }
+            auto len = element_size - offset;
+            if (leb128Size(len) + len > space) {
+                len = space - leb128Size(space);
+            }
+            writeLeb128(_packet, len);
+            auto end = offset + len;
+            if (offset < header_size) {
+                auto bytes = std::min(header_size, end) - offset;
+                _packet.append((char *)header + offset, bytes);
+                offset += bytes;
+            }
+            _packet.append((char *)payload + offset - header_size, end - offset);
+            offset = end;
+            if (offset < element_size) {
+                flushPacket(pts, true, false, gop_pos);
+                gop_pos = false;
+            }
+        }
+        return true;
+    });
+
+    if (_packet.size() > 1) {
+        flushPacket(pts, false, true, gop_pos);
+    }
+    return true;
+}
+
+} // namespace mediakit
@@ -0,0 +1,92 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_AV1RTPCODEC_H
+#define ZLMEDIAKIT_AV1RTPCODEC_H
+
+#include "AV1.h"
+#include "Rtsp/RtpCodec.h"
+
+namespace mediakit {
+
+/**
+ * av1 rtp解码类
+ * 将 av1 over rtp 解复用出 av1-Frame(时序单元)
+ * 《RTP Payload Format For AV1》
+ * av1 rtp decoder class
+ * Demultiplex av1-Frame (temporal unit) from av1 over rtp
+ * 《RTP Payload Format For AV1》
+ */
+class AV1RtpDecoder : public RtpCodec {
+public:
+    using Ptr = std::shared_ptr<AV1RtpDecoder>;
+
+    AV1RtpDecoder();
+
+    /**
+     * 输入av1 rtp包
+     * @param rtp rtp包
+     * @param key_pos 此参数忽略之
+     * Input av1 rtp packet
+     * @param rtp rtp packet
+     * @param key_pos This parameter is ignored
+     */
+    bool inputRtp(const RtpPacket::Ptr &rtp, bool key_pos = true) override;
+
+private:
+    bool decodeRtp(const RtpPacket::Ptr &rtp, bool new_tu);
+    void appendObu(const uint8_t *ptr, size_t size);
+    void resetFrame();
+    AV1Frame::Ptr obtainFrame();
+    void outputFrame(const RtpPacket::Ptr &rtp);
+
+private:
+    bool _gop_dropped = false;
+    // 当前时序单元有丢包，直到下个时间戳前的rtp都丢弃
+    // The current temporal unit has lost packets, rtp is discarded until the next timestamp
+    bool _tu_dropped = false;
+    // 上个rtp包最后一个obu未结束(Y为1)
+    // The last obu of the previous rtp packet is not finished (Y is 1)
+    bool _fragment = false;
+    uint16_t _last_seq = 0;
+    uint64_t _stamp = 0;
+    std::string _obu;
+    AV1Frame::Ptr _frame;
+};
+
+/**
+ * av1 rtp打包类
+ * av1 rtp packer class
+ */
+class AV1RtpEncoder : public RtpCodec {
+public:
+    using Ptr = std::shared_ptr<AV1RtpEncoder>;
+
+    /**
+     * 输入av1帧(时序单元)
+     * @param frame 帧数据，必须
+     * Input av1 frame (temporal unit)
+     * @param frame Frame data, required
+     */
+    bool inputFrame(const Frame::Ptr &frame) override;
+
+private:
+    void flushPacket(uint64_t pts, bool fragment, bool is_mark, bool gop_pos);
+
+private:
+    // 待输出rtp负载，首字节为aggregation header
+    // The rtp payload to be output, the first byte is the aggregation header
+    uint8_t _aggregation_header = 0;
+    std::string _packet;
+};
+
+} // namespace mediakit
+
+#endif // ZLMEDIAKIT_AV1RTPCODEC_H
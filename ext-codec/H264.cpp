@@ -12,6 +12,7 @@
 #include "H264Rtmp.h"
 #include "H264Rtp.h"
 #include "SPSParser.h"
+#include "NalScanner.h"
 #include "Util/logger.h"
 #include "Util/base64.h"
 #include "Common/Parser.h"
@@ -50,26 +51,17 @@ bool getAVCInfo(const string &strSps, int &iVideoWidth, int &iVideoHeight, float
     return getAVCInfo(strSps.data(), strSps.size(), iVideoWidth, iVideoHeight, iVideoFps);
 }
 
-static const char *memfind(const char *buf, ssize_t len, const char *subbuf, ssize_t sublen) {
-    for (auto i = 0; i < len - sublen; ++i) {
-        if (memcmp(buf + i, subbuf, sublen) == 0) {
-            return buf + i;
-        }
-    }
-    return NULL;
-}
-
 void splitH264(
     const char *ptr, size_t len, size_t prefix, const std::function<void(const char *, size_t, size_t)> &cb) {
     auto start = ptr + prefix;
     auto end = ptr + len;
     size_t next_prefix;
     while (true) {
-        auto next_start = memfind(start, end - start, "\x00\x00\x01", 3);
+        auto next_start = findNalStartCode(start, end);
         if (next_start) {
             // 找到下一帧  [AUTO-TRANSLATED:7161f54a]
             // Find the next frame
-            if (*(next_start - 1) == 0x00) {
+            if (next_start > start && *(next_start - 1) == 0x00) {
                 // 这个是00 00 00 01开头  [AUTO-TRANSLATED:b0d79e9e]
                 // This starts with 00 00 00 01
                 next_start -= 1;
@@ -152,7 +144,7 @@ bool H264Track::ready() const {
 
 bool H264Track::inputFrame(const Frame::Ptr &frame) {
     using H264FrameInternal = FrameInternal<H264FrameNoCacheAble>;
-    int type = H264_TYPE(frame->data()[frame->prefixSize()]);
+    int type = H264_TYPE(frame->head()[frame->prefixSize()]);
    
     if ((type == H264Frame::NAL_B_P || type == H264Frame::NAL_IDR) && ready()) {
         return inputFrame_l(frame);
@@ -262,7 +254,7 @@ Track::Ptr H264Track::clone() const {
 }
 
 bool H264Track::inputFrame_l(const Frame::Ptr &frame) {
-    int type = H264_TYPE(frame->data()[frame->prefixSize()]);
+    int type = H264_TYPE(frame->head()[frame->prefixSize()]);
     bool ret = true;
     switch (type) {
         case H264Frame::NAL_SPS: {
@@ -43,12 +43,12 @@ public:
     }
 
     bool keyFrame() const override {
-        auto nal_ptr = (uint8_t *) this->data() + this->prefixSize();
+        auto nal_ptr = (uint8_t *) this->head() + this->prefixSize();
         return H264_TYPE(*nal_ptr) == NAL_IDR && decodeAble();
     }
 
     bool configFrame() const override {
-        auto nal_ptr = (uint8_t *) this->data() + this->prefixSize();
+        auto nal_ptr = (uint8_t *) this->head() + this->prefixSize();
         switch (H264_TYPE(*nal_ptr)) {
             case NAL_SPS:
             case NAL_PPS: return true;
@@ -57,7 +57,7 @@ public:
     }
 
     bool dropAble() const override {
-        auto nal_ptr = (uint8_t *) this->data() + this->prefixSize();
+        auto nal_ptr = (uint8_t *) this->head() + this->prefixSize();
         switch (H264_TYPE(*nal_ptr)) {
             case NAL_SEI:
             case NAL_AUD: return true;
@@ -66,7 +66,7 @@ public:
     }
 
     bool decodeAble() const override {
-        auto nal_ptr = (uint8_t *) this->data() + this->prefixSize();
+        auto nal_ptr = (uint8_t *) this->head() + this->prefixSize();
         auto type = H264_TYPE(*nal_ptr);
         // 多slice情况下, first_mb_in_slice 表示其为一帧的开始  [AUTO-TRANSLATED:80e88e88]
         // // In the case of multiple slices, first_mb_in_slice indicates the start of a frame
@@ -82,6 +82,12 @@ public:
  */
 using H264Frame = H264FrameHelper<FrameImp>;
 
+/**
+ * 负载引用rtp包的264帧，rtp解包时使用
+ * 264 frame whose payload references the rtp packets, used when unpacking rtp
+ */
+using H264FrameChain = H264FrameHelper<FrameChain>;
+
 /**
  * 防止内存拷贝的H264类
  * 用户可以通过该类型快速把一个指针无拷贝的包装成Frame类
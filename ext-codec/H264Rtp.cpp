@@ -36,8 +36,11 @@ H264RtpDecoder::H264RtpDecoder() {
     _frame = obtainFrame();
 }
 
-H264Frame::Ptr H264RtpDecoder::obtainFrame() {
-    auto frame = FrameImp::create<H264Frame>();
+H264FrameChain::Ptr H264RtpDecoder::obtainFrame() {
+    // 对象池中的帧已由FrameImp::create()重置track index与编码类型，这里再清空分片，不依赖回收时的onRecycle
+    // The pooled frame has its track index and codec type reset by FrameImp::create(), clear the fragments here as well instead of relying on onRecycle at recycle time
+    auto frame = FrameImp::create<H264FrameChain>();
+    frame->clear();
     frame->_prefix_size = 4;
     return frame;
 }
@@ -91,9 +94,21 @@ Table 1.  Summary of NAL unit types and their payload structures
  * [AUTO-TRANSLATED:57545317]
 */
 
+void H264RtpDecoder::appendPayload(const toolkit::Buffer::Ptr &buf, const uint8_t *ptr, size_t size) {
+    GET_CONFIG(bool, zero_copy, Rtp::kZeroCopy);
+    if (zero_copy) {
+        // 引用rtp包负载，只有消费者需要连续内存时才合并
+        // Reference the rtp payload, merge only when the consumer needs contiguous memory
+        _frame->append(buf, (char *)ptr, size);
+    } else {
+        _frame->_buffer.append((char *)ptr, size);
+    }
+}
+
 bool H264RtpDecoder::singleFrame(const RtpPacket::Ptr &rtp, const uint8_t *ptr, ssize_t size, uint64_t stamp){
+    _frame->clear();
     _frame->_buffer.assign("\x00\x00\x00\x01", 4);
-    _frame->_buffer.append((char *) ptr, size);
+    appendPayload(rtp, ptr, size);
     _frame->_pts = stamp;
     auto key = _frame->keyFrame() || _frame->configFrame();
     outputFrame(rtp, _frame);
@@ -127,6 +142,7 @@ bool H264RtpDecoder::mergeFu(const RtpPacket::Ptr &rtp, const uint8_t *ptr, ssiz
     if (fu->start_bit) {
         // 该帧的第一个rtp包  [AUTO-TRANSLATED:a9581a23]
         // The first rtp packet of this frame
+        _frame->clear();
         _frame->_buffer.assign("\x00\x00\x00\x01", 4);
         _frame->_buffer.push_back(nal_suffix | fu->nal_type);
         _frame->_pts = stamp;
@@ -143,13 +159,18 @@ bool H264RtpDecoder::mergeFu(const RtpPacket::Ptr &rtp, const uint8_t *ptr, ssiz
         // 中间的或末尾的rtp包，其seq必须连续，否则说明rtp丢包，那么该帧不完整，必须得丢弃  [AUTO-TRANSLATED:6953b332]
         // The middle or end rtp packet, its seq must be continuous, otherwise it indicates that the rtp packet is lost, then the frame is incomplete and must be discarded
         _fu_dropped = true;
-        _frame->_buffer.clear();
+        _frame->clear();
         return false;
     }
 
     // 后面追加数据  [AUTO-TRANSLATED:248516e9]
     // Append data
-    _frame->_buffer.append((char *) ptr + 2, size - 2);
+    appendPayload(rtp, ptr + 2, size - 2);
+    if (auto &ref = rtp->getPayloadRef()) {
+        // 零拷贝rtp包(例如进程内直接输入编码器生成的rtp)的分片数据在引用的负载中
+        // The fragment data of the zero copy rtp packet (such as the rtp generated by the encoder and input in process) is in the referenced payload
+        appendPayload(ref, (uint8_t *)ref->data(), ref->size());
+    }
 
     if (!fu->end_bit) {
         // 非末尾包  [AUTO-TRANSLATED:2e43ac3c]
@@ -177,6 +198,11 @@ bool H264RtpDecoder::decodeRtp(const RtpPacket::Ptr &rtp) {
     auto stamp = rtp->getStampMS();
     auto seq = rtp->getSeq();
     int nal = H264_TYPE(frame[0]);
+    if (rtp->getPayloadRef() && nal != 28) {
+        // 零拷贝rtp包只有FU-A的分片数据在引用的负载中，其他类型合并为连续内存后再解析
+        // Only the FU-A fragment data of a zero copy rtp packet is in the referenced payload, other types are parsed after merging into contiguous memory
+        return decodeRtp(RtpPacket::flatten(rtp));
+    }
 
     switch (nal) {
         case 24:
@@ -199,7 +225,7 @@ bool H264RtpDecoder::decodeRtp(const RtpPacket::Ptr &rtp) {
     }
 }
 
-void H264RtpDecoder::outputFrame(const RtpPacket::Ptr &rtp, const H264Frame::Ptr &frame) {
+void H264RtpDecoder::outputFrame(const RtpPacket::Ptr &rtp, const H264FrameChain::Ptr &frame) {
     if (frame->dropAble()) {
         // 不参与dts生成  [AUTO-TRANSLATED:dff3b747]
         // Not involved in dts generation
@@ -228,11 +254,11 @@ void H264RtpEncoder::insertConfigFrame(uint64_t pts){
     }
     // gop缓存从sps开始，sps、pps后面还有时间戳相同的关键帧，所以mark bit为false  [AUTO-TRANSLATED:e8dcff77]
     // The gop cache starts from sps, sps, pps and then there are key frames with the same timestamp, so the mark bit is false
-    packRtp(_sps->data() + _sps->prefixSize(), _sps->size() - _sps->prefixSize(), pts, false, true);
-    packRtp(_pps->data() + _pps->prefixSize(), _pps->size() - _pps->prefixSize(), pts, false, false);
+    packRtp(_sps, _sps->data() + _sps->prefixSize(), _sps->size() - _sps->prefixSize(), pts, false, true);
+    packRtp(_pps, _pps->data() + _pps->prefixSize(), _pps->size() - _pps->prefixSize(), pts, false, false);
 }
 
-void H264RtpEncoder::packRtp(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
+void H264RtpEncoder::packRtp(const Frame::Ptr &frame, const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
     if (len + 3 <= getRtpInfo().getMaxSize()) {
         // 采用STAP-A/Single NAL unit packet per H.264 模式  [AUTO-TRANSLATED:1a719984]
         // Use STAP-A/Single NAL unit packet per H.264 mode
@@ -240,11 +266,11 @@ void H264RtpEncoder::packRtp(const char *ptr, size_t len, uint64_t pts, bool is_
     } else {
         // STAP-A模式打包会大于MTU,所以采用FU-A模式  [AUTO-TRANSLATED:f3923abc]
         // STAP-A mode packaging will be larger than MTU, so FU-A mode is used
-        packRtpFu(ptr, len, pts, is_mark, gop_pos);
+        packRtpFu(frame, ptr, len, pts, is_mark, gop_pos);
     }
 }
 
-void H264RtpEncoder::packRtpFu(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
+void H264RtpEncoder::packRtpFu(const Frame::Ptr &frame, const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
     auto packet_size = getRtpInfo().getMaxSize() - 2;
     if (len <= packet_size + 1) {
         // 小于FU-A打包最小字节长度要求，采用STAP-A/Single NAL unit packet per H.264 模式  [AUTO-TRANSLATED:b83bb4d1]
@@ -260,6 +286,15 @@ void H264RtpEncoder::packRtpFu(const char *ptr, size_t len, uint64_t pts, bool i
     FuFlags *fu_flags = (FuFlags *) (&fu_char_1);
     fu_flags->start_bit = 1;
 
+    GET_CONFIG(bool, zero_copy, Rtp::kZeroCopy);
+    Frame::Ptr owner;
+    if (zero_copy) {
+        // rtp包会引用帧内存，确保该帧可以被缓存
+        // The rtp packet will reference the frame memory, make sure the frame can be cached
+        owner = Frame::getCacheAbleFrame(frame);
+        ptr = owner->data() + (ptr - frame->data());
+    }
+
     size_t offset = 1;
     while (!fu_flags->end_bit) {
         if (!fu_flags->start_bit && len <= offset + packet_size) {
@@ -268,21 +303,30 @@ void H264RtpEncoder::packRtpFu(const char *ptr, size_t len, uint64_t pts, bool i
             fu_flags->end_bit = 1;
         }
 
-        // 传入nullptr先不做payload的内存拷贝  [AUTO-TRANSLATED:1858cf77]
-        // Pass in nullptr first, do not copy the payload memory
-        auto rtp = getRtpInfo().makeRtp(TrackVideo, nullptr, packet_size + 2, fu_flags->end_bit && is_mark, pts);
-        // rtp payload 负载部分  [AUTO-TRANSLATED:aecf73cc]
-        // rtp payload load part
-        uint8_t *payload = rtp->getPayload();
-        // FU-A 第1个字节  [AUTO-TRANSLATED:b5558495]
-        // FU-A first byte
-        payload[0] = fu_char_0;
-        // FU-A 第2个字节  [AUTO-TRANSLATED:6b4540bb]
-        // FU-A second byte
-        payload[1] = fu_char_1;
-        // H264 数据  [AUTO-TRANSLATED:79204239]
-        // H264 data
-        memcpy(payload + 2, (uint8_t *) ptr + offset, packet_size);
+        RtpPacket::Ptr rtp;
+        if (owner) {
+            // FU头拷贝，H264数据引用帧内存
+            // Copy the FU header, reference the frame memory for H264 data
+            uint8_t fu_head[2] = { (uint8_t)fu_char_0, (uint8_t)fu_char_1 };
+            auto ref = std::make_shared<toolkit::BufferOffset<toolkit::Buffer::Ptr> >(owner, ptr + offset - owner->data(), packet_size);
+            rtp = getRtpInfo().makeRtp(TrackVideo, fu_head, 2, std::move(ref), fu_flags->end_bit && is_mark, pts);
+        } else {
+            // 传入nullptr先不做payload的内存拷贝  [AUTO-TRANSLATED:1858cf77]
+            // Pass in nullptr first, do not copy the payload memory
+            rtp = getRtpInfo().makeRtp(TrackVideo, nullptr, packet_size + 2, fu_flags->end_bit && is_mark, pts);
+            // rtp payload 负载部分  [AUTO-TRANSLATED:aecf73cc]
+            // rtp payload load part
+            uint8_t *payload = rtp->getPayload();
+            // FU-A 第1个字节  [AUTO-TRANSLATED:b5558495]
+            // FU-A first byte
+            payload[0] = fu_char_0;
+            // FU-A 第2个字节  [AUTO-TRANSLATED:6b4540bb]
+            // FU-A second byte
+            payload[1] = fu_char_1;
+            // H264 数据  [AUTO-TRANSLATED:79204239]
+            // H264 data
+            memcpy(payload + 2, (uint8_t *) ptr + offset, packet_size);
+        }
         // 输入到rtp环形缓存  [AUTO-TRANSLATED:5208ef90]
         // Input to the rtp ring buffer
         RtpCodec::inputRtp(rtp, gop_pos);
@@ -367,7 +411,7 @@ bool H264RtpEncoder::inputFrame_l(const Frame::Ptr &frame, bool is_mark){
         // Ensure that there are SPS and PPS before each key frame
         insertConfigFrame(frame->pts());
     }
-    packRtp(frame->data() + frame->prefixSize(), frame->size() - frame->prefixSize(), frame->pts(), is_mark, false);
+    packRtp(frame, frame->data() + frame->prefixSize(), frame->size() - frame->prefixSize(), frame->pts(), is_mark, false);
     return true;
 }
 
@@ -51,16 +51,18 @@ private:
     bool unpackStapA(const RtpPacket::Ptr &rtp, const uint8_t *ptr, ssize_t size, uint64_t stamp);
     bool mergeFu(const RtpPacket::Ptr &rtp, const uint8_t *ptr, ssize_t size, uint64_t stamp, uint16_t seq);
 
+    void appendPayload(const toolkit::Buffer::Ptr &buf, const uint8_t *ptr, size_t size);
+
     bool decodeRtp(const RtpPacket::Ptr &rtp);
-    H264Frame::Ptr obtainFrame();
-    void outputFrame(const RtpPacket::Ptr &rtp, const H264Frame::Ptr &frame);
+    H264FrameChain::Ptr obtainFrame();
+    void outputFrame(const RtpPacket::Ptr &rtp, const H264FrameChain::Ptr &frame);
 
 private:
     bool _is_gop = false;
     bool _gop_dropped = false;
     bool _fu_dropped = true;
     uint16_t _last_seq = 0;
-    H264Frame::Ptr _frame;
+    H264FrameChain::Ptr _frame;
     DtsGenerator _dts_generator;
 };
 
@@ -96,8 +98,8 @@ public:
 private:
     void insertConfigFrame(uint64_t pts);
     bool inputFrame_l(const Frame::Ptr &frame, bool is_mark);
-    void packRtp(const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
-    void packRtpFu(const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
+    void packRtp(const Frame::Ptr &frame, const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
+    void packRtpFu(const Frame::Ptr &frame, const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
     void packRtpStapA(const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
     void packRtpSingleNalu(const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
     void packRtpSmallFrame(const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
@@ -90,7 +90,7 @@ bool H265Track::ready() const {
 }
 
 bool H265Track::inputFrame(const Frame::Ptr &frame) {
-    int type = H265_TYPE(frame->data()[frame->prefixSize()]);
+    int type = H265_TYPE(frame->head()[frame->prefixSize()]);
     if (!frame->configFrame() && type != H265Frame::NAL_SEI_PREFIX && ready()) {
         return inputFrame_l(frame);
     }
@@ -106,7 +106,7 @@ bool H265Track::inputFrame(const Frame::Ptr &frame) {
 }
 
 bool H265Track::inputFrame_l(const Frame::Ptr &frame) {
-    int type = H265_TYPE(frame->data()[frame->prefixSize()]);
+    int type = H265_TYPE(frame->head()[frame->prefixSize()]);
     bool ret = true;
     switch (type) {
         case H265Frame::NAL_VPS: {
@@ -63,7 +63,7 @@ public:
     }
 
     bool keyFrame() const override {
-        auto nal_ptr = (uint8_t *) this->data() + this->prefixSize();
+        auto nal_ptr = (uint8_t *) this->head() + this->prefixSize();
         auto type = H265_TYPE(*nal_ptr);
         // 参考自FFmpeg: IRAP VCL NAL unit types span the range  [AUTO-TRANSLATED:45413c06]
         // Referenced from FFmpeg: IRAP VCL NAL unit types span the range
@@ -72,7 +72,7 @@ public:
     }
 
     bool configFrame() const override {
-        auto nal_ptr = (uint8_t *) this->data() + this->prefixSize();
+        auto nal_ptr = (uint8_t *) this->head() + this->prefixSize();
         switch (H265_TYPE(*nal_ptr)) {
             case NAL_VPS:
             case NAL_SPS:
@@ -82,7 +82,7 @@ public:
     }
 
     bool dropAble() const override {
-        auto nal_ptr = (uint8_t *) this->data() + this->prefixSize();
+        auto nal_ptr = (uint8_t *) this->head() + this->prefixSize();
         switch (H265_TYPE(*nal_ptr)) {
             case NAL_AUD:
             case NAL_SEI_SUFFIX:
@@ -92,7 +92,7 @@ public:
     }
 
     bool decodeAble() const override {
-        auto nal_ptr = (uint8_t *) this->data() + this->prefixSize();
+        auto nal_ptr = (uint8_t *) this->head() + this->prefixSize();
         auto type = H265_TYPE(*nal_ptr);
         // 多slice情况下, first_slice_segment_in_pic_flag 表示其为一帧的开始  [AUTO-TRANSLATED:0427551b]
         // In the case of multiple slices, first_slice_segment_in_pic_flag indicates the beginning of a frame
@@ -108,6 +108,12 @@ public:
  */
 using H265Frame = H265FrameHelper<FrameImp>;
 
+/**
+ * 负载引用rtp包的265帧，rtp解包时使用
+ * 265 frame whose payload references the rtp packets, used when unpacking rtp
+ */
+using H265FrameChain = H265FrameHelper<FrameChain>;
+
 /**
  * 防止内存拷贝的H265类
  * 用户可以通过该类型快速把一个指针无拷贝的包装成Frame类
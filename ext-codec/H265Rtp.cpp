@@ -31,8 +31,11 @@ H265RtpDecoder::H265RtpDecoder() {
     _frame = obtainFrame();
 }
 
-H265Frame::Ptr H265RtpDecoder::obtainFrame() {
-    auto frame = FrameImp::create<H265Frame>();
+H265FrameChain::Ptr H265RtpDecoder::obtainFrame() {
+    // 对象池中的帧已由FrameImp::create()重置track index与编码类型，这里再清空分片，不依赖回收时的onRecycle
+    // The pooled frame has its track index and codec type reset by FrameImp::create(), clear the fragments here as well instead of relying on onRecycle at recycle time
+    auto frame = FrameImp::create<H265FrameChain>();
+    frame->clear();
     frame->_prefix_size = 4;
     return frame;
 }
@@ -122,13 +125,17 @@ bool H265RtpDecoder::unpackAp(const RtpPacket::Ptr &rtp, const uint8_t *ptr, ssi
 */
 
 bool H265RtpDecoder::mergeFu(const RtpPacket::Ptr &rtp, const uint8_t *ptr, ssize_t size, uint64_t stamp, uint16_t seq){
-    CHECK_SIZE(size, 4, false);
+    auto &ref = rtp->getPayloadRef();
+    auto ref_size = ref ? (ssize_t)ref->size() : 0;
+    CHECK_SIZE(size + ref_size, 4, false);
+    CHECK_SIZE(size, 3, false);
     auto s_bit = ptr[2] >> 7;
     auto e_bit = (ptr[2] >> 6) & 0x01;
     auto type = ptr[2] & 0x3f;
     if (s_bit) {
         // 该帧的第一个rtp包  [AUTO-TRANSLATED:a9581a23]
         // The first rtp packet of this frame
+        _frame->clear();
         _frame->_buffer.assign("\x00\x00\x00\x01", 4);
         _frame->_buffer.push_back((type << 1) | (ptr[0] & 0x81));
         _frame->_buffer.push_back(ptr[1]);
@@ -146,7 +153,7 @@ bool H265RtpDecoder::mergeFu(const RtpPacket::Ptr &rtp, const uint8_t *ptr, ssiz
         // 中间的或末尾的rtp包，其seq必须连续，否则说明rtp丢包，那么该帧不完整，必须得丢弃  [AUTO-TRANSLATED:6953b332]
         // The middle or end rtp packet, its seq must be continuous, otherwise it means rtp packet loss, then this frame is incomplete and must be discarded
         _fu_dropped = true;
-        _frame->_buffer.clear();
+        _frame->clear();
         return false;
     }
 
@@ -163,11 +170,16 @@ bool H265RtpDecoder::mergeFu(const RtpPacket::Ptr &rtp, const uint8_t *ptr, ssiz
         ptr += 2;
     }
 
-    CHECK_SIZE(size, 1, false);
+    CHECK_SIZE(size + ref_size, 1, false);
 
     // 后面追加数据  [AUTO-TRANSLATED:248516e9]
     // Append data later
-    _frame->_buffer.append((char *) ptr, size);
+    appendPayload(rtp, ptr, size);
+    if (ref) {
+        // 零拷贝rtp包(例如进程内直接输入编码器生成的rtp)的分片数据在引用的负载中
+        // The fragment data of the zero copy rtp packet (such as the rtp generated by the encoder and input in process) is in the referenced payload
+        appendPayload(ref, (uint8_t *)ref->data(), ref->size());
+    }
 
     if (!e_bit) {
         // 非末尾包  [AUTO-TRANSLATED:2e43ac3c]
@@ -209,6 +221,11 @@ bool H265RtpDecoder::decodeRtp(const RtpPacket::Ptr &rtp) {
     auto stamp = rtp->getStampMS();
     auto seq = rtp->getSeq();
     int nal = H265_TYPE(frame[0]);
+    if (rtp->getPayloadRef() && (nal != 49 || _using_donl_field)) {
+        // 零拷贝rtp包只有FU的分片数据在引用的负载中，其他类型合并为连续内存后再解析
+        // Only the FU fragment data of a zero copy rtp packet is in the referenced payload, other types are parsed after merging into contiguous memory
+        return decodeRtp(RtpPacket::flatten(rtp));
+    }
 
     switch (nal) {
         case 48:
@@ -231,16 +248,28 @@ bool H265RtpDecoder::decodeRtp(const RtpPacket::Ptr &rtp) {
     }
 }
 
+void H265RtpDecoder::appendPayload(const toolkit::Buffer::Ptr &buf, const uint8_t *ptr, size_t size) {
+    GET_CONFIG(bool, zero_copy, Rtp::kZeroCopy);
+    if (zero_copy) {
+        // 引用rtp包负载，只有消费者需要连续内存时才合并
+        // Reference the rtp payload, merge only when the consumer needs contiguous memory
+        _frame->append(buf, (char *)ptr, size);
+    } else {
+        _frame->_buffer.append((char *)ptr, size);
+    }
+}
+
 bool H265RtpDecoder::singleFrame(const RtpPacket::Ptr &rtp, const uint8_t *ptr, ssize_t size, uint64_t stamp){
+    _frame->clear();
     _frame->_buffer.assign("\x00\x00\x00\x01", 4);
-    _frame->_buffer.append((char *) ptr, size);
+    appendPayload(rtp, ptr, size);
     _frame->_pts = stamp;
     auto key = _frame->keyFrame() || _frame->configFrame();
     outputFrame(rtp, _frame);
     return key;
 }
 
-void H265RtpDecoder::outputFrame(const RtpPacket::Ptr &rtp, const H265Frame::Ptr &frame) {
+void H265RtpDecoder::outputFrame(const RtpPacket::Ptr &rtp, const H265FrameChain::Ptr &frame) {
     if (frame->dropAble()) {
         // 不参与dts生成  [AUTO-TRANSLATED:dff3b747]
         // Not involved in dts generation
@@ -263,13 +292,23 @@ void H265RtpDecoder::outputFrame(const RtpPacket::Ptr &rtp, const H265Frame::Ptr
 
 ////////////////////////////////////////////////////////////////////////
 
-void H265RtpEncoder::packRtpFu(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
+void H265RtpEncoder::packRtpFu(const Frame::Ptr &frame, const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
     auto max_size = getRtpInfo().getMaxSize() - 3;
     auto nal_type = H265_TYPE(ptr[0]); //获取NALU的5bit 帧类型
     unsigned char s_e_flags;
     bool fu_start = true;
     bool mark_bit = false;
     size_t offset = 2;
+
+    GET_CONFIG(bool, zero_copy, Rtp::kZeroCopy);
+    Frame::Ptr owner;
+    if (zero_copy) {
+        // rtp包会引用帧内存，确保该帧可以被缓存
+        // The rtp packet will reference the frame memory, make sure the frame can be cached
+        owner = Frame::getCacheAbleFrame(frame);
+        ptr = owner->data() + (ptr - frame->data());
+    }
+
     while (!mark_bit) {
         if (len <= offset + max_size) {
             // FU end
@@ -285,24 +324,33 @@ void H265RtpEncoder::packRtpFu(const char *ptr, size_t len, uint64_t pts, bool i
         }
 
         {
-            // 传入nullptr先不做payload的内存拷贝  [AUTO-TRANSLATED:7ed49f0a]
-            // Pass in nullptr first, do not copy the payload memory
-            auto rtp = getRtpInfo().makeRtp(TrackVideo, nullptr, max_size + 3, mark_bit, pts);
-            // rtp payload 负载部分  [AUTO-TRANSLATED:03a5ef9b]
-            // rtp payload load part
-            uint8_t *payload = rtp->getPayload();
-            // FU 第1个字节，表明为FU  [AUTO-TRANSLATED:9cf07fda]
-            // FU first byte, indicating FU
-            payload[0] = 49 << 1;
-            // FU 第2个字节貌似固定为1  [AUTO-TRANSLATED:77983091]
-            // FU second byte seems to be fixed to 1
-            payload[1] = ptr[1]; // 1;
-            // FU 第3个字节  [AUTO-TRANSLATED:c627abd0]
-            // FU third byte
-            payload[2] = s_e_flags;
-            // H265 数据  [AUTO-TRANSLATED:a2c3135f]
-            // H265 data
-            memcpy(payload + 3, ptr + offset, max_size);
+            RtpPacket::Ptr rtp;
+            if (owner) {
+                // FU头拷贝，H265数据引用帧内存
+                // Copy the FU header, reference the frame memory for H265 data
+                uint8_t fu_head[3] = { 49 << 1, (uint8_t)ptr[1], s_e_flags };
+                auto ref = std::make_shared<toolkit::BufferOffset<toolkit::Buffer::Ptr> >(owner, ptr + offset - owner->data(), max_size);
+                rtp = getRtpInfo().makeRtp(TrackVideo, fu_head, 3, std::move(ref), mark_bit, pts);
+            } else {
+                // 传入nullptr先不做payload的内存拷贝  [AUTO-TRANSLATED:7ed49f0a]
+                // Pass in nullptr first, do not copy the payload memory
+                rtp = getRtpInfo().makeRtp(TrackVideo, nullptr, max_size + 3, mark_bit, pts);
+                // rtp payload 负载部分  [AUTO-TRANSLATED:03a5ef9b]
+                // rtp payload load part
+                uint8_t *payload = rtp->getPayload();
+                // FU 第1个字节，表明为FU  [AUTO-TRANSLATED:9cf07fda]
+                // FU first byte, indicating FU
+                payload[0] = 49 << 1;
+                // FU 第2个字节貌似固定为1  [AUTO-TRANSLATED:77983091]
+                // FU second byte seems to be fixed to 1
+                payload[1] = ptr[1]; // 1;
+                // FU 第3个字节  [AUTO-TRANSLATED:c627abd0]
+                // FU third byte
+                payload[2] = s_e_flags;
+                // H265 数据  [AUTO-TRANSLATED:a2c3135f]
+                // H265 data
+                memcpy(payload + 3, ptr + offset, max_size);
+            }
             // 输入到rtp环形缓存  [AUTO-TRANSLATED:6bafd42b]
             // Input to rtp ring buffer
             RtpCodec::inputRtp(rtp, fu_start && gop_pos);
@@ -313,14 +361,79 @@ void H265RtpEncoder::packRtpFu(const char *ptr, size_t len, uint64_t pts, bool i
     }
 }
 
-void H265RtpEncoder::packRtp(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
+void H265RtpEncoder::packRtpAp(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos) {
+    if (_ap_nal_count && (_ap_pts != pts || _ap.size() + 2 + len > getRtpInfo().getMaxSize())) {
+        // 时间戳不同或合并后超过mtu，先输出之前合并的nal
+        // The timestamp is different or the merged size exceeds the mtu, output the previously merged nal first
+        flushAp(false);
+    }
+    if (!_ap_nal_count) {
+        // PayloadHdr在输出时填写
+        // PayloadHdr is filled in when outputting
+        _ap.assign(2, '\0');
+        _ap_pts = pts;
+        _ap_gop_pos = gop_pos;
+    }
+    _ap.push_back((char)(len >> 8));
+    _ap.push_back((char)(len & 0xFF));
+    _ap.append(ptr, len);
+    ++_ap_nal_count;
+    if (is_mark) {
+        // 该帧最后一个nal，立即输出
+        // The last nal of this frame, output immediately
+        flushAp(true);
+    }
+}
+
+void H265RtpEncoder::flushAp(bool is_mark) {
+    if (!_ap_nal_count) {
+        return;
+    }
+    if (_ap_nal_count == 1) {
+        // 只有一个nal时不需要AP，跳过PayloadHdr与nal长度
+        // No AP is needed for only one nal, skip PayloadHdr and nal size
+        RtpCodec::inputRtp(getRtpInfo().makeRtp(TrackVideo, _ap.data() + 4, _ap.size() - 4, is_mark, _ap_pts), _ap_gop_pos);
+    } else {
+        // rfc7798 4.4.2: F为所有nal F位的或，LayerId与TID取所有nal中的最小值
+        // rfc7798 4.4.2: F is the OR of the F bits of all nal, LayerId and TID take the minimum of all nal
+        uint8_t f = 0, layer_id = 0x3F, tid = 0x07;
+        auto ptr = (uint8_t *)_ap.data() + 2;
+        auto end = (uint8_t *)_ap.data() + _ap.size();
+        while (ptr + 2 < end) {
+            size_t nal_size = (ptr[0] << 8) | ptr[1];
+            auto nal = ptr + 2;
+            f |= nal[0] & 0x80;
+            layer_id = MIN(layer_id, ((nal[0] & 0x01) << 5) | (nal[1] >> 3));
+            tid = MIN(tid, nal[1] & 0x07);
+            ptr = nal + nal_size;
+        }
+        _ap[0] = f | (48 << 1) | (layer_id >> 5);
+        _ap[1] = ((layer_id & 0x1F) << 3) | tid;
+        RtpCodec::inputRtp(getRtpInfo().makeRtp(TrackVideo, _ap.data(), _ap.size(), is_mark, _ap_pts), _ap_gop_pos);
+    }
+    _ap_nal_count = 0;
+    _ap.clear();
+}
+
+void H265RtpEncoder::packRtp(const Frame::Ptr &frame, const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
+    GET_CONFIG(size_t, ap_size, Rtp::kH265ApSize);
+    // AP包需要2字节PayloadHdr，每个nal前有2字节长度
+    // The AP packet requires a 2-byte PayloadHdr, and each nal is preceded by a 2-byte size
+    if (ap_size && len >= 2 && len <= ap_size && len + 4 <= getRtpInfo().getMaxSize()) {
+        packRtpAp(ptr, len, pts, is_mark, gop_pos);
+        return;
+    }
+    // 先输出之前合并的小nal，保证rtp包顺序与nal顺序一致
+    // Output the previously merged small nal first to ensure that the rtp packet order is consistent with the nal order
+    flushAp(false);
+
     if (len <= getRtpInfo().getMaxSize()) {
         //signal-nalu 
         RtpCodec::inputRtp(getRtpInfo().makeRtp(TrackVideo, ptr, len, is_mark, pts), gop_pos);
     } else {
         // FU-A模式  [AUTO-TRANSLATED:a273a49c]
         // FU-A mode
-        packRtpFu(ptr, len, pts, is_mark, gop_pos);
+        packRtpFu(frame, ptr, len, pts, is_mark, gop_pos);
     }
 }
 void H265RtpEncoder::insertConfigFrame(uint64_t pts){
@@ -330,9 +443,9 @@ void H265RtpEncoder::insertConfigFrame(uint64_t pts){
     }
     // gop缓存从vps 开始，vps ,sps、pps后面还有时间戳相同的关键帧，所以mark bit为false  [AUTO-TRANSLATED:2534b06f]
     // gop cache starts from vps, vps, sps, pps followed by key frames with the same timestamp, so mark bit is false
-    packRtp(_vps->data() + _vps->prefixSize(), _vps->size() - _vps->prefixSize(), pts, false, true);
-    packRtp(_sps->data() + _sps->prefixSize(), _sps->size() - _sps->prefixSize(), pts, false, false);
-    packRtp(_pps->data() + _pps->prefixSize(), _pps->size() - _pps->prefixSize(), pts, false, false);
+    packRtp(_vps, _vps->data() + _vps->prefixSize(), _vps->size() - _vps->prefixSize(), pts, false, true);
+    packRtp(_sps, _sps->data() + _sps->prefixSize(), _sps->size() - _sps->prefixSize(), pts, false, false);
+    packRtp(_pps, _pps->data() + _pps->prefixSize(), _pps->size() - _pps->prefixSize(), pts, false, false);
     
 }
 bool H265RtpEncoder::inputFrame_l(const Frame::Ptr &frame, bool is_mark){
@@ -341,7 +454,7 @@ bool H265RtpEncoder::inputFrame_l(const Frame::Ptr &frame, bool is_mark){
         // Ensure that there are SPS PPS VPS before each key frame
         insertConfigFrame(frame->pts());
     }
-    packRtp(frame->data() + frame->prefixSize(), frame->size() - frame->prefixSize(), frame->pts(), is_mark, false);
+    packRtp(frame, frame->data() + frame->prefixSize(), frame->size() - frame->prefixSize(), frame->pts(), is_mark, false);
     return true;
 }
 bool H265RtpEncoder::inputFrame(const Frame::Ptr &frame) {
@@ -388,6 +501,7 @@ void H265RtpEncoder::flush() {
         inputFrame_l(_last_frame, true);
         _last_frame = nullptr;
     }
+    flushAp(true);
 }
 
 }//namespace mediakit
@@ -51,9 +51,11 @@ private:
     bool mergeFu(const RtpPacket::Ptr &rtp, const uint8_t *ptr, ssize_t size, uint64_t stamp, uint16_t seq);
     bool singleFrame(const RtpPacket::Ptr &rtp, const uint8_t *ptr, ssize_t size, uint64_t stamp);
 
+    void appendPayload(const toolkit::Buffer::Ptr &buf, const uint8_t *ptr, size_t size);
+
     bool decodeRtp(const RtpPacket::Ptr &rtp);
-    H265Frame::Ptr obtainFrame();
-    void outputFrame(const RtpPacket::Ptr &rtp, const H265Frame::Ptr &frame);
+    H265FrameChain::Ptr obtainFrame();
+    void outputFrame(const RtpPacket::Ptr &rtp, const H265FrameChain::Ptr &frame);
 
 private:
     bool _is_gop = false;
@@ -61,7 +63,7 @@ private:
     bool _gop_dropped = false;
     bool _fu_dropped = true;
     uint16_t _last_seq = 0;
-    H265Frame::Ptr _frame;
+    H265FrameChain::Ptr _frame;
     DtsGenerator _dts_generator;
 };
 
@@ -95,8 +97,10 @@ public:
     void flush() override;
 
 private:
-    void packRtp(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
-    void packRtpFu(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
+    void packRtp(const Frame::Ptr &frame, const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
+    void packRtpFu(const Frame::Ptr &frame, const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
+    void packRtpAp(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
+    void flushAp(bool is_mark);
     void insertConfigFrame(uint64_t pts);
     bool inputFrame_l(const Frame::Ptr &frame, bool is_mark);
 private:
@@ -104,6 +108,13 @@ private:
     Frame::Ptr _pps;
     Frame::Ptr _vps;
     Frame::Ptr _last_frame;
+
+    // 待输出的AP包，包括2字节PayloadHdr与其后的[nal长度, nal]
+    // The AP packet to be output, including the 2-byte PayloadHdr followed by [nal size, nal]
+    bool _ap_gop_pos = false;
+    size_t _ap_nal_count = 0;
+    uint64_t _ap_pts = 0;
+    std::string _ap;
 };
 
 }//namespace mediakit
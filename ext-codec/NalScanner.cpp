@@ -0,0 +1,176 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+#include "NalScanner.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+// x86_64下sse2为基础指令集，avx2需要运行时检测
+// SSE2 is baseline on x86_64, avx2 is detected at runtime
+#define NAL_SCANNER_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define NAL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define NAL_TARGET_AVX2
+#endif
+
+namespace mediakit {
+
+// 查找00 00 third序列，third不能为0
+// Find the 00 00 third sequence, third must not be 0
+using ScanFunc = const uint8_t *(*)(const uint8_t *ptr, const uint8_t *end, uint8_t third);
+
+static const uint8_t *scanScalar(const uint8_t *ptr, const uint8_t *end, uint8_t third) {
+    if (end - ptr < 3) {
+        return nullptr;
+    }
+    // 先用memchr(libc中一般已向量化)定位third字节，再检查其前两个字节是否为0
+    // Locate the third byte with memchr (usually vectorized in libc), then check whether the two bytes before it are 0
+    auto pos = ptr + 2;
+    while (pos < end) {
+        auto hit = (const uint8_t *)memchr(pos, third, end - pos);
+        if (!hit) {
+            return nullptr;
+        }
+        if (hit[-1] == 0 && hit[-2] == 0) {
+            return hit - 2;
+        }
+        pos = hit + 1;
+    }
+    return nullptr;
+}
+
+#if defined(NAL_SCANNER_X86)
+
+static inline unsigned countTrailingZero(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static const uint8_t *scanSSE2(const uint8_t *ptr, const uint8_t *end, uint8_t third) {
+    auto zero = _mm_setzero_si128();
+    auto target = _mm_set1_epi8((char)third);
+    // 一次比较16个起始位置，需要多读2个字节
+    // Compare 16 start positions at a time, 2 extra bytes are read
+    while (end - ptr >= 18) {
+        auto b0 = _mm_loadu_si128((const __m128i *)ptr);
+        auto b1 = _mm_loadu_si128((const __m128i *)(ptr + 1));
+        auto b2 = _mm_loadu_si128((const __m128i *)(ptr + 2));
+        auto hit = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(b0, b1), zero), _mm_cmpeq_epi8(b2, target));
+        auto mask = (uint32_t)_mm_movemask_epi8(hit);
+        if (mask) {
+            return ptr + countTrailingZero(mask);
+        }
+        ptr += 16;
+    }
+    return scanScalar(ptr, end, third);
+}
+
+NAL_TARGET_AVX2 static const uint8_t *scanAVX2(const uint8_t *ptr, const uint8_t *end, uint8_t third) {
+    auto zero = _mm256_setzero_si256();
+    auto target = _mm256_set1_epi8((char)third);
+    while (end - ptr >= 34) {
+        auto b0 = _mm256_loadu_si256((const __m256i *)ptr);
+        auto b1 = _mm256_loadu_si256((const __m256i *)(ptr + 1));
+        auto b2 = _mm256_loadu_si256((const __m256i *)(ptr + 2));
+        auto hit = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_or_si256(b0, b1), zero), _mm256_cmpeq_epi8(b2, target));
+        auto mask = (uint32_t)_mm256_movemask_epi8(hit);
+        if (mask) {
+            return ptr + countTrailingZero(mask);
+        }
+        ptr += 32;
+    }
+    return scanSSE2(ptr, end, third);
+}
+
+static bool cpuSupportAVX2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // 需要cpu支持avx并且系统开启了ymm寄存器保存(osxsave)
+    // Requires avx support and ymm state saving enabled by the os (osxsave)
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 0x06) != 0x06) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // defined(NAL_SCANNER_X86)
+
+struct NalScanner {
+    const char *name;
+    ScanFunc scan;
+};
+
+static const NalScanner &getScanner() {
+    static NalScanner s_scanner = []() -> NalScanner {
+#if defined(NAL_SCANNER_X86)
+        if (cpuSupportAVX2()) {
+            return { "avx2", scanAVX2 };
+        }
+        return { "sse2", scanSSE2 };
+#else
+        return { "scalar", scanScalar };
+#endif
+    }();
+    return s_scanner;
+}
+
+const char *findNalStartCode(const char *ptr, const char *end) {
+    return (const char *)getScanner().scan((const uint8_t *)ptr, (const uint8_t *)end, 0x01);
+}
+
+const char *findEmulationPrevention(const char *ptr, const char *end) {
+    return (const char *)getScanner().scan((const uint8_t *)ptr, (const uint8_t *)end, 0x03);
+}
+
+const char *nalScannerName() {
+    return getScanner().name;
+}
+
+} // namespace mediakit
+
+extern "C" size_t nalRemoveEmulationPrevention(uint8_t *ptr, size_t len) {
+    auto scan = mediakit::getScanner().scan;
+    const uint8_t *end = ptr + len;
+    const uint8_t *src = ptr;
+    auto dst = ptr;
+    while (auto hit = scan(src, end, 0x03)) {
+        // 保留00 00，丢弃03；03之后重新开始计数0字节
+        // Keep 00 00 and drop 03; zero bytes are counted again after the 03
+        auto bytes = (size_t)(hit + 2 - src);
+        memmove(dst, src, bytes);
+        dst += bytes;
+        src = hit + 3;
+    }
+    auto bytes = (size_t)(end - src);
+    memmove(dst, src, bytes);
+    dst += bytes;
+    return (size_t)(dst - ptr);
+}
@@ -0,0 +1,54 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_NALSCANNER_H
+#define ZLMEDIAKIT_NALSCANNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * 原地移除h264/h265 nalu中的防竞争字节(00 00 03中的03)，返回移除后的长度
+ * Remove emulation prevention bytes (the 03 of 00 00 03) of a h264/h265 nalu in place, return the new length
+ */
+size_t nalRemoveEmulationPrevention(uint8_t *ptr, size_t len);
+
+#if defined(__cplusplus)
+} // extern "C"
+
+namespace mediakit {
+
+/**
+ * 查找[ptr, end)中第一个00 00 01起始码，未找到返回nullptr
+ * 运行时根据cpu支持情况选择avx2/sse2/标量实现
+ * Find the first 00 00 01 start code in [ptr, end), return nullptr if not found
+ * The avx2/sse2/scalar implementation is selected at runtime according to the cpu
+ */
+const char *findNalStartCode(const char *ptr, const char *end);
+
+/**
+ * 查找[ptr, end)中第一个00 00 03防竞争序列，未找到返回nullptr
+ * Find the first 00 00 03 emulation prevention sequence in [ptr, end), return nullptr if not found
+ */
+const char *findEmulationPrevention(const char *ptr, const char *end);
+
+/**
+ * 当前使用的实现名称(avx2/sse2/scalar)
+ * Name of the implementation in use (avx2/sse2/scalar)
+ */
+const char *nalScannerName();
+
+} // namespace mediakit
+#endif // defined(__cplusplus)
+#endif // ZLMEDIAKIT_NALSCANNER_H
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <stdint.h> /* for uint32_t, etc */
 #include "SPSParser.h"
+#include "NalScanner.h"
 
 /********************************************
 *define here
@@ -541,10 +542,6 @@ static void *deEmulationPrevention(void *pvBuf)
 {
     T_GetBitContext *ptPtr = NULL;
     T_GetBitContext *ptBufPtr = (T_GetBitContext *)pvBuf;
-    int i = 0, j = 0;
-    uint8_t *pu8TmpPtr = NULL;
-    int tmp_buf_size = 0;
-    int iVal = 0;
 
     if(NULL == ptBufPtr)
     {
@@ -570,24 +567,7 @@ static void *deEmulationPrevention(void *pvBuf)
 
     memcpy(ptPtr->pu8Buf, ptBufPtr->pu8Buf, ptBufPtr->iBufSize);
 
-    pu8TmpPtr = ptPtr->pu8Buf;
-    tmp_buf_size = ptPtr->iBufSize;
-    for(i=0; i<(tmp_buf_size-2); i++)
-    {
-       
-        iVal = (pu8TmpPtr[i]^0x00) + (pu8TmpPtr[i+1]^0x00) + (pu8TmpPtr[i+2]^0x03);
-        if(iVal == 0)
-        {
-      
-            for(j=i+2; j<tmp_buf_size-1; j++)
-            {
-                pu8TmpPtr[j] = pu8TmpPtr[j+1];
-            }
-
-           
-            ptPtr->iBufSize--;
-        }
-    }
+    ptPtr->iBufSize = (int)nalRemoveEmulationPrevention(ptPtr->pu8Buf, ptPtr->iBufSize);
     ptPtr->iTotalBit = ptPtr->iBufSize << 3;
 
     return (void *)ptPtr;
@@ -8,6 +8,7 @@
  * may be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <unordered_map>
 #include "FFmpegSource.h"
 #include "Common/config.h"
 #include "Common/MediaSource.h"
@@ -28,6 +29,8 @@ const string kCmd = FFmpeg_FIELD"cmd";
 const string kLog = FFmpeg_FIELD"log";
 const string kSnap = FFmpeg_FIELD"snap";
 const string kRestartSec = FFmpeg_FIELD"restart_sec";
+const string kSnapFromGop = FFmpeg_FIELD"snap_from_gop";
+const string kSnapCacheMS = FFmpeg_FIELD"snap_cache_ms";
 
 onceToken token([]() {
 #ifdef _WIN32
@@ -44,6 +47,8 @@ onceToken token([]() {
     mINI::Instance()[kCmd] = "%s -re -i %s -c:a aac -strict -2 -ar 44100 -ab 48k -c:v libx264 -f flv %s";
     mINI::Instance()[kSnap] = "%s -i %s -y -f mjpeg -frames:v 1 -an %s";
     mINI::Instance()[kRestartSec] = 0;
+    mINI::Instance()[kSnapFromGop] = 1;
+    mINI::Instance()[kSnapCacheMS] = 1000;
 });
 }
 
@@ -55,7 +60,7 @@ FFmpegSource::~FFmpegSource() {
     DebugL;
 }
 
-static bool is_local_ip(const string &ip){
+bool is_local_ip(const string &ip){
     if (ip == "127.0.0.1" || ip == "localhost") {
         return true;
     }
@@ -356,8 +361,371 @@ void FFmpegSource::onGetMediaSource(const MediaSource::Ptr &src) {
 #if defined(ENABLE_FFMPEG)
 #include "Player/MediaPlayer.h"
 #include "Codec/Transcode.h"
+#include "Codec/DecoderBus.h"
+
+static bool makeSnapByDecoderBus(const string &play_url, const string &save_path, float timeout_sec, const FFmpegSnap::onSnap &cb) {
+    MediaInfo info;
+    try {
+        info.parse(play_url);
+    } catch (std::exception &) {
+        return false;
+    }
+    if (!is_local_ip(info.host)) {
+        return false;
+    }
+
+    struct Holder {
+        std::mutex mtx;
+        bool done = false;
+        std::shared_ptr<void> subscriber;
+    };
+    auto holder = std::make_shared<Holder>();
+    // 只有第一次调用返回true，同时取消订阅
+    // Only the first call returns true, and unsubscribes at the same time
+    auto finish = [holder]() {
+        std::lock_guard<std::mutex> lck(holder->mtx);
+        if (holder->done) {
+            return false;
+        }
+        holder->done = true;
+        holder->subscriber = nullptr;
+        return true;
+    };
+    auto timer = EventPollerPool::Instance().getPoller()->doDelayTask(1000 * timeout_sec, [finish, cb]() {
+        if (finish()) {
+            cb(false, "decode frame timeout");
+        }
+        return 0;
+    });
+    // 本机的流直接订阅解码总线，已有拼接屏等在解码时无需再次拉流解码
+    // The local stream directly subscribes to the decoder bus, no need to pull and decode again when a video stack is already decoding it
+    auto subscriber = DecoderBus::subscribe(info, [finish, timer, save_path, cb](const FFmpegFrame::Ptr &frame) {
+        if (!finish()) {
+            return;
+        }
+        timer->cancel();
+        auto ret = FFmpegUtils::saveFrame(frame, save_path.data());
+        cb(std::get<0>(ret), std::get<1>(ret));
+    }, [finish, timer, cb]() {
+        if (finish()) {
+            timer->cancel();
+            cb(false, "stream unregistered");
+        }
+    });
+    if (!subscriber) {
+        timer->cancel();
+        return false;
+    }
+    std::lock_guard<std::mutex> lck(holder->mtx);
+    if (!holder->done) {
+        holder->subscriber = std::move(subscriber);
+    }
+    return true;
+}
+
+/**
+ * 进程内截图，取本机流gop缓存中最近的关键帧解码并编码为jpeg，无需启动ffmpeg进程再次拉流
+ * 同一路流的并发请求合并为一次解码，关键帧未变化或在snap_cache_ms内时直接返回缓存的图片
+ * In-process snapshot, decode the latest key frame in the gop cache of the local stream and encode it as jpeg,
+ * no need to start an ffmpeg process to pull the stream again
+ * Concurrent requests of the same stream are merged into one decoding,
+ * the cached picture is returned directly when the key frame has not changed or within snap_cache_ms
+ */
+class GopSnapEngine {
+public:
+    using onFallback = std::function<void()>;
+
+    static GopSnapEngine &Instance();
+
+    /**
+     * 从gop缓存截图
+     * @param timeout_sec 截图超时时间，gop缓存中没有关键帧时最多等待其一半时间，剩余时间留给fallback
+     * @param fallback 等待关键帧超时或者解码失败时的回调，此时应该使用其他截图方式
+     * @return 不是本机流或者流未就绪时返回false
+     * Snapshot from the gop cache
+     * @param timeout_sec Snapshot timeout, wait at most half of it when there is no key frame in the gop cache, the rest is left for the fallback
+     * @param fallback Callback when waiting for the key frame times out or decoding fails, other snapshot methods should be used then
+     * @return Return false if it is not a local stream or the stream is not ready
+     */
+    bool makeSnap(const string &play_url, const string &save_path, float timeout_sec, const FFmpegSnap::onSnap &cb, onFallback fallback);
+
+private:
+    GopSnapEngine() = default;
+
+    struct Waiter {
+        string save_path;
+        FFmpegSnap::onSnap cb;
+        onFallback fallback;
+    };
+
+    struct Entry {
+        bool pending = false;
+        uint64_t key_stamp = 0;
+        std::shared_ptr<string> image;
+        Ticker ticker;
+        std::vector<Waiter> waiters;
+    };
+
+    // 一次截图任务，任务被丢弃(例如流已注销)时也会通知等待者
+    // One snapshot job, the waiters are also notified when the job is dropped (for example, the stream has been unregistered)
+    struct Job {
+        using Ptr = std::shared_ptr<Job>;
+        string key;
+        bool done = false;
+        // 等待关键帧的最长时间
+        // Maximum time to wait for the key frame
+        uint64_t wait_ms = 0;
+        Ticker ticker;
+        ~Job() {
+            if (!done) {
+                GopSnapEngine::Instance().onResult(key, 0, nullptr, "stream released");
+            }
+        }
+    };
+
+    void snapInOwner(const Job::Ptr &job, const MultiMediaSourceMuxer::Ptr &muxer, const Track::Ptr &track);
+    void onResult(const string &key, uint64_t key_stamp, const std::shared_ptr<string> &image, const string &err);
+    static std::vector<Frame::Ptr> findKeyFrame(const MultiMediaSourceMuxer::RingType::Ptr &ring, int index);
+    static std::shared_ptr<string> decodeKeyFrame(const Track::Ptr &track, const std::vector<Frame::Ptr> &frames, string &err);
+    static void saveImage(const std::shared_ptr<string> &image, const std::vector<Waiter> &waiters);
+
+private:
+    std::mutex _mtx;
+    std::unordered_map<string, Entry> _entries;
+};
+
+INSTANCE_IMP(GopSnapEngine)
+
+bool GopSnapEngine::makeSnap(const string &play_url, const string &save_path, float timeout_sec, const FFmpegSnap::onSnap &cb, onFallback fallback) {
+    GET_CONFIG(bool, snap_from_gop, FFmpeg::kSnapFromGop);
+    GET_CONFIG(uint32_t, snap_cache_ms, FFmpeg::kSnapCacheMS);
+    if (!snap_from_gop) {
+        return false;
+    }
+    MediaInfo info;
+    try {
+        info.parse(play_url);
+    } catch (std::exception &) {
+        return false;
+    }
+    if (!is_local_ip(info.host)) {
+        return false;
+    }
+    auto src = MediaSource::find(info.vhost, info.app, info.stream);
+    auto muxer = src ? src->getMuxer() : nullptr;
+    Track::Ptr video;
+    for (auto &track : src ? src->getTracks(true) : std::vector<Track::Ptr>()) {
+        if (track->getTrackType() == TrackVideo) {
+            video = track;
+            break;
+        }
+    }
+    if (!muxer || !video) {
+        return false;
+    }
+
+    auto key = info.shortUrl();
+    std::shared_ptr<string> image;
+    {
+        std::lock_guard<std::mutex> lck(_mtx);
+        auto &entry = _entries[key];
+        if (entry.image && entry.ticker.elapsedTime() < snap_cache_ms) {
+            image = entry.image;
+        } else {
+            entry.waiters.emplace_back(Waiter { save_path, cb, std::move(fallback) });
+            if (entry.pending) {
+                // 合并到正在进行的截图
+                // Merge into the ongoing snapshot
+                return true;
+            }
+            entry.pending = true;
+        }
+    }
+    if (image) {
+        saveImage(image, { Waiter { save_path, cb, nullptr } });
+        return true;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->key = key;
+    job->wait_ms = timeout_sec * 1000 / 2;
+    weak_ptr<MultiMediaSourceMuxer> weak_muxer = muxer;
+    muxer->getOwnerPoller(MediaSource::NullMediaSource())->async([job, weak_muxer, video]() {
+        if (auto strong_muxer = weak_muxer.lock()) {
+            GopSnapEngine::Instance().snapInOwner(job, strong_muxer, video);
+        }
+    });
+    return true;
+}
+
+void GopSnapEngine::snapInOwner(const Job::Ptr &job, const MultiMediaSourceMuxer::Ptr &muxer, const Track::Ptr &track) {
+    // 第一次截图时创建帧级gop缓存并开始写入；无人使用一段时间后该缓存会被清空，不会拿到过期的关键帧
+    // The frame level gop cache is created and starts being written at the first snapshot;
+    // it is cleared after being unused for a while, so an outdated key frame is never taken
+    auto frames = findKeyFrame(muxer->getFrameRing(), track->getIndex());
+    if (frames.empty() && job->ticker.elapsedTime() < job->wait_ms) {
+        // 等待下一个关键帧写入gop缓存
+        // Wait for the next key frame to be written to the gop cache
+        static constexpr uint64_t kCheckIntervalMS = 100;
+        weak_ptr<MultiMediaSourceMuxer> weak_muxer = muxer;
+        muxer->getOwnerPoller(MediaSource::NullMediaSource())->doDelayTask(kCheckIntervalMS, [job, weak_muxer, track]() {
+            if (auto strong_muxer = weak_muxer.lock()) {
+                GopSnapEngine::Instance().snapInOwner(job, strong_muxer, track);
+            }
+            return 0;
+        });
+        return;
+    }
+    if (frames.empty()) {
+        job->done = true;
+        onResult(job->key, 0, nullptr, "none key frame in gop cache");
+        return;
+    }
+
+    auto key_stamp = frames.back()->dts();
+    std::shared_ptr<string> image;
+    {
+        std::lock_guard<std::mutex> lck(_mtx);
+        auto it = _entries.find(job->key);
+        if (it != _entries.end() && it->second.key_stamp == key_stamp) {
+            image = it->second.image;
+        }
+    }
+    if (image) {
+        // 关键帧未变化，图片也不会变化
+        // The key frame has not changed, so the picture will not change either
+        job->done = true;
+        onResult(job->key, key_stamp, image, "");
+        return;
+    }
+
+    WorkThreadPool::Instance().getPoller()->async([job, track, frames, key_stamp]() {
+        string err;
+        auto image = decodeKeyFrame(track, frames, err);
+        job->done = true;
+        GopSnapEngine::Instance().onResult(job->key, key_stamp, image, err);
+    });
+}
+
+std::vector<Frame::Ptr> GopSnapEngine::findKeyFrame(const MultiMediaSourceMuxer::RingType::Ptr &ring, int index) {
+    // 关键帧及其前面的配置帧(sps/pps等)为一组，取最后一组
+    // The key frame and the config frames (sps/pps, etc.) before it are a group, take the last group
+    std::vector<Frame::Ptr> last, group;
+    bool have_key = false;
+    ring->flushGop([&](const Frame::Ptr &frame) {
+        if (frame->getIndex() != index) {
+            return;
+        }
+        if (frame->keyFrame() || frame->configFrame()) {
+            have_key |= frame->keyFrame();
+            group.emplace_back(frame);
+            return;
+        }
+        if (!have_key) {
+            // 关键帧前的sei等帧忽略
+            // Frames such as sei before the key frame are ignored
+            return;
+        }
+        last = std::move(group);
+        group.clear();
+        have_key = false;
+    });
+    if (have_key) {
+        last = std::move(group);
+    }
+    return last;
+}
+
+std::shared_ptr<string> GopSnapEngine::decodeKeyFrame(const Track::Ptr &track, const std::vector<Frame::Ptr> &frames, string &err) {
+    FFmpegFrame::Ptr picture;
+    try {
+        // 只解码一帧，无需多线程
+        // Only one frame is decoded, no need for multithreading
+        FFmpegDecoder decoder(track, 1);
+        decoder.setOnDecode([&picture](const FFmpegFrame::Ptr &frame) {
+            if (!picture) {
+                picture = frame;
+            }
+        });
+        for (auto &frame : frames) {
+            decoder.inputFrame(frame, false, false);
+        }
+        if (!picture) {
+            decoder.flush();
+        }
+    } catch (std::exception &ex) {
+        err = ex.what();
+        return nullptr;
+    }
+    if (!picture) {
+        err = "decode key frame failed";
+        return nullptr;
+    }
+    auto image = std::make_shared<string>();
+    auto ret = FFmpegUtils::encodeFrame(picture, *image);
+    if (!std::get<0>(ret)) {
+        err = std::get<1>(ret);
+        return nullptr;
+    }
+    return image;
+}
+
+void GopSnapEngine::onResult(const string &key, uint64_t key_stamp, const std::shared_ptr<string> &image, const string &err) {
+    GET_CONFIG(uint32_t, snap_cache_ms, FFmpeg::kSnapCacheMS);
+    std::vector<Waiter> waiters;
+    {
+        std::lock_guard<std::mutex> lck(_mtx);
+        auto it = _entries.find(key);
+        if (it == _entries.end()) {
+            return;
+        }
+        waiters.swap(it->second.waiters);
+        it->second.pending = false;
+        if (image) {
+            it->second.image = image;
+            it->second.key_stamp = key_stamp;
+            it->second.ticker.resetTime();
+        }
+        // 清理长时间未使用的图片缓存，过期后只有关键帧未变化时才有用
+        // Clean up picture caches that have not been used for a long time, they are only useful when the key frame has not changed after expiration
+        for (auto entry = _entries.begin(); entry != _entries.end();) {
+            if (!entry->second.pending && (!entry->second.image || entry->second.ticker.elapsedTime() > snap_cache_ms + 10 * 1000)) {
+                entry = _entries.erase(entry);
+            } else {
+                ++entry;
+            }
+        }
+    }
+
+    if (!image) {
+        DebugL << "Snap from gop cache failed: " << key << ", " << err;
+        for (auto &waiter : waiters) {
+            waiter.fallback();
+        }
+        return;
+    }
+    saveImage(image, waiters);
+}
+
+void GopSnapEngine::saveImage(const std::shared_ptr<string> &image, const std::vector<Waiter> &waiters) {
+    WorkThreadPool::Instance().getPoller()->async([image, waiters]() {
+        for (auto &waiter : waiters) {
+            auto fp = File::create_file(waiter.save_path, "wb");
+            if (!fp) {
+                waiter.cb(false, "Could not open the file " + waiter.save_path);
+                continue;
+            }
+            fwrite(image->data(), image->size(), 1, fp);
+            fclose(fp);
+            waiter.cb(true, "");
+        }
+    });
+}
 
 static void makeSnapAsync(const string &play_url, const string &save_path, float timeout_sec, const FFmpegSnap::onSnap &cb) {
+    if (makeSnapByDecoderBus(play_url, save_path, timeout_sec, cb)) {
+        return;
+    }
     struct Holder {
         MediaPlayer::Ptr player;
     };
@@ -397,7 +765,7 @@ static void makeSnapAsync(const string &play_url, const string &save_path, float
 
 #endif
 
-void FFmpegSnap::makeSnap(bool async, const string &play_url, const string &save_path, float timeout_sec, const onSnap &cb) {
+static void makeSnap_l(bool async, const string &play_url, const string &save_path, float timeout_sec, const FFmpegSnap::onSnap &cb) {
 #if defined(ENABLE_FFMPEG)
     if (async) {
         makeSnapAsync(play_url, save_path, timeout_sec, cb);
@@ -448,3 +816,15 @@ void FFmpegSnap::makeSnap(bool async, const string &play_url, const string &save
         cb(success, (!success && !log_file.empty()) ? File::loadFile(log_file) : "");
     });
 }
+
+void FFmpegSnap::makeSnap(bool async, const string &play_url, const string &save_path, float timeout_sec, const onSnap &cb) {
+#if defined(ENABLE_FFMPEG)
+    // 本机的流优先从gop缓存截图，不需要启动ffmpeg进程或者再次拉流
+    // The local stream takes snapshots from the gop cache first, no need to start an ffmpeg process or pull the stream again
+    auto fallback = [async, play_url, save_path, timeout_sec, cb]() { makeSnap_l(async, play_url, save_path, timeout_sec, cb); };
+    if (GopSnapEngine::Instance().makeSnap(play_url, save_path, timeout_sec, cb, fallback)) {
+        return;
+    }
+#endif
+    makeSnap_l(async, play_url, save_path, timeout_sec, cb);
+}
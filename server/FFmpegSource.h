@@ -23,12 +23,20 @@ namespace FFmpeg {
     extern const std::string kBin;
 }
 
+/**
+ * 是否为本机地址(127.0.0.1、localhost或本机网卡ip)
+ * Whether it is a local address (127.0.0.1, localhost or the ip of a local network interface)
+ */
+bool is_local_ip(const std::string &ip);
+
 class FFmpegSnap {
 public:
     using onSnap = std::function<void(bool success, const std::string &err_msg)>;
     /**
      * 创建截图  [AUTO-TRANSLATED:6d334c49]
      * Create a screenshot
+     * 本机的流(ffmpeg.snap_from_gop)优先从gop缓存中取关键帧在进程内截图
+     * The local stream (ffmpeg.snap_from_gop) takes the snapshot in process from the key frame in the gop cache first
      * @param async 是否使用异步截图方式(非ffmpeg命令行，而是使用zlm api，但是仅限于zlm播放器支持的拉流协议)
      * @param play_url 播放url地址，只要FFmpeg支持即可  [AUTO-TRANSLATED:609d4de4]
      * @param play_url The playback URL address, as long as FFmpeg supports it
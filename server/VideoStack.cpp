@@ -1,6 +1,8 @@
 ﻿#if defined(ENABLE_VIDEOSTACK) && defined(ENABLE_X264) && defined(ENABLE_FFMPEG)
 #include "VideoStack.h"
+#include "FFmpegSource.h"
 #include "Codec/Transcode.h"
+#include "Codec/DecoderBus.h"
 #include "Common/Device.h"
 #include "Util/logger.h"
 #include "Util/util.h"
@@ -196,12 +198,60 @@ void StackPlayer::addChannel(const std::weak_ptr<Channel>& chn) {
     _channels.push_back(chn);
 }
 
+bool StackPlayer::subscribeDecoderBus() {
+    mediakit::MediaInfo info;
+    try {
+        info.parse(_url);
+    } catch (std::exception&) {
+        return false;
+    }
+    if (!is_local_ip(info.host)) {
+        return false;
+    }
+    // 本机的流直接订阅解码总线，与其他拼接屏、截图等共用一个解码器，不再拉流并重复解码
+    // The local stream directly subscribes to the decoder bus, sharing one decoder with other stacks and snapshots instead of pulling and decoding again
+    std::weak_ptr<StackPlayer> weakSelf = shared_from_this();
+    _bus = mediakit::DecoderBus::subscribe(info, [weakSelf](const mediakit::FFmpegFrame::Ptr& frame) {
+        if (auto self = weakSelf.lock()) { self->onFrame(frame); }
+    }, [weakSelf]() {
+        auto self = weakSelf.lock();
+        if (!self) { return; }
+        // 流注销回调在流的归属线程触发，切换到本对象的线程再释放订阅并重连
+        // The stream unregistered callback is triggered in the owner thread of the stream,
+        // switch to the thread of this object before releasing the subscription and reconnecting
+        self->_poller->async([weakSelf]() {
+            auto self = weakSelf.lock();
+            if (!self) { return; }
+            self->_bus = nullptr;
+            self->onDisconnect();
+            self->rePlay(self->_url);
+        }, false);
+    });
+    if (!_bus) {
+        return false;
+    }
+    TraceL << "StackPlayer: " << _url << " subscribe decoder bus";
+    _timer.reset();
+    _failedCount = 0;
+    return true;
+}
+
 void StackPlayer::play() {
+    if (!_poller->isCurrentThread()) {
+        std::weak_ptr<StackPlayer> weakSelf = shared_from_this();
+        _poller->async([weakSelf]() {
+            if (auto self = weakSelf.lock()) { self->play(); }
+        });
+        return;
+    }
+    if (subscribeDecoderBus()) {
+        return;
+    }
 
     auto url = _url;
     // 创建拉流 解码对象  [AUTO-TRANSLATED:9267c5dc]
     // Create a pull stream decoding object
-    _player = std::make_shared<mediakit::MediaPlayer>();
+    _player = std::make_shared<mediakit::MediaPlayer>(_poller);
     std::weak_ptr<mediakit::MediaPlayer> weakPlayer = _player;
 
     std::weak_ptr<StackPlayer> weakSelf = shared_from_this();
@@ -289,11 +339,15 @@ void StackPlayer::rePlay(const std::string& url) {
     std::weak_ptr<StackPlayer> weakSelf = shared_from_this();
     _timer = std::make_shared<toolkit::Timer>(delay / 1000.0f, [weakSelf, url]() {
         auto self = weakSelf.lock();
-        if (!self) {}
+        if (!self) { return false; }
         WarnL << "replay [" << self->_failedCount << "]:" << url;
-        self->_player->play(url);
+        if (self->_player) {
+            self->_player->play(url);
+        } else {
+            self->play();
+        }
         return false;
-    }, nullptr);
+    }, _poller);
 }
 
 VideoStack::VideoStack(const std::string& id, int width, int height, AVPixelFormat pixfmt,
@@ -93,7 +93,7 @@ class StackPlayer : public std::enable_shared_from_this<StackPlayer> {
 public:
     using Ptr = std::shared_ptr<StackPlayer>;
 
-    StackPlayer(const std::string& url) : _url(url) {}
+    StackPlayer(const std::string& url) : _url(url), _poller(toolkit::EventPollerPool::Instance().getPoller()) {}
 
     void addChannel(const std::weak_ptr<Channel>& chn);
 
@@ -106,9 +106,17 @@ public:
 protected:
     void rePlay(const std::string& url);
 
+    bool subscribeDecoderBus();
+
 private:
     std::string _url;
+    // 拉流、解码总线订阅与重连都在该线程执行
+    // Pulling, decoder bus subscription and reconnection are all executed in this thread
+    toolkit::EventPoller::Ptr _poller;
     mediakit::MediaPlayer::Ptr _player;
+    // 本机流的解码总线订阅句柄
+    // Decoder bus subscription handle of the local stream
+    std::shared_ptr<void> _bus;
 
     // 用于断线重连  [AUTO-TRANSLATED:18fd242a]
     // Used for disconnection and reconnection
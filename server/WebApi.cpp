@@ -21,6 +21,7 @@
 
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
 #include <regex>
 #include "Util/MD5.h"
 #include "Util/util.h"
@@ -42,6 +43,10 @@
 
 #include "Common/config.h"
 #include "Common/MediaSource.h"
+#include "Common/Metrics.h"
+#include "Common/MultiMediaSourceMuxer.h"
+#include "Common/PacketCache.h"
+#include "Common/PacketPool.h"
 #include "Http/HttpSession.h"
 #include "Http/HttpRequester.h"
 #include "Player/PlayerProxy.h"
@@ -464,6 +469,18 @@ Value makeMediaSourceJson(MediaSource &media){
     item["originUrl"] = media.getOriginUrl();
     item["isRecordingMP4"] = media.isRecording(Recorder::type_mp4);
     item["isRecordingHLS"] = media.isRecording(Recorder::type_hls);
+    item["gopCacheBytes"] = (Json::UInt64) media.getGopCacheBytes();
+    if (auto muxer = media.getMuxer()) {
+        // 多个协议共用的帧级gop缓存(shared_gop_cache、进程内解码与截图)
+        // Frame-level gop cache shared by protocols (shared_gop_cache, in-process decoding and snapshots)
+        item["frameGopCacheBytes"] = (Json::UInt64) muxer->getGopCacheBytes();
+        // 转协议并行流水线各阶段积压的帧数与丢弃的帧数
+        // Number of backlogged frames and dropped frames of each stage of the parallel muxer pipeline
+        muxer->forEachPipelineStage([&](const std::string &stage, size_t depth, size_t dropped) {
+            item["muxerPipeline"][stage]["depth"] = (Json::UInt64)depth;
+            item["muxerPipeline"][stage]["dropped"] = (Json::UInt64)dropped;
+        });
+    }
     auto originSock = media.getOriginSock();
     if (originSock) {
         fillSockInfo(item["originSock"], originSock.get());
@@ -576,6 +593,13 @@ void getStatisticJson(const function<void(Value &val)> &cb) {
 
     val["RtpPacket"] = (Json::UInt64)(ObjectStatistic<RtpPacket>::count());
     val["RtmpPacket"] = (Json::UInt64)(ObjectStatistic<RtmpPacket>::count());
+    val["gopCacheBytes"] = (Json::UInt64)(GopCacheBudget::totalBytes());
+    for (auto &stat : getPacketPoolStatistic()) {
+        auto &item = val["packetPool"][stat.name];
+        item["hit"] = (Json::UInt64)stat.hit;
+        item["miss"] = (Json::UInt64)stat.miss;
+        item["cached"] = (Json::UInt64)stat.cached;
+    }
 #ifdef ENABLE_MEM_DEBUG
     auto bytes = getTotalMemUsage();
     val["totalMemUsage"] = (Json::UInt64) bytes;
@@ -2077,6 +2101,40 @@ void installWebApi() {
         });
     });
 
+    // 获取流水线各阶段延时统计(需开启general.latency_statistic)，可选筛选参数
+    // Get the latency statistics of each pipeline stage (general.latency_statistic needs to be enabled), optional filtering parameters
+    // 测试url http://127.0.0.1/index/api/getStreamLatency?vhost=__defaultVhost__&app=live&stream=obs
+    // Test url http://127.0.0.1/index/api/getStreamLatency?vhost=__defaultVhost__&app=live&stream=obs
+    api_regist("/index/api/getStreamLatency",[](API_ARGS_MAP){
+        CHECK_SECRET();
+        val["data"] = Json::arrayValue;
+        // 同一路流的多个协议共用一个muxer，只输出一次
+        // Multiple protocols of the same stream share one muxer, only output once
+        std::unordered_set<MultiMediaSourceMuxer *> visited;
+        MediaSource::for_each_media([&](const MediaSource::Ptr &media) {
+            auto muxer = media->getMuxer();
+            if (!muxer || !muxer->getLatency() || !visited.emplace(muxer.get()).second) {
+                return;
+            }
+            Value item;
+            dumpMediaTuple(media->getMediaTuple(), item);
+            for (int i = 0; i < kLatencyStageMax; ++i) {
+                auto stage = (LatencyStage)i;
+                auto value = muxer->getLatency()->getValue(stage);
+                Value obj;
+                obj["count"] = (Json::UInt64)value.count;
+                obj["avg"] = (Json::UInt64)value.avg;
+                obj["max"] = (Json::UInt64)value.max;
+                obj["p50"] = (Json::UInt64)value.p50;
+                obj["p90"] = (Json::UInt64)value.p90;
+                obj["p99"] = (Json::UInt64)value.p99;
+                obj["p999"] = (Json::UInt64)value.p999;
+                item["stages"][getLatencyStageName(stage)] = obj;
+            }
+            val["data"].append(item);
+        }, "", allArgs["vhost"], allArgs["app"], allArgs["stream"]);
+    });
+
     api_regist("/index/api/getStatistic",[](API_ARGS_MAP_ASYNC){
         CHECK_SECRET();
         getStatisticJson([headerOut, val, invoker](const Value &data) mutable{
@@ -2085,6 +2143,16 @@ void installWebApi() {
         });
     });
 
+    // prometheus格式的统计指标，只读取各线程的计数器，不遍历媒体源也不阻塞网络线程
+    // Metrics in prometheus format, only reads the counters of each thread, neither traverses media sources nor blocks network threads
+    // 测试url http://127.0.0.1/metrics?secret=xxx
+    // Test url http://127.0.0.1/metrics?secret=xxx
+    api_regist("/metrics",[](API_ARGS_MAP_ASYNC){
+        CHECK_SECRET();
+        headerOut["Content-Type"] = "text/plain; version=0.0.4";
+        invoker(200, headerOut, Metrics::dump());
+    });
+
 #ifdef ENABLE_WEBRTC
     class WebRtcArgsImp : public WebRtcArgs {
     public:
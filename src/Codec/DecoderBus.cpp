@@ -0,0 +1,178 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#if defined(ENABLE_FFMPEG)
+
+#include <unordered_map>
+#include "DecoderBus.h"
+#include "Util/onceToken.h"
+#include "Thread/WorkThreadPool.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+// 流的vhost/app/stream --> 解码总线
+// vhost/app/stream of the stream --> decoder bus
+static mutex s_bus_mtx;
+static unordered_map<string, weak_ptr<DecoderBus>> s_bus_map;
+
+shared_ptr<void> DecoderBus::subscribe(const MediaTuple &tuple, onDec on_decode, onDetach on_detach) {
+    auto key = tuple.shortUrl();
+    DecoderBus::Ptr bus;
+    {
+        lock_guard<mutex> lck(s_bus_mtx);
+        bus = s_bus_map[key].lock();
+        if (!bus) {
+            auto src = MediaSource::find(tuple.vhost, tuple.app, tuple.stream);
+            auto muxer = src ? src->getMuxer() : nullptr;
+            Track::Ptr video;
+            for (auto &track : src ? src->getTracks(true) : vector<Track::Ptr>()) {
+                if (track->getTrackType() == TrackVideo) {
+                    video = track;
+                    break;
+                }
+            }
+            if (!muxer || !video) {
+                s_bus_map.erase(key);
+                return nullptr;
+            }
+            bus.reset(new DecoderBus(key, video));
+            bus->start(muxer);
+            s_bus_map[key] = bus;
+        }
+    }
+
+    auto id = bus->addSubscriber(std::move(on_decode), std::move(on_detach));
+    return std::make_shared<onceToken>(nullptr, [bus, id]() { bus->delSubscriber(id); });
+}
+
+DecoderBus::DecoderBus(string key, const Track::Ptr &track) {
+    _key = std::move(key);
+    _track_index = track->getIndex();
+    _decoder = std::make_shared<FFmpegDecoder>(track);
+    InfoL << "Start decoder bus: " << _key << ", codec: " << track->getCodecName();
+}
+
+DecoderBus::~DecoderBus() {
+    InfoL << "Stop decoder bus: " << _key;
+    {
+        lock_guard<mutex> lck(s_bus_mtx);
+        auto it = s_bus_map.find(_key);
+        if (it != s_bus_map.end() && it->second.expired()) {
+            s_bus_map.erase(it);
+        }
+    }
+    // 最后一个引用可能在解码线程中释放，而解码器析构时会join解码线程，所以转到后台线程析构
+    // The last reference may be released in the decoding thread, and the decoder joins the decoding thread when destructed, so destruct it in a background thread
+    WorkThreadPool::Instance().getPoller()->async(std::bind([](const FFmpegDecoder::Ptr &) {}, std::move(_decoder)), false);
+}
+
+void DecoderBus::start(const MultiMediaSourceMuxer::Ptr &muxer) {
+    weak_ptr<DecoderBus> weak_self = shared_from_this();
+    _decoder->setOnDecode([weak_self](const FFmpegFrame::Ptr &frame) {
+        if (auto strong_self = weak_self.lock()) {
+            strong_self->onDecode(frame);
+        }
+    });
+
+    weak_ptr<MultiMediaSourceMuxer> weak_muxer = muxer;
+    muxer->getOwnerPoller(MediaSource::NullMediaSource())->async([weak_self, weak_muxer]() {
+        auto strong_self = weak_self.lock();
+        auto strong_muxer = weak_muxer.lock();
+        if (!strong_self) {
+            return;
+        }
+        if (!strong_muxer) {
+            strong_self->onStreamDetach();
+            return;
+        }
+        // 新的reader会先收到gop缓存，解码器可以立即从关键帧开始解码
+        // The new reader receives the gop cache first, so the decoder can start decoding from the key frame immediately
+        auto reader = strong_muxer->getFrameRing()->attach(strong_muxer->getOwnerPoller(MediaSource::NullMediaSource()));
+        reader->setReadCB([weak_self](const Frame::Ptr &frame) {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->onFrame(frame);
+            }
+        });
+        reader->setDetachCB([weak_self]() {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->onStreamDetach();
+            }
+        });
+        strong_self->_reader = std::move(reader);
+    });
+}
+
+void DecoderBus::onFrame(const Frame::Ptr &frame) {
+    if (frame->getIndex() != _track_index) {
+        return;
+    }
+    _decoder->inputFrame(frame, true, true);
+}
+
+void DecoderBus::onDecode(const FFmpegFrame::Ptr &frame) {
+    vector<onDec> callbacks;
+    {
+        lock_guard<mutex> lck(_mtx);
+        callbacks.reserve(_subscribers.size());
+        for (auto &pr : _subscribers) {
+            callbacks.emplace_back(pr.second.first);
+        }
+    }
+    // 在锁外回调，订阅者可以在回调中取消订阅
+    // Callback outside the lock, subscribers can unsubscribe in the callback
+    for (auto &cb : callbacks) {
+        cb(frame);
+    }
+}
+
+void DecoderBus::onStreamDetach() {
+    WarnL << "Stream of decoder bus unregistered: " << _key;
+    {
+        // 之后的订阅者重新创建解码总线
+        // Subsequent subscribers recreate the decoder bus
+        lock_guard<mutex> lck(s_bus_mtx);
+        auto it = s_bus_map.find(_key);
+        if (it != s_bus_map.end() && it->second.lock().get() == this) {
+            s_bus_map.erase(it);
+        }
+    }
+    vector<onDetach> callbacks;
+    {
+        lock_guard<mutex> lck(_mtx);
+        for (auto &pr : _subscribers) {
+            if (pr.second.second) {
+                callbacks.emplace_back(std::move(pr.second.second));
+            }
+            pr.second.first = [](const FFmpegFrame::Ptr &) {};
+        }
+    }
+    for (auto &cb : callbacks) {
+        cb();
+    }
+}
+
+uint64_t DecoderBus::addSubscriber(onDec on_decode, onDetach on_detach) {
+    lock_guard<mutex> lck(_mtx);
+    auto id = ++_subscriber_id;
+    _subscribers.emplace(id, std::make_pair(std::move(on_decode), std::move(on_detach)));
+    return id;
+}
+
+void DecoderBus::delSubscriber(uint64_t id) {
+    lock_guard<mutex> lck(_mtx);
+    _subscribers.erase(id);
+}
+
+} // namespace mediakit
+
+#endif // ENABLE_FFMPEG
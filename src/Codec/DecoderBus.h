@@ -0,0 +1,74 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_DECODERBUS_H
+#define ZLMEDIAKIT_DECODERBUS_H
+
+#if defined(ENABLE_FFMPEG)
+
+#include <map>
+#include <mutex>
+#include "Transcode.h"
+#include "Common/MultiMediaSourceMuxer.h"
+
+namespace mediakit {
+
+/**
+ * 解码总线，同一路本机流只启动一个视频解码器，解码后的帧分发给所有订阅者(拼接屏、截图、转码、分析等)
+ * 第一个订阅者到来时开始解码，最后一个订阅者离开时停止解码
+ * Decoder bus, only one video decoder is started for a local stream, and the decoded frames are distributed to all subscribers (video stack, snapshot, transcode, analysis, etc.)
+ * Decoding starts when the first subscriber arrives and stops when the last subscriber leaves
+ */
+class DecoderBus : public std::enable_shared_from_this<DecoderBus> {
+public:
+    using Ptr = std::shared_ptr<DecoderBus>;
+    using onDec = FFmpegDecoder::onDec;
+    using onDetach = std::function<void()>;
+
+    /**
+     * 订阅本机流解码后的视频帧
+     * @param tuple 流的vhost/app/stream
+     * @param on_decode 解码后视频帧回调，在解码线程触发
+     * @param on_detach 流注销回调，之后不再触发on_decode，可以为空
+     * @return 订阅句柄，释放即取消订阅；流不存在或没有就绪的视频时返回空
+     * Subscribe to the decoded video frames of a local stream
+     * @param tuple vhost/app/stream of the stream
+     * @param on_decode Decoded video frame callback, triggered in the decoding thread
+     * @param on_detach Stream unregistered callback, on_decode will not be triggered after it, can be empty
+     * @return Subscription handle, release it to unsubscribe; return null if the stream does not exist or has no ready video
+     */
+    static std::shared_ptr<void> subscribe(const MediaTuple &tuple, onDec on_decode, onDetach on_detach = nullptr);
+
+    ~DecoderBus();
+
+private:
+    DecoderBus(std::string key, const Track::Ptr &track);
+    void start(const MultiMediaSourceMuxer::Ptr &muxer);
+    void onFrame(const Frame::Ptr &frame);
+    void onDecode(const FFmpegFrame::Ptr &frame);
+    void onStreamDetach();
+    uint64_t addSubscriber(onDec on_decode, onDetach on_detach);
+    void delSubscriber(uint64_t id);
+
+private:
+    int _track_index;
+    std::string _key;
+    FFmpegDecoder::Ptr _decoder;
+    MultiMediaSourceMuxer::RingType::RingReader::Ptr _reader;
+
+    std::mutex _mtx;
+    uint64_t _subscriber_id = 0;
+    std::map<uint64_t, std::pair<onDec, onDetach>> _subscribers;
+};
+
+} // namespace mediakit
+
+#endif // ENABLE_FFMPEG
+#endif // ZLMEDIAKIT_DECODERBUS_H
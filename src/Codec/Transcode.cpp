@@ -108,6 +108,24 @@ static bool checkIfSupportedNvidia() {
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
+INSTANCE_IMP(DecodeThreadPool)
+
+DecodeThreadPool::DecodeThreadPool() {
+    GET_CONFIG(size_t, threads, General::kDecodeThreads);
+    addPoller("decoder pool", threads ? threads : 1, ThreadPool::PRIORITY_HIGHEST, false);
+}
+
+bool DecodeThreadPool::enabled() {
+    GET_CONFIG(size_t, threads, General::kDecodeThreads);
+    return threads > 0;
+}
+
+EventPoller::Ptr DecodeThreadPool::getPoller() {
+    return static_pointer_cast<EventPoller>(getExecutor());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
 bool TaskManager::addEncodeTask(function<void()> task) {
     {
         lock_guard<mutex> lck(_task_mtx);
@@ -115,9 +133,10 @@ bool TaskManager::addEncodeTask(function<void()> task) {
         if (_task.size() > _max_task) {
             WarnL << "encoder thread task is too more, now drop frame!";
             _task.pop_front();
+            ++_drop_count;
         }
     }
-    _sem.post();
+    notifyTask();
     return true;
 }
 
@@ -127,10 +146,11 @@ bool TaskManager::addDecodeTask(bool key_frame, function<void()> task) {
         if (_decode_drop_start) {
             if (!key_frame) {
                 TraceL << "decode thread drop frame";
+                ++_drop_count;
                 return false;
             }
             _decode_drop_start = false;
-            InfoL << "decode thread stop drop frame";
+            InfoL << "decode thread stop drop frame, total dropped: " << _drop_count.load();
         }
 
         _task.emplace_back(std::move(task));
@@ -139,16 +159,48 @@ bool TaskManager::addDecodeTask(bool key_frame, function<void()> task) {
             WarnL << "decode thread start drop frame";
         }
     }
-    _sem.post();
+    notifyTask();
     return true;
 }
 
+void TaskManager::notifyTask() {
+    if (!_poller) {
+        _sem.post();
+        return;
+    }
+    // 每个任务对应一次投递，同一对象固定在一个线程，所以任务按顺序执行
+    // Each task corresponds to one delivery, and the same object is pinned to one thread, so the tasks are executed in order
+    auto guard = _pool_guard;
+    _poller->async([this, guard]() {
+        lock_guard<mutex> lck(guard->mtx);
+        if (!guard->exit) {
+            onPoolRun();
+        }
+    }, false);
+}
+
 void TaskManager::setMaxTaskSize(size_t size) {
     CHECK(size >= 3 && size <= 1000, "async task size limited to 3 ~ 1000, now size is:", size);
     _max_task = size;
 }
 
+size_t TaskManager::getTaskSize() {
+    lock_guard<mutex> lck(_task_mtx);
+    return _task.size();
+}
+
+uint64_t TaskManager::getDropCount() const {
+    return _drop_count;
+}
+
 void TaskManager::startThread(const string &name) {
+    if (DecodeThreadPool::enabled()) {
+        // 多路低分辨率编解码器共享有限的线程
+        // Many low-resolution codecs share a bounded number of threads
+        _pool_guard = std::make_shared<PoolGuard>();
+        _poller = DecodeThreadPool::Instance().getPoller();
+        return;
+    }
     _thread.reset(new thread([this, name]() {
         onThreadRun(name);
     }), [](thread *ptr) {
@@ -161,6 +213,21 @@ void TaskManager::startThread(const string &name) {
 
 void TaskManager::stopThread(bool drop_task) {
     TimeTicker();
+    if (_poller) {
+        if (!drop_task) {
+            // 等待已投递的任务执行完毕
+            // Wait for the delivered tasks to be completed
+            _poller->sync([]() {});
+        }
+        {
+            lock_guard<mutex> lck(_pool_guard->mtx);
+            _pool_guard->exit = true;
+        }
+        lock_guard<mutex> lck(_task_mtx);
+        _task.clear();
+        _poller = nullptr;
+        return;
+    }
     if (!_thread) {
         return;
     }
@@ -183,7 +250,25 @@ TaskManager::~TaskManager() {
 }
 
 bool TaskManager::isEnabled() const {
-    return _thread.operator bool();
+    return _thread || _poller;
+}
+
+void TaskManager::onPoolRun() {
+    function<void()> task;
+    {
+        lock_guard<mutex> lck(_task_mtx);
+        if (_task.empty()) {
+            return;
+        }
+        task = std::move(_task.front());
+        _task.pop_front();
+    }
+    try {
+        TimeTicker2(50, TraceL);
+        task();
+    } catch (std::exception &ex) {
+        WarnL << ex.what();
+    }
 }
 
 void TaskManager::onThreadRun(const string &name) {
@@ -408,13 +493,21 @@ FFmpegDecoder::FFmpegDecoder(const Track::Ptr &track, int thread_num, const std:
 #ifdef FF_API_OLD_ENCDEC
         _context->refcounted_frames = 1;
 #endif
-        _context->flags |= AV_CODEC_FLAG_LOW_DELAY;
         _context->flags2 |= AV_CODEC_FLAG2_FAST;
         if (track->getTrackType() == TrackVideo) {
             _context->width = static_pointer_cast<VideoTrack>(track)->getVideoWidth();
             _context->height = static_pointer_cast<VideoTrack>(track)->getVideoHeight();
             InfoL << "media source :" << _context->width << " X " << _context->height;
         }
+        GET_CONFIG(bool, frame_threads, General::kDecodeFrameThreads);
+        if (frame_threads && track->getTrackType() == TrackVideo) {
+            // 帧级多线程与AV_CODEC_FLAG_LOW_DELAY互斥，单片的高分辨率视频只有开启帧级多线程才能利用多核
+            // Frame threading is mutually exclusive with AV_CODEC_FLAG_LOW_DELAY, single slice high resolution videos can only use multiple cores with frame threading
+            _context->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        } else {
+            _context->flags |= AV_CODEC_FLAG_LOW_DELAY;
+            _context->thread_type = FF_THREAD_SLICE;
+        }
 
         switch (track->getCodecId()) {
             case CodecG711A:
@@ -477,13 +570,15 @@ FFmpegDecoder::FFmpegDecoder(const Track::Ptr &track, int thread_num, const std:
 
 FFmpegDecoder::~FFmpegDecoder() {
     stopThread(true);
-    if (_do_merger) {
-        _merger.flush();
-    }
     flush();
 }
 
 void FFmpegDecoder::flush() {
+    if (_do_merger) {
+        // 合并缓存中的最后一帧送解码器
+        // Send the last frame in the merge cache to the decoder
+        _merger.flush();
+    }
     while (true) {
         auto out_frame = _frame_pool.obtain2();
         auto ret = avcodec_receive_frame(_context.get(), out_frame->get());
@@ -747,7 +842,7 @@ FFmpegFrame::Ptr FFmpegSws::inputFrame(const FFmpegFrame::Ptr &frame, int &ret,
     return nullptr;
 }
 
-std::tuple<bool, std::string> FFmpegUtils::saveFrame(const FFmpegFrame::Ptr &frame, const char *filename, AVPixelFormat fmt) {
+std::tuple<bool, std::string> FFmpegUtils::encodeFrame(const FFmpegFrame::Ptr &frame, std::string &out, AVPixelFormat fmt) {
     _StrPrinter ss;
     const AVCodec *jpeg_codec = avcodec_find_encoder(fmt == AV_PIX_FMT_YUVJ420P ? AV_CODEC_ID_MJPEG : AV_CODEC_ID_PNG);
     std::unique_ptr<AVCodecContext, void (*)(AVCodecContext *)> jpeg_codec_ctx(
@@ -787,6 +882,21 @@ std::tuple<bool, std::string> FFmpegUtils::saveFrame(const FFmpegFrame::Ptr &fra
         return make_tuple<bool, std::string>(false, ss.data());
     }
 
+    out.clear();
+    while (avcodec_receive_packet(jpeg_codec_ctx.get(), pkt.get()) == 0) {
+        out.append((char *)pkt.get()->data, pkt.get()->size);
+        av_packet_unref(pkt.get());
+    }
+    return make_tuple<bool, std::string>(true, "");
+}
+
+std::tuple<bool, std::string> FFmpegUtils::saveFrame(const FFmpegFrame::Ptr &frame, const char *filename, AVPixelFormat fmt) {
+    std::string data;
+    auto ret = encodeFrame(frame, data, fmt);
+    if (!std::get<0>(ret)) {
+        return ret;
+    }
+
     std::unique_ptr<FILE, void (*)(FILE *)> tmp_save_file_jpg(File::create_file(filename, "wb"), [](FILE *fp) {
         if (fp) {
             fclose(fp);
@@ -794,14 +904,13 @@ std::tuple<bool, std::string> FFmpegUtils::saveFrame(const FFmpegFrame::Ptr &fra
     });
 
     if (!tmp_save_file_jpg) {
+        _StrPrinter ss;
         ss << "Could not open the file " << filename;
         DebugL << ss;
         return make_tuple<bool, std::string>(false, ss.data());
     }
 
-    while (avcodec_receive_packet(jpeg_codec_ctx.get(), pkt.get()) == 0) {
-        fwrite(pkt.get()->data, pkt.get()->size, 1, tmp_save_file_jpg.get());
-    }
+    fwrite(data.data(), data.size(), 1, tmp_save_file_jpg.get());
     DebugL << "Screenshot successful: " << filename;
     return make_tuple<bool, std::string>(true, "");
 }
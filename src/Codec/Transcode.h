@@ -13,7 +13,9 @@
 
 #if defined(ENABLE_FFMPEG)
 
+#include <atomic>
 #include "Util/TimeTicker.h"
+#include "Poller/EventPoller.h"
 #include "Common/MediaSink.h"
 
 #ifdef __cplusplus
@@ -79,6 +81,29 @@ private:
     toolkit::ResourcePool<FFmpegFrame> _swr_frame_pool;
 };
 
+/**
+ * 编解码线程池，开启后异步编解码任务不再各自独占一个线程，而是分散到该线程池执行
+ * 线程个数由general.decode_threads配置，置0则每个异步编解码器独占一个线程
+ * Codec thread pool, when enabled, asynchronous codec tasks no longer occupy a dedicated thread each,
+ * but are spread over this thread pool
+ * The number of threads is configured by general.decode_threads, set to 0 to give each asynchronous codec a dedicated thread
+ */
+class DecodeThreadPool : public toolkit::TaskExecutorGetterImp {
+public:
+    static DecodeThreadPool &Instance();
+
+    /**
+     * 是否开启了共享编解码线程池
+     * Whether the shared codec thread pool is enabled
+     */
+    static bool enabled();
+
+    toolkit::EventPoller::Ptr getPoller();
+
+private:
+    DecodeThreadPool();
+};
+
 class TaskManager {
 public:
     virtual ~TaskManager();
@@ -86,6 +111,18 @@ public:
     void setMaxTaskSize(size_t size);
     void stopThread(bool drop_task);
 
+    /**
+     * 获取待执行的任务个数(队列深度)
+     * Get the number of pending tasks (queue depth)
+     */
+    size_t getTaskSize();
+
+    /**
+     * 获取因任务积压而丢弃的帧数
+     * Get the number of frames dropped due to task backlog
+     */
+    uint64_t getDropCount() const;
+
 protected:
     void startThread(const std::string &name);
     bool addEncodeTask(std::function<void()> task);
@@ -94,6 +131,8 @@ protected:
 
 private:
     void onThreadRun(const std::string &name);
+    void onPoolRun();
+    void notifyTask();
 
 private:
     class ThreadExitException : public std::runtime_error {
@@ -101,14 +140,24 @@ private:
         ThreadExitException() : std::runtime_error("exit") {}
     };
 
+    // 共享线程池模式下，任务执行与停止互斥，停止后已投递的任务不再访问本对象
+    // In shared thread pool mode, task execution and stopping are mutually exclusive, delivered tasks no longer access this object after stopping
+    struct PoolGuard {
+        std::mutex mtx;
+        bool exit = false;
+    };
+
 private:
     bool _decode_drop_start = false;
     bool _exit = false;
     size_t _max_task = 30;
+    std::atomic<uint64_t> _drop_count { 0 };
     std::mutex _task_mtx;
     toolkit::semaphore _sem;
     toolkit::List<std::function<void()> > _task;
     std::shared_ptr<std::thread> _thread;
+    toolkit::EventPoller::Ptr _poller;
+    std::shared_ptr<PoolGuard> _pool_guard;
 };
 
 class FFmpegDecoder : public TaskManager {
@@ -172,6 +221,18 @@ public:
      * @return
      */
     static std::tuple<bool, std::string> saveFrame(const FFmpegFrame::Ptr &frame, const char *filename, AVPixelFormat fmt = AV_PIX_FMT_YUVJ420P);
+
+    /**
+     * 编码图片为jpeg或png，保存在内存中
+     * @param frame 解码后的帧
+     * @param out 编码后的图片数据
+     * @param fmt jpg:AV_PIX_FMT_YUVJ420P，PNG:AV_PIX_FMT_RGB24
+     * Encode the picture as jpeg or png in memory
+     * @param frame Decoded frame
+     * @param out Encoded picture data
+     * @param fmt jpg:AV_PIX_FMT_YUVJ420P, PNG:AV_PIX_FMT_RGB24
+     */
+    static std::tuple<bool, std::string> encodeFrame(const FFmpegFrame::Ptr &frame, std::string &out, AVPixelFormat fmt = AV_PIX_FMT_YUVJ420P);
 };
 
 }//namespace mediakit
@@ -0,0 +1,56 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "DiskIO.h"
+#include "Util/util.h"
+#include "Common/config.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+INSTANCE_IMP(DiskIOPool);
+
+DiskIOPool::DiskIOPool() {
+    GET_CONFIG(size_t, threads, General::kDiskIOThreads);
+    addPoller("disk io", threads ? threads : 1, ThreadPool::PRIORITY_LOWEST, false);
+}
+
+bool DiskIOPool::enabled() {
+    GET_CONFIG(size_t, threads, General::kDiskIOThreads);
+    return threads > 0;
+}
+
+EventPoller::Ptr DiskIOPool::getPoller() {
+    return static_pointer_cast<EventPoller>(getExecutor());
+}
+
+DiskIOQueue::DiskIOQueue() {
+    if (DiskIOPool::enabled()) {
+        _poller = DiskIOPool::Instance().getPoller();
+    }
+}
+
+void DiskIOQueue::async(std::function<void()> task) {
+    if (_poller) {
+        _poller->async(std::move(task), false);
+    } else {
+        task();
+    }
+}
+
+void DiskIOQueue::sync() {
+    if (_poller) {
+        _poller->sync([]() {});
+    }
+}
+
+} // namespace mediakit
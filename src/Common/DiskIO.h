@@ -0,0 +1,76 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_DISKIO_H
+#define ZLMEDIAKIT_DISKIO_H
+
+#include <functional>
+#include "Thread/TaskExecutor.h"
+#include "Poller/EventPoller.h"
+
+namespace mediakit {
+
+/**
+ * 磁盘io线程池，录制文件的写操作在此执行，避免磁盘延时阻塞网络poller线程
+ * 线程个数由general.disk_io_threads配置
+ * Disk io thread pool, the write operations of recording files are executed here,
+ * so that disk latency does not block the network poller threads
+ * The number of threads is configured by general.disk_io_threads
+ */
+class DiskIOPool : public toolkit::TaskExecutorGetterImp {
+public:
+    static DiskIOPool &Instance();
+
+    /**
+     * 是否开启了异步磁盘io
+     * Whether asynchronous disk io is enabled
+     */
+    static bool enabled();
+
+    toolkit::EventPoller::Ptr getPoller();
+
+private:
+    DiskIOPool();
+};
+
+/**
+ * 磁盘io任务队列，同一队列的任务按投递顺序在同一个磁盘io线程串行执行
+ * 未开启异步磁盘io时，任务在调用线程同步执行
+ * Disk io task queue, the tasks of the same queue are executed serially in the same disk io thread in the order of delivery
+ * When asynchronous disk io is not enabled, the tasks are executed synchronously in the calling thread
+ */
+class DiskIOQueue {
+public:
+    DiskIOQueue();
+
+    /**
+     * 任务是否在磁盘io线程异步执行
+     * Whether the tasks are executed asynchronously in the disk io thread
+     */
+    bool isAsync() const { return (bool)_poller; }
+
+    /**
+     * 投递磁盘io任务
+     * Deliver a disk io task
+     */
+    void async(std::function<void()> task);
+
+    /**
+     * 等待之前投递的任务全部执行完毕
+     * Wait for all previously delivered tasks to be completed
+     */
+    void sync();
+
+private:
+    toolkit::EventPoller::Ptr _poller;
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_DISKIO_H
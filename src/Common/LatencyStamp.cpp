@@ -0,0 +1,91 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include "LatencyStamp.h"
+#include "Extension/Factory.h"
+#include "Util/util.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+// 打点SEI的uuid，不包含0字节，在码流中不会被插入防竞争字节，可以直接搜索
+// Uuid of the stamp SEI, contains no zero byte, so no emulation prevention byte is inserted into it and it can be searched directly
+static const char s_uuid[] = "ZLM-latency-stmp";
+static constexpr size_t kUuidSize = sizeof(s_uuid) - 1;
+// SEI payload: uuid + 8字节毫秒时间戳(大端)
+// SEI payload: uuid + 8-byte millisecond timestamp (big endian)
+static constexpr size_t kPayloadSize = kUuidSize + 8;
+
+Frame::Ptr LatencyStamp::makeSeiFrame(const Frame::Ptr &frame) {
+    string sei("\x00\x00\x00\x01", 4);
+    switch (frame->getCodecId()) {
+        // NAL_SEI
+        case CodecH264: sei.push_back(6); break;
+        // PREFIX_SEI_NUT, nuh_layer_id = 0, nuh_temporal_id_plus1 = 1
+        case CodecH265: sei.push_back(39 << 1); sei.push_back(1); break;
+        default: return nullptr;
+    }
+    // 每帧只在第一个slice前插入
+    // Insert only before the first slice of each frame
+    if (frame->configFrame() || frame->dropAble() || !frame->decodeAble()) {
+        return nullptr;
+    }
+    // payload_type: user_data_unregistered
+    sei.push_back(5);
+    sei.push_back(kPayloadSize);
+    sei.append(s_uuid, kUuidSize);
+
+    auto stamp = getCurrentMillisecond(true);
+    int zeros = 0;
+    for (int i = 7; i >= 0; --i) {
+        uint8_t byte = (stamp >> (i * 8)) & 0xFF;
+        if (zeros >= 2 && byte <= 3) {
+            // 防竞争字节
+            // Emulation prevention byte
+            sei.push_back(3);
+            zeros = 0;
+        }
+        sei.push_back(byte);
+        zeros = byte ? 0 : zeros + 1;
+    }
+    // rbsp_trailing_bits
+    sei.push_back((char)0x80);
+    return Factory::getFrameFromBuffer(frame->getCodecId(), std::make_shared<BufferString>(std::move(sei)), frame->dts(), frame->pts());
+}
+
+bool LatencyStamp::parse(const char *data, size_t size, uint64_t &stamp_ms) {
+    auto end = data + size;
+    auto pos = std::search(data, end, s_uuid, s_uuid + kUuidSize);
+    if (pos == end) {
+        return false;
+    }
+    pos += kUuidSize;
+    stamp_ms = 0;
+    int zeros = 0;
+    for (int i = 0; i < 8; ++pos) {
+        if (pos == end) {
+            return false;
+        }
+        uint8_t byte = *pos;
+        if (zeros >= 2 && byte == 3) {
+            zeros = 0;
+            continue;
+        }
+        stamp_ms = (stamp_ms << 8) | byte;
+        zeros = byte ? 0 : zeros + 1;
+        ++i;
+    }
+    return true;
+}
+
+} // namespace mediakit
@@ -0,0 +1,55 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_LATENCYSTAMP_H
+#define ZLMEDIAKIT_LATENCYSTAMP_H
+
+#include "Extension/Frame.h"
+
+namespace mediakit {
+
+/**
+ * 端到端延时打点
+ * 在h264/h265视频帧前插入SEI(user_data_unregistered)，携带该帧进入MultiMediaSourceMuxer时(解复用完成后)的系统时间(毫秒)，
+ * SEI属于码流的一部分，会原样到达rtsp/rtmp/flv/hls/webrtc等所有协议的播放端，播放端解析后与本地系统时间相减即为端到端延时
+ * End-to-end latency stamp
+ * Insert an SEI (user_data_unregistered) before h264/h265 video frames, carrying the system time (milliseconds) when the frame enters MultiMediaSourceMuxer (after demuxing),
+ * the SEI is part of the bitstream and reaches players of all protocols such as rtsp/rtmp/flv/hls/webrtc unchanged,
+ * the player parses it and subtracts it from the local system time to get the end-to-end latency
+ */
+class LatencyStamp {
+public:
+    /**
+     * 生成携带当前系统时间的SEI帧
+     * @param frame 该SEI之后的视频帧，SEI与其时间戳相同
+     * @return 不是h264/h265或者不是一帧的第一个slice时返回nullptr
+     * Generate an SEI frame carrying the current system time
+     * @param frame The video frame after this SEI, the SEI has the same timestamp as it
+     * @return nullptr if it is not h264/h265 or not the first slice of a frame
+     */
+    static Frame::Ptr makeSeiFrame(const Frame::Ptr &frame);
+
+    /**
+     * 从h264/h265码流中提取打点时间
+     * @param data 码流，可包含多个nal
+     * @param size 码流长度
+     * @param stamp_ms 打点时的系统时间，单位毫秒
+     * @return 是否找到打点
+     * Extract the stamp time from the h264/h265 bitstream
+     * @param data Bitstream, may contain multiple nal units
+     * @param size Bitstream length
+     * @param stamp_ms The system time when stamped, in milliseconds
+     * @return Whether the stamp is found
+     */
+    static bool parse(const char *data, size_t size, uint64_t &stamp_ms);
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_LATENCYSTAMP_H
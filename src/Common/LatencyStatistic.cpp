@@ -0,0 +1,224 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <chrono>
+#include "LatencyStatistic.h"
+#include "Common/config.h"
+#include "Util/util.h"
+
+using namespace std;
+
+namespace mediakit {
+
+const char *getLatencyStageName(LatencyStage stage) {
+    switch (stage) {
+        case kLatencySplit: return "split";
+        case kLatencySort: return "sort";
+        case kLatencyAssemble: return "assemble";
+        case kLatencyMuxer: return "muxer";
+        case kLatencyProtocol: return "protocol";
+        case kLatencyDispatch: return "dispatch";
+        default: return "invalid";
+    }
+}
+
+static inline uint64_t nowUS() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+////////////////////////////////////////////LatencyHistogram////////////////////////////////////////////
+
+LatencyHistogram::LatencyHistogram() {
+    _count = 0;
+    _sum = 0;
+    _max = 0;
+    for (auto &bucket : _buckets) {
+        bucket = 0;
+    }
+}
+
+size_t LatencyHistogram::getBucket(uint64_t us) {
+    if (us < 2 * kSubBuckets) {
+        return us;
+    }
+    // 最高位的位置，至少为4
+    // Position of the highest bit, at least 4
+    size_t msb = 0;
+#if defined(__GNUC__) || defined(__clang__)
+    msb = 63 - __builtin_clzll(us);
+#else
+    for (auto val = us; val >>= 1;) {
+        ++msb;
+    }
+#endif
+    auto sub = (us >> (msb - 3)) & (kSubBuckets - 1);
+    auto bucket = 2 * kSubBuckets + (msb - 4) * kSubBuckets + sub;
+    return bucket < kBucketCount ? bucket : kBucketCount - 1;
+}
+
+uint64_t LatencyHistogram::getBucketValue(size_t bucket) {
+    if (bucket < 2 * kSubBuckets) {
+        return bucket;
+    }
+    auto msb = (bucket - 2 * kSubBuckets) / kSubBuckets + 4;
+    auto sub = (bucket - 2 * kSubBuckets) % kSubBuckets;
+    // 返回桶的上界
+    // Return the upper bound of the bucket
+    return ((kSubBuckets + sub + 1) << (msb - 3)) - 1;
+}
+
+void LatencyHistogram::record(uint64_t us) {
+    _buckets[getBucket(us)].fetch_add(1, memory_order_relaxed);
+    _count.fetch_add(1, memory_order_relaxed);
+    _sum.fetch_add(us, memory_order_relaxed);
+    auto max = _max.load(memory_order_relaxed);
+    while (us > max && !_max.compare_exchange_weak(max, us, memory_order_relaxed));
+}
+
+LatencyHistogram::Value LatencyHistogram::getValue() const {
+    Value ret;
+    uint64_t buckets[kBucketCount];
+    uint64_t count = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        buckets[i] = _buckets[i].load(memory_order_relaxed);
+        count += buckets[i];
+    }
+    if (!count) {
+        return ret;
+    }
+    ret.count = count;
+    ret.avg = _sum.load(memory_order_relaxed) / MAX(_count.load(memory_order_relaxed), 1);
+    ret.max = _max.load(memory_order_relaxed);
+
+    struct {
+        double ratio;
+        uint64_t *value;
+    } percentiles[] = { { 0.5, &ret.p50 }, { 0.9, &ret.p90 }, { 0.99, &ret.p99 }, { 0.999, &ret.p999 } };
+    uint64_t seen = 0;
+    size_t index = 0;
+    for (size_t i = 0; i < kBucketCount && index < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+        seen += buckets[i];
+        while (index < sizeof(percentiles) / sizeof(percentiles[0]) && seen >= percentiles[index].ratio * count) {
+            // 桶上界可能超过实际最大值
+            // The upper bound of the bucket may exceed the actual maximum value
+            *percentiles[index].value = MIN(getBucketValue(i), ret.max);
+            ++index;
+        }
+    }
+    return ret;
+}
+
+////////////////////////////////////////////StreamLatency////////////////////////////////////////////
+
+bool StreamLatency::enabled() {
+    GET_CONFIG(bool, enable, General::kLatencyStatistic);
+    return enable;
+}
+
+////////////////////////////////////////////LatencyTrace////////////////////////////////////////////
+
+namespace {
+struct TraceContext {
+    bool active = false;
+    // 已经过的阶段
+    // Stages that have been passed
+    uint32_t visited = 0;
+    // 上个阶段结束时间
+    // End time of the previous stage
+    uint64_t last = 0;
+    // 上个阶段结束时累计的分发耗时
+    // Accumulated dispatching time at the end of the previous stage
+    uint64_t dispatch_mark = 0;
+    uint64_t stages[kLatencyStageMax] = { 0 };
+};
+} // namespace
+
+static thread_local TraceContext s_trace;
+
+static void beginTrace() {
+    s_trace.active = true;
+    s_trace.visited = 0;
+    s_trace.last = nowUS();
+    s_trace.dispatch_mark = 0;
+    for (auto &stage : s_trace.stages) {
+        stage = 0;
+    }
+}
+
+void LatencyTrace::mark(LatencyStage stage) {
+    if (!s_trace.active) {
+        return;
+    }
+    auto now = nowUS();
+    // 期间的分发耗时单独统计，不计入本阶段
+    // The dispatching time during this period is counted separately, not included in this stage
+    auto dispatch = s_trace.stages[kLatencyDispatch] - s_trace.dispatch_mark;
+    auto cost = now - s_trace.last;
+    s_trace.stages[stage] += cost > dispatch ? cost - dispatch : 0;
+    s_trace.visited |= 1 << stage;
+    s_trace.last = now;
+    s_trace.dispatch_mark = s_trace.stages[kLatencyDispatch];
+}
+
+bool LatencyTrace::isActive() {
+    return s_trace.active;
+}
+
+LatencyTrace::Scope::Scope(StreamLatency *stat) {
+    _stat = stat;
+    if (!StreamLatency::enabled()) {
+        _stat = nullptr;
+        return;
+    }
+    if (s_trace.active) {
+        if (_stat) {
+            // 由网络会话开始的追踪，此前为解复用阶段
+            // Tracing started by the network session, the previous stage is demuxing
+            mark(kLatencyAssemble);
+        }
+        return;
+    }
+    _own = true;
+    beginTrace();
+}
+
+LatencyTrace::Scope::~Scope() {
+    if (_stat && s_trace.active) {
+        for (int i = 0; i < kLatencyStageMax; ++i) {
+            if (s_trace.visited & (1 << i)) {
+                _stat->record((LatencyStage)i, s_trace.stages[i]);
+            }
+            s_trace.stages[i] = 0;
+        }
+        // 同一次网络数据可能输出多帧，后续帧从此处重新计时
+        // The same network data may output multiple frames, subsequent frames are timed again from here
+        s_trace.visited = 0;
+        s_trace.dispatch_mark = 0;
+        s_trace.last = nowUS();
+    }
+    if (_own) {
+        s_trace.active = false;
+    }
+}
+
+LatencyTrace::Dispatch::Dispatch() {
+    if (s_trace.active) {
+        _start = nowUS();
+    }
+}
+
+LatencyTrace::Dispatch::~Dispatch() {
+    if (_start) {
+        s_trace.stages[kLatencyDispatch] += nowUS() - _start;
+        s_trace.visited |= 1 << kLatencyDispatch;
+    }
+}
+
+} // namespace mediakit
@@ -0,0 +1,159 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_LATENCYSTATISTIC_H
+#define ZLMEDIAKIT_LATENCYSTATISTIC_H
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+namespace mediakit {
+
+/**
+ * 流处理流水线的各个阶段
+ * Stages of the stream processing pipeline
+ */
+typedef enum {
+    // 从读取socket数据到拆分出rtp/rtmp包
+    // From reading the socket data to splitting out the rtp/rtmp packet
+    kLatencySplit = 0,
+    // rtp排序
+    // Rtp sorting
+    kLatencySort,
+    // rtp/rtmp解复用为帧
+    // Demuxing rtp/rtmp into frames
+    kLatencyAssemble,
+    // MultiMediaSourceMuxer自身的处理(时间戳修正、gop缓存等)
+    // Processing of MultiMediaSourceMuxer itself (timestamp revising, gop cache, etc.)
+    kLatencyMuxer,
+    // 各协议复用器打包
+    // Packaging by the protocol muxers
+    kLatencyProtocol,
+    // 写入环形缓存并投递到播放器所在线程
+    // Writing to the ring buffer and delivering to the threads of the players
+    kLatencyDispatch,
+    kLatencyStageMax
+} LatencyStage;
+
+const char *getLatencyStageName(LatencyStage stage);
+
+/**
+ * 对数分桶的延时直方图(单位微秒)，每个2的幂区间分为8个桶，相对误差不超过12.5%
+ * 写入无锁，可在其他线程读取
+ * Latency histogram with logarithmic buckets (in microseconds), each power-of-two range is divided into 8 buckets,
+ * the relative error does not exceed 12.5%
+ * Writing is lock-free, and it can be read from other threads
+ */
+class LatencyHistogram {
+public:
+    struct Value {
+        uint64_t count = 0;
+        uint64_t avg = 0;
+        uint64_t max = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+        uint64_t p999 = 0;
+    };
+
+    LatencyHistogram();
+
+    void record(uint64_t us);
+    Value getValue() const;
+
+private:
+    static constexpr size_t kSubBuckets = 8;
+    static constexpr size_t kBucketCount = 2 * kSubBuckets + 32 * kSubBuckets;
+
+    static size_t getBucket(uint64_t us);
+    static uint64_t getBucketValue(size_t bucket);
+
+private:
+    std::atomic<uint64_t> _count;
+    std::atomic<uint64_t> _sum;
+    std::atomic<uint64_t> _max;
+    std::atomic<uint64_t> _buckets[kBucketCount];
+};
+
+/**
+ * 单路流各阶段的延时统计
+ * Latency statistics of each stage of a stream
+ */
+class StreamLatency {
+public:
+    using Ptr = std::shared_ptr<StreamLatency>;
+
+    /**
+     * 是否开启延时统计(general.latency_statistic)
+     * Whether latency statistics is enabled (general.latency_statistic)
+     */
+    static bool enabled();
+
+    void record(LatencyStage stage, uint64_t us) { _stages[stage].record(us); }
+    LatencyHistogram::Value getValue(LatencyStage stage) const { return _stages[stage].getValue(); }
+
+private:
+    LatencyHistogram _stages[kLatencyStageMax];
+};
+
+/**
+ * 线程内的延时追踪，网络数据在同一线程内同步经过拆包、排序、解复用、转协议与分发，
+ * 各阶段通过mark记录耗时，在MultiMediaSourceMuxer输出一帧后提交到该流的统计
+ * In-thread latency tracing, the network data passes through splitting, sorting, demuxing, protocol muxing
+ * and dispatching synchronously in the same thread, each stage records its time cost with mark,
+ * and it is committed to the statistics of the stream after MultiMediaSourceMuxer outputs a frame
+ */
+class LatencyTrace {
+public:
+    /**
+     * 追踪作用域，收到网络数据时或MultiMediaSourceMuxer输入帧时创建
+     * @param stat 不为空时，在作用域结束时把追踪结果提交给该流
+     * Tracing scope, created when network data is received or when MultiMediaSourceMuxer inputs a frame
+     * @param stat When it is not null, the tracing result is committed to this stream at the end of the scope
+     */
+    class Scope {
+    public:
+        explicit Scope(StreamLatency *stat = nullptr);
+        ~Scope();
+
+    private:
+        bool _own = false;
+        StreamLatency *_stat;
+    };
+
+    /**
+     * 分发耗时统计作用域，包裹环形缓存写操作
+     * Scope of dispatching time statistics, wrapping the ring buffer write operation
+     */
+    class Dispatch {
+    public:
+        Dispatch();
+        ~Dispatch();
+
+    private:
+        uint64_t _start = 0;
+    };
+
+    /**
+     * 记录上个阶段结束到现在的耗时为stage阶段的耗时
+     * Record the time from the end of the previous stage to now as the time cost of the stage
+     */
+    static void mark(LatencyStage stage);
+
+    /**
+     * 当前线程是否正在追踪
+     * Whether the current thread is tracing
+     */
+    static bool isActive();
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_LATENCYSTATISTIC_H
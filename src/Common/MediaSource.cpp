@@ -18,6 +18,7 @@
 #include "Common/MultiMediaSourceMuxer.h"
 #include "Record/MP4Reader.h"
 #include "PacketCache.h"
+#include "Metrics.h"
 
 using namespace std;
 using namespace toolkit;
@@ -28,12 +29,51 @@ namespace toolkit {
 
 namespace mediakit {
 
-static recursive_mutex s_media_source_mtx;
 using StreamMap = unordered_map<string/*strema_id*/, weak_ptr<MediaSource> >;
 using AppStreamMap = unordered_map<string/*app*/, StreamMap>;
 using VhostAppStreamMap = unordered_map<string/*vhost*/, AppStreamMap>;
 using SchemaVhostAppStreamMap = unordered_map<string/*schema*/, VhostAppStreamMap>;
-static SchemaVhostAppStreamMap s_media_source_map;
+
+// 媒体源注册表分片个数，同一个vhost/app/stream的所有协议都落在同一个分片
+// Number of media source registry shards, all schemas of the same vhost/app/stream fall in the same shard
+static constexpr size_t kMediaSourceShardCount = 64;
+
+// 媒体源注册表分片，采用写时复制：查找时原子读取只读快照，无需加锁；注册与注销时在分片锁内拷贝修改后再发布
+// Media source registry shard, copy-on-write: lookups atomically load a read-only snapshot without locking,
+// registration and unregistration copy, modify and publish the map under the shard lock
+class MediaSourceShard {
+public:
+    using MapPtr = std::shared_ptr<const SchemaVhostAppStreamMap>;
+
+    MediaSourceShard() : _map(std::make_shared<SchemaVhostAppStreamMap>()) {}
+
+    MapPtr snapshot() const { return std::atomic_load(&_map); }
+
+    // 在分片锁内修改注册表的拷贝并发布
+    // Modify a copy of the registry under the shard lock and publish it
+    template <typename FUNC>
+    void update(FUNC &&func) {
+        std::lock_guard<std::mutex> lck(_mtx);
+        auto copy = std::make_shared<SchemaVhostAppStreamMap>(*std::atomic_load(&_map));
+        if (func(*copy)) {
+            std::atomic_store(&_map, MapPtr(std::move(copy)));
+        }
+    }
+
+private:
+    std::mutex _mtx;
+    MapPtr _map;
+};
+
+static MediaSourceShard s_media_source_shards[kMediaSourceShardCount];
+
+static size_t getShardIndex(const string &vhost, const string &app, const string &stream) {
+    std::hash<string> hasher;
+    auto ret = hasher(vhost);
+    ret ^= hasher(app) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
+    ret ^= hasher(stream) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
+    return ret % kMediaSourceShardCount;
+}
 
 string getOriginTypeString(MediaOriginType type){
 #define SWITCH_CASE(type) case MediaOriginType::type : return #type
@@ -91,6 +131,7 @@ MediaSource::~MediaSource() {
     } catch (std::exception &ex) {
         WarnL << "Exception occurred: " << ex.what();
     }
+    Metrics::onReaderChanged(_schema, -_metrics_readers.exchange(0));
 }
 
 std::shared_ptr<void> MediaSource::getOwnership() {
@@ -247,6 +288,7 @@ std::shared_ptr<RtpProcess> MediaSource::getRtpProcess() const {
 }
 
 void MediaSource::onReaderChanged(int size) {
+    Metrics::onReaderChanged(_schema, size - _metrics_readers.exchange(size));
     try {
         weak_ptr<MediaSource> weak_self = shared_from_this();
         getOwnerPoller()->async([weak_self, size]() {
@@ -347,9 +389,16 @@ void MediaSource::for_each_media(const function<void(const Ptr &src)> &cb,
                                  const string &app,
                                  const string &stream) {
     deque<Ptr> src_list;
-    {
-        lock_guard<recursive_mutex> lock(s_media_source_mtx);
-        for_each_media_l(s_media_source_map, src_list, schema, vhost, app, stream);
+    if (!vhost.empty() && !app.empty() && !stream.empty()) {
+        // 指定了完整的vhost/app/stream，只需查找一个分片
+        // The full vhost/app/stream is specified, only one shard needs to be searched
+        auto map = s_media_source_shards[getShardIndex(vhost, app, stream)].snapshot();
+        for_each_media_l(*map, src_list, schema, vhost, app, stream);
+    } else {
+        for (auto &shard : s_media_source_shards) {
+            auto map = shard.snapshot();
+            for_each_media_l(*map, src_list, schema, vhost, app, stream);
+        }
     }
     for (auto &src : src_list) {
         cb(src);
@@ -493,6 +542,9 @@ MediaSource::Ptr MediaSource::find(const string &vhost, const string &app, const
 }
 
 void MediaSource::emitEvent(bool regist){
+    if (_metrics_registered.exchange(regist) != regist) {
+        Metrics::onMediaChanged(_schema, regist);
+    }
     auto listener = _listener.lock();
     if (listener) {
         // 触发回调  [AUTO-TRANSLATED:08ea452d]
@@ -506,40 +558,49 @@ void MediaSource::emitEvent(bool regist){
 }
 
 void MediaSource::regist() {
-    {
-        // 减小互斥锁临界区  [AUTO-TRANSLATED:1309d309]
-        // Reduce mutex lock critical area
-        lock_guard<recursive_mutex> lock(s_media_source_mtx);
-        auto &ref = s_media_source_map[_schema][_tuple.vhost][_tuple.app][_tuple.stream];
-        auto src = ref.lock();
+    // 在锁外释放旧的媒体源，防止其析构时反注册导致死锁
+    // Release the old media source outside the lock to prevent deadlock caused by unregistration during its destruction
+    MediaSource::Ptr src;
+    bool existed = false;
+    auto self = shared_from_this();
+    s_media_source_shards[getShardIndex(_tuple.vhost, _tuple.app, _tuple.stream)].update([&](SchemaVhostAppStreamMap &map) {
+        auto &ref = map[_schema][_tuple.vhost][_tuple.app][_tuple.stream];
+        src = ref.lock();
         if (src) {
-            if (src.get() == this) {
-                return;
-            }
-            // 增加判断, 防止当前流已注册时再次注册  [AUTO-TRANSLATED:ccc5dcb1]
-            // Add judgment to prevent re-registration when the current stream is already registered
-            throw std::invalid_argument("media source already existed:" + getUrl());
+            existed = true;
+            return false;
+        }
+        ref = self;
+        return true;
+    });
+    if (existed) {
+        if (src.get() == this) {
+            return;
         }
-        ref = shared_from_this();
+        // 增加判断, 防止当前流已注册时再次注册  [AUTO-TRANSLATED:ccc5dcb1]
+        // Add judgment to prevent re-registration when the current stream is already registered
+        throw std::invalid_argument("media source already existed:" + getUrl());
     }
     emitEvent(true);
 }
 
 template<typename MAP, typename First, typename ...KeyTypes>
-static bool erase_media_source(bool &hit, const MediaSource *thiz, MAP &map, const First &first, const KeyTypes &...keys) {
+static bool erase_media_source(bool &hit, MediaSource::Ptr &holder, const MediaSource *thiz, MAP &map, const First &first, const KeyTypes &...keys) {
     auto it = map.find(first);
-    if (it != map.end() && erase_media_source(hit, thiz, it->second, keys...)) {
+    if (it != map.end() && erase_media_source(hit, holder, thiz, it->second, keys...)) {
         map.erase(it);
     }
     return map.empty();
 }
 
 template<typename MAP, typename First>
-static bool erase_media_source(bool &hit, const MediaSource *thiz, MAP &map, const First &first) {
+static bool erase_media_source(bool &hit, MediaSource::Ptr &holder, const MediaSource *thiz, MAP &map, const First &first) {
     auto it = map.find(first);
     if (it != map.end()) {
-        auto src = it->second.lock();
-        if (!src || src.get() == thiz) {
+        // 由外部持有强引用，防止在分片锁内析构媒体源
+        // The strong reference is held by the caller to prevent destructing the media source inside the shard lock
+        holder = it->second.lock();
+        if (!holder || holder.get() == thiz) {
             // 对象已经销毁或者对象就是自己，那么移除之  [AUTO-TRANSLATED:1b9a11d1]
             // If the object has been destroyed or the object is itself, then remove it
             map.erase(it);
@@ -553,12 +614,11 @@ static bool erase_media_source(bool &hit, const MediaSource *thiz, MAP &map, con
 // Unregister the source
 bool MediaSource::unregist() {
     bool ret = false;
-    {
-        // 减小互斥锁临界区  [AUTO-TRANSLATED:1309d309]
-        // Reduce mutex lock critical area
-        lock_guard<recursive_mutex> lock(s_media_source_mtx);
-        erase_media_source(ret, this, s_media_source_map, _schema, _tuple.vhost, _tuple.app, _tuple.stream);
-    }
+    MediaSource::Ptr holder;
+    s_media_source_shards[getShardIndex(_tuple.vhost, _tuple.app, _tuple.stream)].update([&](SchemaVhostAppStreamMap &map) {
+        erase_media_source(ret, holder, this, map, _schema, _tuple.vhost, _tuple.app, _tuple.stream);
+        return ret;
+    });
 
     if (ret) {
         emitEvent(false);
@@ -874,6 +934,60 @@ std::shared_ptr<MediaSourceEvent> MediaSourceEventInterceptor::getDelegate() con
     return _listener.lock();
 }
 
+/////////////////////////////////////GopCacheBudget//////////////////////////////////////
+
+static atomic<size_t> s_gop_cache_bytes { 0 };
+
+size_t GopCacheBudget::totalBytes() {
+    return s_gop_cache_bytes.load();
+}
+
+void GopCacheBudget::reset() {
+    s_gop_cache_bytes -= _bytes;
+    _bytes = 0;
+    _size = 0;
+    // 环形缓存被清空后，直到下个关键帧才重新开始缓存
+    // After the ring buffer is cleared, caching restarts at the next key frame
+    _dropped = true;
+}
+
+bool GopCacheBudget::onWrite(size_t bytes, bool is_key, size_t max_size, int reader_count) {
+    if (is_key) {
+        // 新的gop开始，环形缓存会移除之前的gop
+        // A new gop starts, the ring buffer removes the previous gop
+        reset();
+        _dropped = false;
+    }
+    if (_dropped) {
+        return true;
+    }
+    _bytes += bytes;
+    s_gop_cache_bytes += bytes;
+    if (++_size > max_size && max_size) {
+        // 环形缓存溢出，环形缓存会自行清空gop缓存
+        // Ring buffer overflow, the ring buffer clears the gop cache by itself
+        reset();
+        return true;
+    }
+
+    GET_CONFIG(size_t, max_kb, General::kGopCacheMaxKB);
+    GET_CONFIG(size_t, total_max_mb, General::kGopCacheTotalMaxMB);
+    if (max_kb && _bytes > max_kb * 1024) {
+        // 单个gop超过单流预算
+        // A single gop exceeds the per-stream budget
+        DebugL << "Gop cache exceeds per-stream budget, drop it until next key frame: " << _bytes.load();
+        reset();
+        return true;
+    }
+    if (total_max_mb && !reader_count && s_gop_cache_bytes > (total_max_mb << 20)) {
+        // 超过全局预算，无人观看的流不再缓存gop
+        // Exceeds the server-wide budget, streams without readers stop caching gop
+        reset();
+        return true;
+    }
+    return false;
+}
+
 /////////////////////////////////////FlushPolicy//////////////////////////////////////
 
 static bool isFlushAble_default(bool is_video, uint64_t last_stamp, uint64_t new_stamp, size_t cache_size) {
@@ -280,6 +280,10 @@ public:
     // Whether to generate http[s]-fmp4、ws[s]-fmp4 protocol on demand
     bool fmp4_demand;
 
+    // 是否开启共享gop缓存，按需转协议的第一个播放者由此gop重新打包实现秒开
+    // Whether to enable the shared gop cache, the first player of an on-demand protocol is served by repackaging this gop
+    bool shared_gop_cache;
+
     // 是否将mp4录制当做观看者  [AUTO-TRANSLATED:ba351230]
     // Whether to treat mp4 recording as a viewer
     bool mp4_as_player;
@@ -330,6 +334,7 @@ public:
         GET_OPT_VALUE(rtmp_demand);
         GET_OPT_VALUE(ts_demand);
         GET_OPT_VALUE(fmp4_demand);
+        GET_OPT_VALUE(shared_gop_cache);
 
         GET_OPT_VALUE(mp4_max_second);
         GET_OPT_VALUE(mp4_as_player);
@@ -444,6 +449,9 @@ public:
     // Get data rate, unit bytes/s
     size_t getBytesSpeed(TrackType type = TrackInvalid);
     size_t getTotalBytes(TrackType type = TrackInvalid);
+    // 获取本协议gop缓存占用的字节数
+    // Get the bytes occupied by the gop cache of this protocol
+    virtual size_t getGopCacheBytes() const { return 0; }
 
     // 获取流创建GMT unix时间戳，单位秒  [AUTO-TRANSLATED:0bbe145e]
     // Get the stream creation GMT unix timestamp, unit seconds
@@ -571,6 +579,10 @@ protected:
 
 private:
     std::atomic_flag _owned { false };
+    // 已计入全局统计指标的观看人数与注册状态
+    // Number of readers and registration status counted in the global metrics
+    std::atomic<int> _metrics_readers { 0 };
+    std::atomic<bool> _metrics_registered { false };
     time_t _create_stamp;
     toolkit::Ticker _ticker;
     std::string _schema;
@@ -0,0 +1,241 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <sstream>
+#include <unordered_set>
+#include "Metrics.h"
+#include "PacketCache.h"
+#include "Thread/WorkThreadPool.h"
+#include "Poller/EventPoller.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+namespace {
+
+struct MetricsThreadCounter {
+    MetricsThreadCounter();
+    ~MetricsThreadCounter();
+
+    // 只有所属线程会修改计数，无需原子加
+    // Only the owner thread modifies the counters, no atomic add is needed
+    void add(MetricsProtocol protocol, MetricsCounter counter, uint64_t value) {
+        auto &ref = values[protocol][counter];
+        ref.store(ref.load(memory_order_relaxed) + value, memory_order_relaxed);
+    }
+
+    atomic<uint64_t> values[kMetricsProtocolMax][kMetricsCounterMax];
+};
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry &Instance() {
+        // 不析构，防止线程退出晚于全局对象析构
+        // Never destructed, in case a thread exits after the destruction of global objects
+        static auto s_instance = new MetricsRegistry;
+        return *s_instance;
+    }
+
+    MetricsRegistry() {
+        for (auto &protocol : _retired) {
+            for (auto &value : protocol) {
+                value = 0;
+            }
+        }
+    }
+
+    void add(MetricsThreadCounter *counter) {
+        lock_guard<mutex> lck(_mtx);
+        _counters.emplace(counter);
+    }
+
+    void remove(MetricsThreadCounter *counter) {
+        lock_guard<mutex> lck(_mtx);
+        _counters.erase(counter);
+        // 保留已退出线程的计数
+        // Retain the counters of the exited threads
+        for (int i = 0; i < kMetricsProtocolMax; ++i) {
+            for (int j = 0; j < kMetricsCounterMax; ++j) {
+                _retired[i][j] += counter->values[i][j].load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // 线程退出过程中的计数直接累加到已退出线程的计数上
+    // Counters during thread exit are directly accumulated to the counters of the exited threads
+    void addRetired(MetricsProtocol protocol, MetricsCounter counter, uint64_t value) {
+        _retired[protocol][counter] += value;
+    }
+
+    void getValues(uint64_t (&values)[kMetricsProtocolMax][kMetricsCounterMax]) {
+        lock_guard<mutex> lck(_mtx);
+        for (int i = 0; i < kMetricsProtocolMax; ++i) {
+            for (int j = 0; j < kMetricsCounterMax; ++j) {
+                values[i][j] = _retired[i][j].load(memory_order_relaxed);
+            }
+        }
+        for (auto counter : _counters) {
+            for (int i = 0; i < kMetricsProtocolMax; ++i) {
+                for (int j = 0; j < kMetricsCounterMax; ++j) {
+                    values[i][j] += counter->values[i][j].load(memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    void onGaugeChanged(const string &schema, int readers, int medias) {
+        lock_guard<mutex> lck(_gauge_mtx);
+        auto &gauge = _gauges[schema];
+        gauge.first += readers;
+        gauge.second += medias;
+    }
+
+    map<string, pair<int64_t, int64_t> > getGauges() {
+        lock_guard<mutex> lck(_gauge_mtx);
+        return _gauges;
+    }
+
+private:
+    mutex _mtx;
+    unordered_set<MetricsThreadCounter *> _counters;
+    atomic<uint64_t> _retired[kMetricsProtocolMax][kMetricsCounterMax];
+
+    mutex _gauge_mtx;
+    // schema -> (观看人数, 媒体源个数)
+    // schema -> (number of readers, number of media sources)
+    map<string, pair<int64_t, int64_t> > _gauges;
+};
+
+MetricsThreadCounter::MetricsThreadCounter() {
+    for (auto &protocol : values) {
+        for (auto &value : protocol) {
+            value = 0;
+        }
+    }
+    MetricsRegistry::Instance().add(this);
+}
+
+MetricsThreadCounter::~MetricsThreadCounter() {
+    MetricsRegistry::Instance().remove(this);
+}
+
+} // namespace
+
+static MetricsThreadCounter *getThreadCounter() {
+    static thread_local bool s_exited = false;
+    struct Holder {
+        MetricsThreadCounter counter;
+        ~Holder() { s_exited = true; }
+    };
+    if (s_exited) {
+        return nullptr;
+    }
+    static thread_local Holder s_holder;
+    return &s_holder.counter;
+}
+
+void Metrics::add(MetricsProtocol protocol, MetricsCounter counter, uint64_t value) {
+    auto thread_counter = getThreadCounter();
+    if (thread_counter) {
+        thread_counter->add(protocol, counter, value);
+    } else {
+        MetricsRegistry::Instance().addRetired(protocol, counter, value);
+    }
+}
+
+uint64_t Metrics::get(MetricsProtocol protocol, MetricsCounter counter) {
+    uint64_t values[kMetricsProtocolMax][kMetricsCounterMax];
+    MetricsRegistry::Instance().getValues(values);
+    return values[protocol][counter];
+}
+
+void Metrics::onReaderChanged(const string &schema, int delta) {
+    if (delta) {
+        MetricsRegistry::Instance().onGaugeChanged(schema, delta, 0);
+    }
+}
+
+void Metrics::onMediaChanged(const string &schema, bool regist) {
+    MetricsRegistry::Instance().onGaugeChanged(schema, 0, regist ? 1 : -1);
+}
+
+static const char *getProtocolName(int protocol) {
+    switch (protocol) {
+        case kMetricsRtsp: return "rtsp";
+        case kMetricsRtmp: return "rtmp";
+        case kMetricsRtp: return "rtp";
+        case kMetricsWebrtc: return "webrtc";
+        case kMetricsSrt: return "srt";
+        default: return "invalid";
+    }
+}
+
+static void dumpCounter(stringstream &ss, uint64_t (&values)[kMetricsProtocolMax][kMetricsCounterMax], const char *name, const char *help,
+                        MetricsCounter in, MetricsCounter out) {
+    ss << "# HELP " << name << " " << help << "\n";
+    ss << "# TYPE " << name << " counter\n";
+    for (int i = 0; i < kMetricsProtocolMax; ++i) {
+        if (out == kMetricsCounterMax) {
+            ss << name << "{protocol=\"" << getProtocolName(i) << "\"} " << values[i][in] << "\n";
+            continue;
+        }
+        ss << name << "{protocol=\"" << getProtocolName(i) << "\",direction=\"in\"} " << values[i][in] << "\n";
+        ss << name << "{protocol=\"" << getProtocolName(i) << "\",direction=\"out\"} " << values[i][out] << "\n";
+    }
+}
+
+static void dumpLoad(stringstream &ss, const char *name, const char *help, const vector<int> &loads) {
+    ss << "# HELP " << name << " " << help << "\n";
+    ss << "# TYPE " << name << " gauge\n";
+    int index = 0;
+    for (auto load : loads) {
+        ss << name << "{thread=\"" << index++ << "\"} " << load << "\n";
+    }
+}
+
+string Metrics::dump() {
+    uint64_t values[kMetricsProtocolMax][kMetricsCounterMax];
+    MetricsRegistry::Instance().getValues(values);
+
+    stringstream ss;
+    dumpCounter(ss, values, "zlm_bytes_total", "Bytes received and sent.", kMetricsBytesIn, kMetricsBytesOut);
+    dumpCounter(ss, values, "zlm_packets_total", "Media packets received and sent.", kMetricsPacketsIn, kMetricsPacketsOut);
+    dumpCounter(ss, values, "zlm_packets_lost_total", "Packets lost on receiving, detected by sequence number gaps.", kMetricsPacketsLost, kMetricsCounterMax);
+    dumpCounter(ss, values, "zlm_nack_total", "NACK requests received and sent.", kMetricsNackIn, kMetricsNackOut);
+
+    auto gauges = MetricsRegistry::Instance().getGauges();
+    ss << "# HELP zlm_readers Current number of readers.\n";
+    ss << "# TYPE zlm_readers gauge\n";
+    for (auto &pr : gauges) {
+        ss << "zlm_readers{schema=\"" << pr.first << "\"} " << pr.second.first << "\n";
+    }
+    ss << "# HELP zlm_media_sources Current number of registered media sources.\n";
+    ss << "# TYPE zlm_media_sources gauge\n";
+    for (auto &pr : gauges) {
+        ss << "zlm_media_sources{schema=\"" << pr.first << "\"} " << pr.second.second << "\n";
+    }
+
+    ss << "# HELP zlm_gop_cache_bytes Total bytes of all gop caches.\n";
+    ss << "# TYPE zlm_gop_cache_bytes gauge\n";
+    ss << "zlm_gop_cache_bytes " << GopCacheBudget::totalBytes() << "\n";
+
+    // 负载为各线程自行统计的结果，读取时不投递任务
+    // The load is counted by each thread itself, no task is posted when reading
+    dumpLoad(ss, "zlm_poller_load", "Load percentage of network threads.", EventPollerPool::Instance().getExecutorLoad());
+    dumpLoad(ss, "zlm_work_poller_load", "Load percentage of background worker threads.", WorkThreadPool::Instance().getExecutorLoad());
+    return ss.str();
+}
+
+} // namespace mediakit
@@ -0,0 +1,107 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_METRICS_H
+#define ZLMEDIAKIT_METRICS_H
+
+#include <cstdint>
+#include <string>
+
+namespace mediakit {
+
+/**
+ * 统计计数所属的协议
+ * Protocol to which the metrics counter belongs
+ */
+typedef enum {
+    kMetricsRtsp = 0,
+    kMetricsRtmp,
+    kMetricsRtp,
+    kMetricsWebrtc,
+    kMetricsSrt,
+    kMetricsProtocolMax
+} MetricsProtocol;
+
+/**
+ * 统计计数类型
+ * Metrics counter type
+ */
+typedef enum {
+    // 接收字节数
+    // Received bytes
+    kMetricsBytesIn = 0,
+    // 发送字节数
+    // Sent bytes
+    kMetricsBytesOut,
+    // 接收包数
+    // Received packets
+    kMetricsPacketsIn,
+    // 发送包数
+    // Sent packets
+    kMetricsPacketsOut,
+    // 接收丢包数(根据序号空洞计算)
+    // Lost packets on receiving (calculated from sequence number gaps)
+    kMetricsPacketsLost,
+    // 收到的nack个数
+    // Received nack count
+    kMetricsNackIn,
+    // 发送的nack个数
+    // Sent nack count
+    kMetricsNackOut,
+    kMetricsCounterMax
+} MetricsCounter;
+
+/**
+ * 全局统计指标，用于导出prometheus文本格式
+ * 计数器每个线程独立累加(无锁、无原子加)，导出时汇总；观看人数等gauge在状态变化时更新
+ * Global metrics, exported in prometheus text format
+ * Counters are accumulated independently by each thread (lock-free, no atomic add) and summarized on export;
+ * gauges such as the number of readers are updated when the state changes
+ */
+class Metrics {
+public:
+    /**
+     * 累加当前线程的计数
+     * Accumulate the counter of the current thread
+     */
+    static void add(MetricsProtocol protocol, MetricsCounter counter, uint64_t value = 1);
+
+    /**
+     * 获取所有线程(包括已退出线程)的计数总和
+     * Get the sum of the counter of all threads (including exited threads)
+     */
+    static uint64_t get(MetricsProtocol protocol, MetricsCounter counter);
+
+    /**
+     * 某协议观看人数变化
+     * The number of readers of a protocol changes
+     * @param schema 协议
+     * @param delta 变化量
+     */
+    static void onReaderChanged(const std::string &schema, int delta);
+
+    /**
+     * 某协议媒体源注册或注销
+     * A media source of a protocol is registered or unregistered
+     */
+    static void onMediaChanged(const std::string &schema, bool regist);
+
+    /**
+     * 导出prometheus文本格式(text/plain; version=0.0.4)
+     * 只读取原子变量与少量汇总数据，不访问媒体源列表，也不投递任务到网络线程
+     * Export in prometheus text format (text/plain; version=0.0.4)
+     * Only reads atomic variables and a small amount of summarized data,
+     * does not access the media source list, nor post tasks to network threads
+     */
+    static std::string dump();
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_METRICS_H
@@ -9,8 +9,11 @@
 */
 
 #include <math.h>
+#include <set>
+#include <atomic>
 #include "Common/config.h"
 #include "MultiMediaSourceMuxer.h"
+#include "LatencyStamp.h"
 
 using namespace std;
 using namespace toolkit;
@@ -122,6 +125,152 @@ private:
     std::list<std::pair<uint64_t, Frame::Ptr>> _cache;
 };
 
+/**
+ * 转协议并行流水线线程池，线程个数由general.muxer_threads配置
+ * Thread pool of the parallel muxer pipeline, the number of threads is configured by general.muxer_threads
+ */
+class MuxerWorkerPool : public TaskExecutorGetterImp {
+public:
+    static MuxerWorkerPool &Instance();
+
+    static bool enabled() {
+        GET_CONFIG(size_t, threads, General::kMuxerThreads);
+        return threads > 0;
+    }
+
+    EventPoller::Ptr getPoller() { return static_pointer_cast<EventPoller>(getExecutor()); }
+
+private:
+    MuxerWorkerPool() {
+        GET_CONFIG(size_t, threads, General::kMuxerThreads);
+        addPoller("muxer worker", threads ? threads : 1, ThreadPool::PRIORITY_HIGHEST, false);
+    }
+};
+
+INSTANCE_IMP(MuxerWorkerPool)
+
+/**
+ * 转协议并行流水线，每个复用器对应一个流水线阶段并固定在某个线程执行，
+ * 所以不同复用器之间并行，同一复用器的帧与控制操作按投递顺序串行
+ * Parallel muxer pipeline, each muxer corresponds to a pipeline stage pinned to one thread,
+ * so different muxers run in parallel while the frames and control operations of the same muxer are serialized in delivery order
+ */
+class MuxerPipeline {
+public:
+    enum Stage { kStageRtmp = 0, kStageRtsp, kStageTs, kStageFmp4, kStageHls, kStageHlsFmp4, kStageMp4, kStageMax };
+
+    MuxerPipeline() {
+        for (auto &poller : _stages) {
+            poller = MuxerWorkerPool::Instance().getPoller();
+        }
+        for (auto &depth : _depth) {
+            depth = std::make_shared<std::atomic<size_t>>(0);
+        }
+    }
+
+    static const char *getStageName(Stage stage) {
+        static const char *s_names[kStageMax] = { "rtmp", "rtsp", "ts", "fmp4", "hls", "hls.fmp4", "mp4" };
+        return s_names[stage];
+    }
+
+    /**
+     * 投递控制任务，不受队列深度限制
+     * Deliver a control task, not limited by the queue depth
+     */
+    void async(Stage stage, std::function<void()> task) { _stages[stage]->async(std::move(task), false); }
+
+    /**
+     * 投递帧任务，必须在流的归属线程调用
+     * 队列积压帧数达到general.muxer_queue_size时开始丢帧，直到下一个视频关键帧(纯音频流为下一帧)且队列有空余时恢复，返回false表示丢弃
+     * Deliver a frame task, must be called in the owner thread of the stream
+     * When the number of backlogged frames reaches general.muxer_queue_size, frames are dropped until the next video key frame
+     * (the next frame for audio only streams) arrives and the queue has room again, return false if dropped
+     */
+    bool asyncFrame(Stage stage, const Frame::Ptr &frame, std::function<void()> task) {
+        GET_CONFIG(size_t, max_depth, General::kMuxerQueueSize);
+        auto is_video = frame->getTrackType() == TrackVideo;
+        _has_video[stage] = _has_video[stage] || is_video;
+        if (max_depth) {
+            auto full = *_depth[stage] >= max_depth;
+            if (_dropping[stage]) {
+                auto resume = is_video ? (frame->keyFrame() || frame->configFrame()) : !_has_video[stage];
+                if (full || !resume) {
+                    ++_dropped[stage];
+                    return false;
+                }
+                _dropping[stage] = false;
+            } else if (full) {
+                WarnL << "Muxer pipeline stage " << getStageName(stage) << " is backlogged by " << max_depth << " frames, drop frames until next key frame";
+                _dropping[stage] = true;
+                ++_dropped[stage];
+                return false;
+            }
+        }
+        auto depth = _depth[stage];
+        ++*depth;
+        _stages[stage]->async([depth, task]() {
+            task();
+            --*depth;
+        }, false);
+        return true;
+    }
+
+    /**
+     * 获取某阶段积压的帧数
+     * Get the number of backlogged frames of a stage
+     */
+    size_t getDepth(Stage stage) const { return *_depth[stage]; }
+
+    /**
+     * 获取某阶段因积压而丢弃的帧数
+     * Get the number of frames dropped by a stage due to backlog
+     */
+    size_t getDropped(Stage stage) const { return _dropped[stage]; }
+
+    /**
+     * 等待所有阶段中已投递的任务执行完毕
+     * Wait for the delivered tasks of all stages to be completed
+     */
+    void sync() {
+        std::set<EventPoller *> done;
+        for (auto &poller : _stages) {
+            if (done.emplace(poller.get()).second) {
+                poller->sync([]() {});
+            }
+        }
+    }
+
+private:
+    bool _has_video[kStageMax] = { false };
+    bool _dropping[kStageMax] = { false };
+    std::atomic<size_t> _dropped[kStageMax] {};
+    std::shared_ptr<std::atomic<size_t>> _depth[kStageMax];
+    EventPoller::Ptr _stages[kStageMax];
+};
+
+// 按需转协议的复用器在无人观看时不处理帧
+// On-demand muxers do not process frames when nobody is watching
+template <typename Muxer>
+static auto isMuxerEnabled(Muxer *muxer, int) -> decltype(muxer->isEnabled()) { return muxer->isEnabled(); }
+template <typename Muxer>
+static bool isMuxerEnabled(Muxer *, ...) { return true; }
+
+template <typename Muxer>
+static bool inputFrameToStage(MuxerPipeline *pipeline, MuxerPipeline::Stage stage, const std::shared_ptr<Muxer> &muxer, const Frame::Ptr &frame) {
+    if (!pipeline) {
+        return muxer->inputFrame(frame);
+    }
+    // 帧在流水线线程中异步复用，拿不到复用结果，只在复用器会处理该帧时才投递并返回true
+    // The frame is muxed asynchronously in the pipeline thread, so the mux result is not available,
+    // the frame is only delivered and true returned when the muxer will process it
+    if (!isMuxerEnabled(muxer.get(), 0)) {
+        return false;
+    }
+    // 复用器在流水线线程中持有自身引用，停止录制后等已投递的帧处理完毕再释放
+    // The muxer is referenced by the pipeline task, after stopping recording it is released when the delivered frames are processed
+    return pipeline->asyncFrame(stage, frame, [muxer, frame]() { muxer->inputFrame(frame); });
+}
+
 std::shared_ptr<MediaSinkInterface> MultiMediaSourceMuxer::makeRecorder(MediaSource &sender, Recorder::type type) {
     auto recorder = Recorder::createRecorder(type, sender.getMediaTuple(), _option);
     for (auto &track : getTracks()) {
@@ -183,6 +332,16 @@ std::string MultiMediaSourceMuxer::shortUrl() const {
     return _tuple.shortUrl();
 }
 
+void MultiMediaSourceMuxer::forEachPipelineStage(const std::function<void(const std::string &stage, size_t depth, size_t dropped)> &cb) const {
+    if (!_pipeline) {
+        return;
+    }
+    for (int i = 0; i < MuxerPipeline::kStageMax; ++i) {
+        auto stage = (MuxerPipeline::Stage)i;
+        cb(MuxerPipeline::getStageName(stage), _pipeline->getDepth(stage), _pipeline->getDropped(stage));
+    }
+}
+
 void MultiMediaSourceMuxer::forEachRtpSender(const std::function<void(const std::string &ssrc, const RtpSender &sender)> &cb) const {
     for (auto &pr : _rtp_sender) {
         auto sender = std::get<1>(pr.second).lock();
@@ -225,6 +384,12 @@ MultiMediaSourceMuxer::MultiMediaSourceMuxer(const MediaTuple& tuple, float dur_
     if (option.enable_fmp4) {
         _fmp4 = dynamic_pointer_cast<FMP4MediaSourceMuxer>(Recorder::createRecorder(Recorder::type_fmp4, _tuple, option));
     }
+    if (MuxerWorkerPool::enabled()) {
+        _pipeline = std::make_shared<MuxerPipeline>();
+    }
+    if (StreamLatency::enabled()) {
+        _latency = std::make_shared<StreamLatency>();
+    }
 
     // 音频相关设置  [AUTO-TRANSLATED:6ee58d57]
     // Audio related settings
@@ -274,6 +439,17 @@ int MultiMediaSourceMuxer::totalReaderCount() const {
 }
 
 void MultiMediaSourceMuxer::setTimeStamp(uint32_t stamp) {
+    if (_pipeline) {
+        // 时间戳与帧在同一流水线阶段修改，防止与打包线程竞争
+        // The timestamp is modified in the same pipeline stage as the frames to avoid racing with the muxing thread
+        if (auto rtmp = _rtmp) {
+            _pipeline->async(MuxerPipeline::kStageRtmp, [rtmp, stamp]() { rtmp->setTimeStamp(stamp); });
+        }
+        if (auto rtsp = _rtsp) {
+            _pipeline->async(MuxerPipeline::kStageRtsp, [rtsp, stamp]() { rtsp->setTimeStamp(stamp); });
+        }
+        return;
+    }
     if (_rtmp) {
         _rtmp->setTimeStamp(stamp);
     }
@@ -585,6 +761,11 @@ void MultiMediaSourceMuxer::onAllTrackReady() {
         createGopCacheIfNeed(gop_cache);
     }
 #endif
+    if (_option.shared_gop_cache) {
+        // 共享gop缓存，所有按需转协议共用这一份帧级gop
+        // Shared gop cache, all on-demand protocols share this frame-level gop
+        createGopCacheIfNeed(1);
+    }
 
     Stamp *first = nullptr;
     for (auto &pr : _stamps) {
@@ -597,13 +778,17 @@ void MultiMediaSourceMuxer::onAllTrackReady() {
     InfoL << "stream: " << shortUrl() << " , codec info: " << getTrackInfoStr(this);
 }
 
+// 帧环形缓存最大帧数
+// Maximum number of frames of the frame ring buffer
+static constexpr size_t kFrameRingSize = 1024;
+
 void MultiMediaSourceMuxer::createGopCacheIfNeed(size_t gop_count) {
     if (_ring) {
         return;
     }
     weak_ptr<MultiMediaSourceMuxer> weak_self = shared_from_this();
     auto src = std::make_shared<MediaSourceForMuxer>(weak_self.lock());
-    _ring = std::make_shared<RingType>(1024, [weak_self, src](int size) {
+    _ring = std::make_shared<RingType>(kFrameRingSize, [weak_self, src](int size) {
         if (auto strong_self = weak_self.lock()) {
             // 切换到归属线程  [AUTO-TRANSLATED:abcf859b]
             // Switch to the owning thread
@@ -614,8 +799,72 @@ void MultiMediaSourceMuxer::createGopCacheIfNeed(size_t gop_count) {
     }, gop_count);
 }
 
+const MultiMediaSourceMuxer::RingType::Ptr &MultiMediaSourceMuxer::getFrameRing() {
+    createGopCacheIfNeed(1);
+    _frame_ring_used = true;
+    _frame_ring_ticker.resetTime();
+    // 无人观看时已跳过解复用，需要立即重新检查，否则要等到下次检查才开始写入
+    // Demuxing is skipped when nobody is watching, check again immediately, otherwise writing starts only at the next check
+    _is_enable = true;
+    _last_check.resetTime();
+    return _ring;
+}
+
+void MultiMediaSourceMuxer::onReaderChanged(MediaSource &sender, int size) {
+    auto &last_size = _protocol_readers[sender.getSchema()];
+    if (!last_size && size && _option.shared_gop_cache) {
+        // 该协议从无人观看变为有人观看，此时协议层(按需转协议时)没有gop缓存，由共享gop重新打包
+        // The protocol changes from no viewers to viewers, the protocol layer (when generated on demand) has no gop cache now, repackage from the shared gop
+        flushSharedGop(sender.getSchema());
+    }
+    last_size = size;
+    MediaSourceEventInterceptor::onReaderChanged(sender, size);
+}
+
+void MultiMediaSourceMuxer::flushSharedGop(const std::string &schema) {
+    MediaSinkInterface::Ptr muxer;
+    auto stage = MuxerPipeline::kStageMax;
+    bool demand = false;
+    if (schema == RTSP_SCHEMA) {
+        muxer = _rtsp;
+        stage = MuxerPipeline::kStageRtsp;
+        demand = _option.rtsp_demand;
+    } else if (schema == RTMP_SCHEMA) {
+        muxer = _rtmp;
+        stage = MuxerPipeline::kStageRtmp;
+        demand = _option.rtmp_demand;
+    } else if (schema == TS_SCHEMA) {
+        muxer = _ts;
+        stage = MuxerPipeline::kStageTs;
+        demand = _option.ts_demand;
+    } else if (schema == FMP4_SCHEMA) {
+        muxer = _fmp4;
+        stage = MuxerPipeline::kStageFmp4;
+        demand = _option.fmp4_demand;
+    }
+    if (!muxer || !demand || !_ring) {
+        // 非按需转协议时，协议层一直有gop缓存，无需重新打包
+        // When the protocol is not generated on demand, the protocol layer always has a gop cache, no need to repackage
+        return;
+    }
+    // 此时该协议的播放者都是新加入的，重新打包的gop只会发给它们，同时填充协议层的gop缓存供后续播放者使用
+    // At this time, all players of this protocol are newly joined, the repackaged gop is only sent to them,
+    // and the protocol layer gop cache is filled at the same time for subsequent players
+    size_t frames = 0;
+    _ring->flushGop([&](const Frame::Ptr &frame) {
+        inputFrameToStage(_pipeline.get(), stage, muxer, frame);
+        ++frames;
+    });
+    DebugL << "Repackage shared gop for " << schema << " , frames: " << frames << " : " << shortUrl();
+}
+
 void MultiMediaSourceMuxer::resetTracks() {
     MediaSink::resetTracks();
+    if (_pipeline) {
+        // 等待流水线中的旧帧处理完毕，之后复用器的重置与添加track都在本线程同步执行
+        // Wait for the old frames in the pipeline to be processed, after that resetting and adding tracks of the muxers are executed synchronously in this thread
+        _pipeline->sync();
+    }
 
     if (_rtmp) {
         _rtmp->resetTracks();
@@ -641,42 +890,62 @@ void MultiMediaSourceMuxer::resetTracks() {
 }
 
 bool MultiMediaSourceMuxer::onTrackFrame(const Frame::Ptr &frame_in) {
+    // 非rtsp/rtmp推流时从此处开始追踪，作用域结束时提交本帧各阶段耗时
+    // When not pushed by rtsp/rtmp, tracing starts here, the time cost of each stage of this frame is committed at the end of the scope
+    LatencyTrace::Scope trace(_latency.get());
     auto frame = frame_in;
     if (_option.modify_stamp != ProtocolOption::kModifyStampOff) {
         // 时间戳不采用原始的绝对时间戳  [AUTO-TRANSLATED:8beb3bf7]
         // Timestamp does not use the original absolute timestamp
         frame = std::make_shared<FrameStamp>(frame, _stamps[frame->getIndex()], _option.modify_stamp);
     }
+    GET_CONFIG(bool, latency_stamp, General::kLatencyStamp);
+    if (latency_stamp && frame->getTrackType() == TrackVideo) {
+        // 在帧前插入携带当前系统时间的SEI，用于播放端测量端到端延时
+        // Insert an SEI carrying the current system time before the frame, used by players to measure the end-to-end latency
+        auto sei = LatencyStamp::makeSeiFrame(frame);
+        if (sei) {
+            _paced_sender ? _paced_sender->inputFrame(sei) : onTrackFrame_l(sei);
+        }
+    }
     return _paced_sender ? _paced_sender->inputFrame(frame) : onTrackFrame_l(frame);
 }
 
 bool MultiMediaSourceMuxer::onTrackFrame_l(const Frame::Ptr &frame_in) {
     auto frame = frame_in;
+    auto pipeline = _pipeline.get();
+    if (pipeline) {
+        // 帧在流水线线程中异步处理，需要CacheAbleFrame
+        // The frame is processed asynchronously in the pipeline threads, so CacheAbleFrame is needed
+        frame = Frame::getCacheAbleFrame(frame);
+    }
+    LatencyTrace::mark(kLatencyMuxer);
     bool ret = false;
     if (_rtmp) {
-        ret = _rtmp->inputFrame(frame) ? true : ret;
+        ret = inputFrameToStage(pipeline, MuxerPipeline::kStageRtmp, _rtmp, frame) ? true : ret;
     }
     if (_rtsp) {
-        ret = _rtsp->inputFrame(frame) ? true : ret;
+        ret = inputFrameToStage(pipeline, MuxerPipeline::kStageRtsp, _rtsp, frame) ? true : ret;
     }
     if (_ts) {
-        ret = _ts->inputFrame(frame) ? true : ret;
+        ret = inputFrameToStage(pipeline, MuxerPipeline::kStageTs, _ts, frame) ? true : ret;
     }
 
     if (_hls) {
-        ret = _hls->inputFrame(frame) ? true : ret;
+        ret = inputFrameToStage(pipeline, MuxerPipeline::kStageHls, _hls, frame) ? true : ret;
     }
 
     if (_hls_fmp4) {
-        ret = _hls_fmp4->inputFrame(frame) ? true : ret;
+        ret = inputFrameToStage(pipeline, MuxerPipeline::kStageHlsFmp4, _hls_fmp4, frame) ? true : ret;
     }
 
     if (_mp4) {
-        ret = _mp4->inputFrame(frame) ? true : ret;
+        ret = inputFrameToStage(pipeline, MuxerPipeline::kStageMp4, _mp4, frame) ? true : ret;
     }
     if (_fmp4) {
-        ret = _fmp4->inputFrame(frame) ? true : ret;
+        ret = inputFrameToStage(pipeline, MuxerPipeline::kStageFmp4, _fmp4, frame) ? true : ret;
     }
+    LatencyTrace::mark(kLatencyProtocol);
     if (_ring) {
         // 此场景由于直接转发，可能存在切换线程引起的数据被缓存在管道，所以需要CacheAbleFrame  [AUTO-TRANSLATED:528afbb7]
         // In this scenario, due to direct forwarding, there may be data cached in the pipeline due to thread switching, so CacheAbleFrame is needed
@@ -685,16 +954,17 @@ bool MultiMediaSourceMuxer::onTrackFrame_l(const Frame::Ptr &frame_in) {
             // 视频时，遇到第一帧配置帧或关键帧则标记为gop开始处  [AUTO-TRANSLATED:66247aa8]
             // When it is a video, if the first frame configuration frame or key frame is encountered, it is marked as the beginning of the GOP
             auto video_key_pos = frame->keyFrame() || frame->configFrame();
-            _ring->write(frame, video_key_pos && !_video_key_pos);
+            _gop_budget.writePacket(*_ring, frame, video_key_pos && !_video_key_pos, kFrameRingSize);
             if (!frame->dropAble()) {
                 _video_key_pos = video_key_pos;
             }
         } else {
             // 没有视频时，设置is_key为true，目的是关闭gop缓存  [AUTO-TRANSLATED:f3223755]
             // When there is no video, set is_key to true to disable gop caching
-            _ring->write(frame, !haveVideo());
+            _gop_budget.writePacket(*_ring, frame, !haveVideo(), kFrameRingSize);
         }
     }
+    LatencyTrace::mark(kLatencyMuxer);
     return ret;
 }
 
@@ -705,15 +975,29 @@ bool MultiMediaSourceMuxer::isEnabled(){
         // When no one is watching, check each time if there is really no one watching
         // 有人观看时，则延迟一定时间检查一遍是否无人观看了(节省性能)  [AUTO-TRANSLATED:a7dfddc4]
         // When someone is watching, check again after a certain delay to see if no one is watching (save performance)
-        _is_enable = (_rtmp ? _rtmp->isEnabled() : false) ||
+        // 共享gop缓存需要一直写入，否则第一个播放者拿到的是空gop
+        // The shared gop cache must always be written, otherwise the first player gets an empty gop
+        auto was_enable = _is_enable;
+        _is_enable = _option.shared_gop_cache ||
+                     (_rtmp ? _rtmp->isEnabled() : false) ||
                      (_rtsp ? _rtsp->isEnabled() : false) ||
                      (_ts ? _ts->isEnabled() : false) ||
                      (_fmp4 ? _fmp4->isEnabled() : false) ||
                      (_ring ? (bool)_ring->readerCount() : false)  ||
+                     // 进程内消费者(例如gop缓存截图)最近使用过帧环形缓存，保持写入
+                     // In-process consumers (such as gop cache snapshots) used the frame ring recently, keep writing
+                     (_frame_ring_used && _frame_ring_ticker.elapsedTime() < stream_none_reader_delay_ms) ||
                      (_hls ? _hls->isEnabled() : false) ||
                      (_hls_fmp4 ? _hls_fmp4->isEnabled() : false) ||
                      _mp4;
 
+        if (was_enable && !_is_enable && _ring) {
+            // 之后不再解复用，帧环形缓存中的gop会越来越旧，清空它，防止之后的进程内消费者(例如截图)拿到过期的画面
+            // No more demuxing from now on, the gop in the frame ring would get older and older,
+            // clear it to prevent later in-process consumers (such as snapshots) from getting an outdated picture
+            _ring->clearCache();
+            _gop_budget.reset();
+        }
         if (_is_enable) {
             // 无人观看时，不刷新计时器,因为无人观看时每次都会检查一遍，所以刷新计数器无意义且浪费cpu  [AUTO-TRANSLATED:03ab47cf]
             // When no one is watching, do not refresh the timer, because each time no one is watching, it will be checked, so refreshing the counter is meaningless and wastes cpu
@@ -14,6 +14,8 @@
 #include "Common/Stamp.h"
 #include "Common/MediaSource.h"
 #include "Common/MediaSink.h"
+#include "Common/PacketCache.h"
+#include "Common/LatencyStatistic.h"
 #include "Record/Recorder.h"
 #include "Rtp/RtpSender.h"
 #include "Record/HlsRecorder.h"
@@ -190,12 +192,48 @@ public:
      */
     std::shared_ptr<MultiMediaSourceMuxer> getMuxer(MediaSource &sender) const override;
 
+    /**
+     * 观看人数变化，开启共享gop缓存时，按需转协议的第一个播放者由共享gop重新打包
+     * Notify the change in the number of viewers, when the shared gop cache is enabled,
+     * the first player of an on-demand protocol is served by repackaging the shared gop
+     */
+    void onReaderChanged(MediaSource &sender, int size) override;
+
     const ProtocolOption &getOption() const;
     const MediaTuple &getMediaTuple() const;
     std::string shortUrl() const;
 
     void forEachRtpSender(const std::function<void(const std::string &ssrc, const RtpSender &sender)> &cb) const;
 
+    /**
+     * 遍历转协议并行流水线各阶段积压的帧数与丢弃的帧数，未开启general.muxer_threads时不回调
+     * Traverse the number of backlogged frames and dropped frames of each stage of the parallel muxer pipeline,
+     * no callback when general.muxer_threads is not enabled
+     */
+    void forEachPipelineStage(const std::function<void(const std::string &stage, size_t depth, size_t dropped)> &cb) const;
+
+    /**
+     * 获取流水线延时统计，未开启general.latency_statistic时返回空
+     * Get the pipeline latency statistics, return null when general.latency_statistic is not enabled
+     */
+    const StreamLatency::Ptr &getLatency() const { return _latency; }
+
+    /**
+     * 获取帧环形缓存(不存在时创建)，用于进程内直接消费该流的帧(例如解码)，必须在归属线程调用
+     * 最后一次调用后的streamNoneReaderDelayMS内，即使无人观看也会一直写入该缓存，以便下次调用时(例如定期截图)能拿到最新的gop
+     * Get the frame ring buffer (created if not exists), used to consume the frames of this stream in process (such as decoding), must be called in the owner thread
+     * Within streamNoneReaderDelayMS after the last call, the cache keeps being written even if nobody is watching,
+     * so that the next call (such as a periodic snapshot) gets the latest gop
+     */
+    const RingType::Ptr &getFrameRing();
+
+    /**
+     * 获取帧环形缓存中gop缓存的字节数，与各协议的gop缓存一起计入general.gop_cache_max_kb/gop_cache_total_max_mb预算
+     * Get the bytes of the gop cache in the frame ring buffer, which are charged to the
+     * general.gop_cache_max_kb/gop_cache_total_max_mb budget together with the gop caches of each protocol
+     */
+    size_t getGopCacheBytes() const { return _gop_budget.bytes(); }
+
 protected:
     /////////////////////////////////MediaSink override/////////////////////////////////
 
@@ -232,6 +270,7 @@ protected:
 
 private:
     void createGopCacheIfNeed(size_t gop_count);
+    void flushSharedGop(const std::string &schema);
     std::shared_ptr<MediaSinkInterface> makeRecorder(MediaSource &sender, Recorder::type type);
 
 private:
@@ -240,10 +279,15 @@ private:
     bool _video_key_pos = false;
     float _dur_sec;
     std::shared_ptr<class FramePacedSender> _paced_sender;
+    std::shared_ptr<class MuxerPipeline> _pipeline;
+    StreamLatency::Ptr _latency;
     MediaTuple _tuple;
     ProtocolOption _option;
     toolkit::Ticker _last_check;
+    bool _frame_ring_used = false;
+    toolkit::Ticker _frame_ring_ticker;
     std::unordered_map<int, Stamp> _stamps;
+    std::unordered_map<std::string/*schema*/, int> _protocol_readers;
     std::weak_ptr<Listener> _track_listener;
     std::unordered_multimap<std::string, std::tuple<RingType::RingReader::Ptr, std::weak_ptr<RtpSender>>> _rtp_sender;
     FMP4MediaSourceMuxer::Ptr _fmp4;
@@ -254,6 +298,7 @@ private:
     HlsRecorder::Ptr _hls;
     HlsFMP4Recorder::Ptr _hls_fmp4;
     toolkit::EventPoller::Ptr _poller;
+    GopCacheBudget _gop_budget;
     RingType::Ptr _ring;
 
     // 对象个数统计  [AUTO-TRANSLATED:3b43e8c2]
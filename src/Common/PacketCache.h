@@ -11,8 +11,10 @@
 #ifndef ZLMEDIAKIT_PACKET_CACHE_H_
 #define ZLMEDIAKIT_PACKET_CACHE_H_
 
+#include <atomic>
 #include "Common/config.h"
 #include "Util/List.h"
+#include "Common/LatencyStatistic.h"
 
 namespace mediakit {
 // / 缓存刷新策略类  [AUTO-TRANSLATED:bd941d15]
@@ -27,6 +29,103 @@ private:
     uint64_t _last_stamp[2] = { 0, 0 };
 };
 
+// / 包占用的字节数，可以为特定包类型重载(例如零拷贝rtp包需要加上其引用的负载)
+// / Bytes occupied by the packet, which can be overloaded for a specific packet type
+// / (e.g. the zero copy rtp packet needs to add the payload it references)
+template <typename T>
+size_t getPacketBytes(const std::shared_ptr<T> &pkt) {
+    return pkt->size();
+}
+
+// / gop缓存字节预算类，统计环形缓存中gop缓存占用的字节数，超过单流或全局预算时清空gop缓存
+// / Gop cache byte budget class, counts the bytes occupied by the gop cache in the ring buffer,
+// / and drops the gop cache when the per-stream or server-wide budget is exceeded
+class GopCacheBudget {
+public:
+    ~GopCacheBudget() { reset(); }
+
+    /**
+     * 写入环形缓存并统计gop缓存字节数
+     * @param ring 环形缓存，只缓存一个gop
+     * @param list 合并写的包列表
+     * @param is_key 是否为gop开始处
+     * @param max_size 环形缓存最大个数
+     * Write to the ring buffer and count the bytes of the gop cache
+     * @param ring Ring buffer which only caches one gop
+     * @param list Merged packet list
+     * @param is_key Whether it is the beginning of a gop
+     * @param max_size Maximum size of the ring buffer
+     */
+    template <typename RING, typename LIST>
+    void write(RING &ring, LIST list, bool is_key, size_t max_size) {
+        size_t bytes = 0;
+        for (auto &pkt : *list) {
+            bytes += getPacketBytes(pkt);
+        }
+        write_l(ring, std::move(list), bytes, is_key, max_size);
+    }
+
+    /**
+     * 写入单个包(例如帧级环形缓存中的帧)并统计gop缓存字节数
+     * @param ring 环形缓存
+     * @param pkt 包
+     * @param is_key 是否为gop开始处
+     * @param max_size 环形缓存最大个数
+     * Write a single packet (e.g. a frame of the frame-level ring buffer) and count the bytes of the gop cache
+     * @param ring Ring buffer
+     * @param pkt Packet
+     * @param is_key Whether it is the beginning of a gop
+     * @param max_size Maximum size of the ring buffer
+     */
+    template <typename RING, typename PKT>
+    void writePacket(RING &ring, PKT pkt, bool is_key, size_t max_size) {
+        auto bytes = getPacketBytes(pkt);
+        write_l(ring, std::move(pkt), bytes, is_key, max_size);
+    }
+
+    /**
+     * 环形缓存被清空时调用
+     * Called when the ring buffer cache is cleared
+     */
+    void reset();
+
+    /**
+     * 获取本gop缓存字节数
+     * Get the bytes of this gop cache
+     */
+    size_t bytes() const { return _bytes.load(); }
+
+    /**
+     * 获取全局gop缓存字节数
+     * Get the bytes of all gop caches
+     */
+    static size_t totalBytes();
+
+private:
+    template <typename RING, typename DATA>
+    void write_l(RING &ring, DATA data, size_t bytes, bool is_key, size_t max_size) {
+        auto drop = onWrite(bytes, is_key, max_size, ring.readerCount());
+        {
+            LatencyTrace::Dispatch dispatch;
+            ring.write(std::move(data), is_key);
+        }
+        if (drop) {
+            // 超过预算，清空gop缓存直到下个关键帧
+            // Exceeds the budget, drop the gop cache until the next key frame
+            ring.clearCache();
+        }
+    }
+
+    bool onWrite(size_t bytes, bool is_key, size_t max_size, int reader_count);
+
+private:
+    bool _dropped = false;
+    size_t _size = 0;
+    // 可能在其他线程(例如http api)读取
+    // May be read in other threads (such as http api)
+    std::atomic<size_t> _bytes { 0 };
+};
+
 // / 合并写缓存模板  [AUTO-TRANSLATED:25cde944]
 // / Merge write cache template
 // / \tparam packet 包类型  [AUTO-TRANSLATED:43085d9b]
@@ -0,0 +1,187 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+#include <mutex>
+#include <unordered_set>
+#include "PacketPool.h"
+
+using namespace std;
+
+namespace mediakit {
+
+////////////////////////////////////////////PoolThreadCounter////////////////////////////////////////////
+
+class PoolCounterRegistry {
+public:
+    static PoolCounterRegistry &Instance() {
+        // 不析构，防止线程退出晚于全局对象析构
+        // Never destructed, in case a thread exits after the destruction of global objects
+        static auto s_instance = new PoolCounterRegistry;
+        return *s_instance;
+    }
+
+    void add(PoolThreadCounter *counter) {
+        lock_guard<mutex> lck(_mtx);
+        _counters.emplace(counter);
+    }
+
+    void remove(PoolThreadCounter *counter) {
+        lock_guard<mutex> lck(_mtx);
+        _counters.erase(counter);
+        // 保留已退出线程的命中统计
+        // Retain the hit statistics of the exited threads
+        auto &retired = _retired[counter->name()];
+        retired.hit += counter->hit();
+        retired.miss += counter->miss();
+    }
+
+    vector<PacketPoolStatistic> getStatistic() {
+        map<string, PacketPoolStatistic> stats;
+        lock_guard<mutex> lck(_mtx);
+        for (auto &pr : _retired) {
+            auto &stat = stats[pr.first];
+            stat.hit += pr.second.hit;
+            stat.miss += pr.second.miss;
+        }
+        for (auto counter : _counters) {
+            auto &stat = stats[counter->name()];
+            stat.hit += counter->hit();
+            stat.miss += counter->miss();
+            stat.cached += counter->cached();
+        }
+        vector<PacketPoolStatistic> ret;
+        for (auto &pr : stats) {
+            pr.second.name = pr.first;
+            ret.emplace_back(std::move(pr.second));
+        }
+        return ret;
+    }
+
+private:
+    mutex _mtx;
+    unordered_set<PoolThreadCounter *> _counters;
+    map<string, PacketPoolStatistic> _retired;
+};
+
+PoolThreadCounter::PoolThreadCounter(const char *name) {
+    _name = name;
+    PoolCounterRegistry::Instance().add(this);
+}
+
+PoolThreadCounter::~PoolThreadCounter() {
+    PoolCounterRegistry::Instance().remove(this);
+}
+
+vector<PacketPoolStatistic> getPacketPoolStatistic() {
+    return PoolCounterRegistry::Instance().getStatistic();
+}
+
+////////////////////////////////////////////SlabAllocator////////////////////////////////////////////
+
+// 分级为32、64、128、256、512字节
+// Size classes are 32, 64, 128, 256, 512 bytes
+static constexpr size_t kSlabMinShift = 5;
+static constexpr size_t kSlabClasses = 5;
+static constexpr size_t kSlabMaxSize = 1 << (kSlabMinShift + kSlabClasses - 1);
+// 每个线程每个分级最多缓存的空闲块个数
+// Maximum number of free blocks cached by each thread for each size class
+static constexpr size_t kSlabMaxCached = 4096;
+
+static size_t getSlabClass(size_t size) {
+    size_t index = 0;
+    while (((size_t)1 << (kSlabMinShift + index)) < size) {
+        ++index;
+    }
+    return index;
+}
+
+namespace {
+
+struct SlabBlock {
+    SlabBlock *next;
+};
+
+struct SlabThreadCache {
+    PoolThreadCounter counter { "slab" };
+    SlabBlock *heads[kSlabClasses] = { nullptr };
+    size_t counts[kSlabClasses] = { 0 };
+    size_t total = 0;
+
+    ~SlabThreadCache() {
+        for (auto &head : heads) {
+            while (head) {
+                auto next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    }
+};
+
+} // namespace
+
+static SlabThreadCache *getSlabCache() {
+    static thread_local bool s_exited = false;
+    struct Holder {
+        SlabThreadCache cache;
+        ~Holder() { s_exited = true; }
+    };
+    if (s_exited) {
+        return nullptr;
+    }
+    static thread_local Holder s_holder;
+    return &s_holder.cache;
+}
+
+void *SlabAllocator::allocate(size_t size) {
+    if (size > kSlabMaxSize) {
+        return ::operator new(size);
+    }
+    auto index = getSlabClass(size);
+    auto cache = getSlabCache();
+    if (cache && cache->heads[index]) {
+        auto block = cache->heads[index];
+        cache->heads[index] = block->next;
+        --cache->counts[index];
+        cache->counter.onHit();
+        cache->counter.setCached(--cache->total);
+        return block;
+    }
+    if (cache) {
+        cache->counter.onMiss();
+    }
+    // 按分级大小分配，以便被任意线程回收复用
+    // Allocate by the size class, so that it can be recycled and reused by any thread
+    return ::operator new((size_t)1 << (kSlabMinShift + index));
+}
+
+void SlabAllocator::deallocate(void *ptr, size_t size) {
+    if (!ptr) {
+        return;
+    }
+    if (size > kSlabMaxSize) {
+        ::operator delete(ptr);
+        return;
+    }
+    auto index = getSlabClass(size);
+    auto cache = getSlabCache();
+    if (!cache || cache->counts[index] >= kSlabMaxCached) {
+        ::operator delete(ptr);
+        return;
+    }
+    auto block = (SlabBlock *)ptr;
+    block->next = cache->heads[index];
+    cache->heads[index] = block;
+    ++cache->counts[index];
+    cache->counter.setCached(++cache->total);
+}
+
+} // namespace mediakit
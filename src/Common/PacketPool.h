@@ -0,0 +1,194 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_PACKETPOOL_H
+#define ZLMEDIAKIT_PACKETPOOL_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mediakit {
+
+/**
+ * 线程缓存的命中统计，每个线程独立计数，通过getPacketPoolStatistic汇总
+ * Hit statistics of the thread cache, each thread counts independently, summarized by getPacketPoolStatistic
+ */
+class PoolThreadCounter {
+public:
+    PoolThreadCounter(const char *name);
+    ~PoolThreadCounter();
+
+    // 只有所属线程会修改计数，无需原子加
+    // Only the owner thread modifies the counters, no atomic add is needed
+    void onHit() { _hit.store(_hit.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    void onMiss() { _miss.store(_miss.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    void setCached(size_t cached) { _cached.store(cached, std::memory_order_relaxed); }
+
+    const char *name() const { return _name; }
+    uint64_t hit() const { return _hit.load(std::memory_order_relaxed); }
+    uint64_t miss() const { return _miss.load(std::memory_order_relaxed); }
+    size_t cached() const { return _cached.load(std::memory_order_relaxed); }
+
+private:
+    const char *_name;
+    std::atomic<uint64_t> _hit { 0 };
+    std::atomic<uint64_t> _miss { 0 };
+    std::atomic<size_t> _cached { 0 };
+};
+
+struct PacketPoolStatistic {
+    std::string name;
+    // 从线程缓存分配的次数
+    // Number of allocations from the thread cache
+    uint64_t hit = 0;
+    // 线程缓存为空，从系统分配的次数
+    // Number of allocations from the system because the thread cache is empty
+    uint64_t miss = 0;
+    // 当前各线程缓存的对象(内存块)个数
+    // Number of objects (memory blocks) currently cached by all threads
+    uint64_t cached = 0;
+};
+
+/**
+ * 获取所有对象池与slab分配器的统计信息
+ * Get the statistics of all object pools and the slab allocator
+ */
+std::vector<PacketPoolStatistic> getPacketPoolStatistic();
+
+/**
+ * 按大小分级的小内存slab分配器，每个线程(poller)持有独立的空闲链表，分配与释放无锁
+ * 空闲块超过上限后归还系统，超过最大分级的内存直接使用operator new
+ * Size-class slab allocator for small memory, each thread (poller) holds independent free lists,
+ * allocation and release are lock-free
+ * Free blocks are returned to the system after exceeding the limit,
+ * memory larger than the maximum size class uses operator new directly
+ */
+class SlabAllocator {
+public:
+    static void *allocate(size_t size);
+    static void deallocate(void *ptr, size_t size);
+};
+
+/**
+ * 基于SlabAllocator的stl分配器，用于shared_ptr控制块等小对象
+ * Stl allocator based on SlabAllocator, used for small objects such as the shared_ptr control block
+ */
+template <typename T>
+class SlabStlAllocator {
+public:
+    using value_type = T;
+
+    SlabStlAllocator() = default;
+    template <typename U>
+    SlabStlAllocator(const SlabStlAllocator<U> &) {}
+
+    T *allocate(size_t n) { return (T *)SlabAllocator::allocate(n * sizeof(T)); }
+    void deallocate(T *ptr, size_t n) { SlabAllocator::deallocate(ptr, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const SlabStlAllocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const SlabStlAllocator<U> &) const { return false; }
+};
+
+/**
+ * 线程本地的对象池，对象在释放它的线程回收，复用时保留其内存容量(例如BufferRaw的capacity)
+ * 控制块由SlabAllocator分配，稳定状态下获取与释放对象都不会调用malloc/free
+ * T为返回的类型，Impl为实际构造的类型
+ * Thread-local object pool, objects are recycled in the thread that releases them,
+ * and their memory capacity (such as the capacity of BufferRaw) is retained when reused
+ * The control block is allocated by SlabAllocator, so in the steady state obtaining and releasing objects does not call malloc/free
+ * T is the returned type, Impl is the actually constructed type
+ */
+template <typename T, typename Impl = T>
+class PacketPool {
+public:
+    // 每个线程最多缓存的对象个数
+    // Maximum number of objects cached by each thread
+    static constexpr size_t kMaxCached = 1024;
+
+    /**
+     * 获取对象，复用的对象需要调用者重置其状态
+     * @param name 统计名
+     * Obtain an object, the caller needs to reset the state of the reused object
+     * @param name Statistic name
+     */
+    static std::shared_ptr<T> obtain(const char *name) {
+        T *obj = nullptr;
+        auto cache = getCache(name);
+        if (cache && !cache->objs.empty()) {
+            obj = cache->objs.back();
+            cache->objs.pop_back();
+            cache->counter.onHit();
+            cache->counter.setCached(cache->objs.size());
+        } else {
+            obj = new Impl();
+            if (cache) {
+                cache->counter.onMiss();
+            }
+        }
+        return std::shared_ptr<T>(obj, Recycler { name }, SlabStlAllocator<T>());
+    }
+
+private:
+    struct ThreadCache {
+        PoolThreadCounter counter;
+        std::vector<T *> objs;
+
+        ThreadCache(const char *name) : counter(name) { objs.reserve(kMaxCached); }
+        ~ThreadCache() {
+            for (auto obj : objs) {
+                delete static_cast<Impl *>(obj);
+            }
+        }
+    };
+
+    // 对象提供onRecycle方法时，回收前调用它释放其引用的外部内存
+    // If the object provides an onRecycle method, call it before recycling to release the external memory it references
+    template <typename U>
+    static auto onRecycle(U *obj, int) -> decltype(obj->onRecycle(), void()) { obj->onRecycle(); }
+    template <typename U>
+    static void onRecycle(U *, ...) {}
+
+    struct Recycler {
+        const char *name;
+        void operator()(T *obj) const {
+            auto cache = getCache(name);
+            if (cache && cache->objs.size() < kMaxCached) {
+                onRecycle(obj, 0);
+                cache->objs.emplace_back(obj);
+                cache->counter.setCached(cache->objs.size());
+                return;
+            }
+            delete static_cast<Impl *>(obj);
+        }
+    };
+
+    static ThreadCache *getCache(const char *name) {
+        // 线程退出时缓存被销毁，此后回退为new/delete
+        // The cache is destroyed when the thread exits, after which it falls back to new/delete
+        static thread_local bool s_exited = false;
+        struct Holder {
+            ThreadCache cache;
+            Holder(const char *name) : cache(name) {}
+            ~Holder() { s_exited = true; }
+        };
+        if (s_exited) {
+            return nullptr;
+        }
+        static thread_local Holder s_holder(name);
+        return &s_holder.cache;
+    }
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_PACKETPOOL_H
@@ -0,0 +1,206 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <cstring>
+#include "UdpBatchSender.h"
+#include "Common/config.h"
+#include "Network/sockutil.h"
+#include "Util/uv_errno.h"
+
+#if defined(__linux__) || defined(__linux)
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#endif
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+using BufferUdp = BufferOffset<Buffer::Ptr>;
+
+void UdpBatchSender::addPacket(Buffer::Ptr buf, size_t offset, Buffer::Ptr tail) {
+    if (buf->size() <= offset) {
+        return;
+    }
+    _packets.emplace_back(Packet { std::move(buf), offset, std::move(tail) });
+}
+
+void UdpBatchSender::flush(const Socket::Ptr &sock) {
+    if (_packets.empty()) {
+        return;
+    }
+    size_t sent = 0;
+#if defined(__linux__) || defined(__linux)
+    GET_CONFIG(int, batch_send, General::kUdpBatchSend);
+    // socket有数据在排队时，直接发送会导致乱序
+    // When the socket has data queued, sending directly will cause disorder
+    if (batch_send && sock->alive() && !sock->isSocketBusy()) {
+        auto peer_port = sock->get_peer_port();
+        if (peer_port) {
+            auto addr = SockUtil::make_sockaddr(sock->get_peer_ip().data(), peer_port);
+            sent = sendBatch(sock->rawFD(), (struct sockaddr *)&addr, SockUtil::get_sock_len((struct sockaddr *)&addr));
+        }
+    }
+#endif
+    fallback(sock, sent);
+    _packets.clear();
+}
+
+void UdpBatchSender::fallback(const Socket::Ptr &sock, size_t index) {
+    if (index >= _packets.size()) {
+        return;
+    }
+    for (auto i = index; i < _packets.size(); ++i) {
+        auto &pkt = _packets[i];
+        if (!pkt.tail) {
+            sock->send(std::make_shared<BufferUdp>(std::move(pkt.buf), pkt.offset), nullptr, 0, false);
+            continue;
+        }
+        // Socket逐个buffer发送udp包，需要拼接为连续内存
+        // Socket sends a udp packet per buffer, so they need to be joined into contiguous memory
+        auto head_size = pkt.buf->size() - pkt.offset;
+        auto buf = BufferRaw::create();
+        buf->setCapacity(head_size + pkt.tail->size());
+        buf->setSize(head_size + pkt.tail->size());
+        memcpy(buf->data(), pkt.buf->data() + pkt.offset, head_size);
+        memcpy(buf->data() + head_size, pkt.tail->data(), pkt.tail->size());
+        sock->send(std::move(buf), nullptr, 0, false);
+    }
+    sock->flushAll();
+}
+
+#if defined(__linux__) || defined(__linux)
+
+// 一次sendmmsg最多发送的消息个数
+// Maximum number of messages sent by one sendmmsg
+static constexpr size_t kMaxBatchMsg = 256;
+// 一次sendmmsg最多引用的iovec个数，每个包最多2个iovec
+// Maximum number of iovec referenced by one sendmmsg, each packet uses at most 2 iovec
+static constexpr size_t kMaxBatchIov = 1024;
+// 单个GSO消息最多包含的分片个数与字节数(内核限制为64个分片与64KB)
+// Maximum number of segments and bytes of a single GSO message (the kernel limits them to 64 segments and 64KB)
+static constexpr size_t kMaxGsoSegments = 64;
+static constexpr size_t kMaxGsoBytes = 60 * 1024;
+
+// 内核或网卡不支持GSO时，关闭GSO
+// Disable GSO when the kernel or network card does not support it
+static atomic<bool> s_gso_disabled { false };
+
+size_t UdpBatchSender::sendBatch(int fd, const struct sockaddr *addr, int addr_len) {
+    GET_CONFIG(int, batch_send, General::kUdpBatchSend);
+    auto use_gso = batch_send > 1 && !s_gso_disabled.load();
+
+    struct mmsghdr msgs[kMaxBatchMsg];
+    struct iovec iovs[kMaxBatchIov];
+    // 每个消息对应的包个数与字节数
+    // Number of packets and bytes per message
+    size_t counts[kMaxBatchMsg];
+    size_t bytes[kMaxBatchMsg];
+    char controls[kMaxBatchMsg][CMSG_SPACE(sizeof(uint16_t))];
+
+    size_t index = 0;
+    while (index < _packets.size()) {
+        size_t msg_count = 0;
+        size_t iov_count = 0;
+        auto pkt_index = index;
+        while (pkt_index < _packets.size() && msg_count < kMaxBatchMsg && iov_count + 2 * kMaxGsoSegments <= kMaxBatchIov) {
+            auto &msg = msgs[msg_count];
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_hdr.msg_name = (void *)addr;
+            msg.msg_hdr.msg_namelen = addr_len;
+            msg.msg_hdr.msg_iov = &iovs[iov_count];
+
+            auto seg_size = _packets[pkt_index].size();
+            size_t total = 0;
+            size_t seg_count = 0;
+            size_t msg_iov_count = 0;
+            while (pkt_index < _packets.size()) {
+                auto &pkt = _packets[pkt_index];
+                auto len = pkt.size();
+                if (seg_count) {
+                    // GSO要求除最后一个分片外，所有分片大小相同
+                    // GSO requires all segments to be the same size except the last one
+                    if (!use_gso || len > seg_size || seg_count >= kMaxGsoSegments || total + len > kMaxGsoBytes) {
+                        break;
+                    }
+                }
+                auto &iov = iovs[iov_count++];
+                iov.iov_base = pkt.buf->data() + pkt.offset;
+                iov.iov_len = pkt.buf->size() - pkt.offset;
+                ++msg_iov_count;
+                if (pkt.tail) {
+                    // GSO按gso_size切分整个iovec数组，单个分片可以由多个iovec组成
+                    // GSO splits the whole iovec array by gso_size, a single segment can consist of multiple iovec
+                    auto &tail_iov = iovs[iov_count++];
+                    tail_iov.iov_base = pkt.tail->data();
+                    tail_iov.iov_len = pkt.tail->size();
+                    ++msg_iov_count;
+                }
+                total += len;
+                ++seg_count;
+                ++pkt_index;
+                if (len < seg_size) {
+                    // 较小的分片只能作为最后一个分片
+                    // A smaller segment can only be the last segment
+                    break;
+                }
+            }
+            msg.msg_hdr.msg_iovlen = msg_iov_count;
+            if (seg_count > 1) {
+                msg.msg_hdr.msg_control = controls[msg_count];
+                msg.msg_hdr.msg_controllen = sizeof(controls[msg_count]);
+                auto cm = CMSG_FIRSTHDR(&msg.msg_hdr);
+                cm->cmsg_level = SOL_UDP;
+                cm->cmsg_type = UDP_SEGMENT;
+                cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                uint16_t gso_size = seg_size;
+                memcpy(CMSG_DATA(cm), &gso_size, sizeof(gso_size));
+            }
+            bytes[msg_count] = total;
+            counts[msg_count++] = seg_count;
+        }
+
+        auto ret = ::sendmmsg(fd, msgs, msg_count, MSG_DONTWAIT);
+        if (ret <= 0) {
+            if (use_gso && (get_uv_error(true) == UV_EIO || get_uv_error(true) == UV_EINVAL)) {
+                // 不支持GSO，关闭后重试
+                // GSO is not supported, disable it and try again
+                WarnL << "UDP GSO is not supported, disable it: " << get_uv_errmsg(true);
+                s_gso_disabled = true;
+                use_gso = false;
+                continue;
+            }
+            // 发送失败(例如EAGAIN)，剩余的包交给Socket发送
+            // Send failed (e.g. EAGAIN), the remaining packets are sent by Socket
+            break;
+        }
+        for (int i = 0; i < ret; ++i) {
+            index += counts[i];
+            _speed += bytes[i];
+        }
+        if ((size_t)ret < msg_count) {
+            break;
+        }
+    }
+    return index;
+}
+
+#endif // defined(__linux__) || defined(__linux)
+
+} // namespace mediakit
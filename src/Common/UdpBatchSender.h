@@ -0,0 +1,86 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_UDPBATCHSENDER_H
+#define ZLMEDIAKIT_UDPBATCHSENDER_H
+
+#include <vector>
+#include "Network/Socket.h"
+#include "Util/SpeedStatistic.h"
+
+namespace mediakit {
+
+/**
+ * udp批量发送器，linux下通过sendmmsg一次系统调用发送多个udp包，
+ * 并在内核支持时通过UDP_SEGMENT(GSO)把相同大小的连续包合并为一次发送
+ * 不支持或socket发送缓存已满时，回退到Socket::send
+ * Udp batch sender, on linux it sends multiple udp packets with one sendmmsg system call,
+ * and merges consecutive packets of the same size into one send with UDP_SEGMENT (GSO) when the kernel supports it
+ * Fall back to Socket::send when not supported or the socket send buffer is full
+ */
+class UdpBatchSender {
+public:
+    /**
+     * 添加待发送的udp包
+     * @param buf 数据包
+     * @param offset 跳过数据包的前offset个字节(例如rtp over tcp的4个字节头)
+     * @param tail 追加在数据包之后的数据(例如零拷贝rtp包引用的负载)，与数据包组成同一个udp包
+     * Add a udp packet to be sent
+     * @param buf Data packet
+     * @param offset Skip the first offset bytes of the packet (e.g. the 4-byte header of rtp over tcp)
+     * @param tail Data appended after the packet (e.g. the payload referenced by the zero copy rtp packet), which forms the same udp packet with it
+     */
+    void addPacket(toolkit::Buffer::Ptr buf, size_t offset = 0, toolkit::Buffer::Ptr tail = nullptr);
+
+    /**
+     * 发送所有待发送的udp包到socket绑定的对端地址
+     * @param sock udp socket
+     * Send all pending udp packets to the peer address bound to the socket
+     * @param sock Udp socket
+     */
+    void flush(const toolkit::Socket::Ptr &sock);
+
+    /**
+     * 待发送的包个数
+     * Number of pending packets
+     */
+    size_t size() const { return _packets.size(); }
+
+    /**
+     * 获取通过批量发送的速率，单位bytes/s
+     * Get the speed of batch sending, in bytes/s
+     */
+    size_t getSendSpeed() const { return _speed.getSpeed(); }
+
+    /**
+     * 获取通过批量发送的总字节数
+     * Get the total bytes sent in batch
+     */
+    size_t getSendTotalBytes() const { return _speed.getTotalBytes(); }
+
+private:
+    size_t sendBatch(int fd, const struct sockaddr *addr, int addr_len);
+    void fallback(const toolkit::Socket::Ptr &sock, size_t index);
+
+private:
+    struct Packet {
+        toolkit::Buffer::Ptr buf;
+        size_t offset;
+        toolkit::Buffer::Ptr tail;
+
+        size_t size() const { return buf->size() - offset + (tail ? tail->size() : 0); }
+    };
+
+    std::vector<Packet> _packets;
+    mutable toolkit::BytesSpeed _speed;
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_UDPBATCHSENDER_H
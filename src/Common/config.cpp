@@ -88,6 +88,16 @@ const string kWaitAddTrackMS = GENERAL_FIELD "wait_add_track_ms";
 const string kUnreadyFrameCache = GENERAL_FIELD "unready_frame_cache";
 const string kBroadcastPlayerCountChanged = GENERAL_FIELD "broadcast_player_count_changed";
 const string kListenIP = GENERAL_FIELD "listen_ip";
+const string kGopCacheMaxKB = GENERAL_FIELD "gop_cache_max_kb";
+const string kGopCacheTotalMaxMB = GENERAL_FIELD "gop_cache_total_max_mb";
+const string kUdpBatchSend = GENERAL_FIELD "udp_batch_send";
+const string kDiskIOThreads = GENERAL_FIELD "disk_io_threads";
+const string kMuxerThreads = GENERAL_FIELD "muxer_threads";
+const string kMuxerQueueSize = GENERAL_FIELD "muxer_queue_size";
+const string kLatencyStatistic = GENERAL_FIELD "latency_statistic";
+const string kLatencyStamp = GENERAL_FIELD "latency_stamp";
+const string kDecodeThreads = GENERAL_FIELD "decode_threads";
+const string kDecodeFrameThreads = GENERAL_FIELD "decode_frame_threads";
 
 static onceToken token([]() {
     mINI::Instance()[kFlowThreshold] = 1024;
@@ -105,6 +115,16 @@ static onceToken token([]() {
     mINI::Instance()[kUnreadyFrameCache] = 100;
     mINI::Instance()[kBroadcastPlayerCountChanged] = 0;
     mINI::Instance()[kListenIP] = "::";
+    mINI::Instance()[kGopCacheMaxKB] = 0;
+    mINI::Instance()[kGopCacheTotalMaxMB] = 0;
+    mINI::Instance()[kUdpBatchSend] = 0;
+    mINI::Instance()[kDiskIOThreads] = 0;
+    mINI::Instance()[kMuxerThreads] = 0;
+    mINI::Instance()[kMuxerQueueSize] = 1024;
+    mINI::Instance()[kLatencyStatistic] = 0;
+    mINI::Instance()[kLatencyStamp] = 0;
+    mINI::Instance()[kDecodeThreads] = 0;
+    mINI::Instance()[kDecodeFrameThreads] = 0;
 });
 
 } // namespace General
@@ -136,6 +156,7 @@ const string kRtspDemand = string(kFieldName) + "rtsp_demand";
 const string kRtmpDemand = string(kFieldName) + "rtmp_demand";
 const string kTSDemand = string(kFieldName) + "ts_demand";
 const string kFMP4Demand = string(kFieldName) + "fmp4_demand";
+const string kSharedGopCache = string(kFieldName) + "shared_gop_cache";
 
 static onceToken token([]() {
     mINI::Instance()[kModifyStamp] = (int)ProtocolOption::kModifyStampRelative;
@@ -164,6 +185,7 @@ static onceToken token([]() {
     mINI::Instance()[kRtmpDemand] = 0;
     mINI::Instance()[kTSDemand] = 0;
     mINI::Instance()[kFMP4Demand] = 0;
+    mINI::Instance()[kSharedGopCache] = 0;
 });
 } // !Protocol
 
@@ -273,6 +295,9 @@ const string kAudioMtuSize = RTP_FIELD "audioMtuSize";
 const string kRtpMaxSize = RTP_FIELD "rtpMaxSize";
 const string kLowLatency = RTP_FIELD "lowLatency";
 const string kH264StapA = RTP_FIELD "h264_stap_a";
+const string kH265ApSize = RTP_FIELD "h265_ap_size";
+const string kAacAggregateMS = RTP_FIELD "aac_aggregate_ms";
+const string kZeroCopy = RTP_FIELD "zero_copy";
 
 static onceToken token([]() {
     mINI::Instance()[kVideoMtuSize] = 1400;
@@ -280,6 +305,9 @@ static onceToken token([]() {
     mINI::Instance()[kRtpMaxSize] = 10;
     mINI::Instance()[kLowLatency] = 0;
     mINI::Instance()[kH264StapA] = 1;
+    mINI::Instance()[kH265ApSize] = 0;
+    mINI::Instance()[kAacAggregateMS] = 0;
+    mINI::Instance()[kZeroCopy] = 0;
 });
 } // namespace Rtp
 
@@ -262,6 +262,49 @@ extern const std::string kBroadcastPlayerCountChanged;
 // 绑定的本地网卡ip  [AUTO-TRANSLATED:daa90832]
 // Bound local network card ip
 extern const std::string kListenIP;
+// 单路流每种协议gop缓存的最大字节数(单位KB)，超过后清空该gop缓存直到下个关键帧，置0则不限制
+// Maximum bytes (in KB) of the gop cache of each protocol of a single stream,
+// the gop cache is dropped until the next key frame when exceeded, set to 0 to disable the limit
+extern const std::string kGopCacheMaxKB;
+// 全局gop缓存的最大字节数(单位MB)，超过后无人观看的流不再缓存gop，置0则不限制
+// Maximum bytes (in MB) of all gop caches of the server,
+// streams without readers stop caching gop when exceeded, set to 0 to disable the limit
+extern const std::string kGopCacheTotalMaxMB;
+// udp批量发送模式，0:逐包发送，1:sendmmsg批量发送，2:sendmmsg+UDP GSO(仅linux有效)
+// Udp batch send mode, 0: send packet by packet, 1: batch send with sendmmsg, 2: sendmmsg + UDP GSO (linux only)
+extern const std::string kUdpBatchSend;
+// 磁盘io线程个数，hls切片与mp4录制的文件写操作在磁盘io线程执行，置0则在poller线程同步写文件
+// Number of disk io threads, the file writes of hls segments and mp4 recording are executed in the disk io threads,
+// set to 0 to write files synchronously in the poller threads
+extern const std::string kDiskIOThreads;
+// 转协议并行流水线线程个数，大于0时每路流的各协议复用器(rtsp/rtmp/ts/fmp4/hls/mp4)在该线程池中并行执行，
+// 同一复用器的帧按顺序处理；置0则在流的归属poller线程中依次执行
+// Number of threads of the parallel muxer pipeline, when it is greater than 0, the protocol muxers (rtsp/rtmp/ts/fmp4/hls/mp4)
+// of each stream are executed in parallel in this thread pool, and the frames of the same muxer are processed in order;
+// set to 0 to execute them one after another in the owner poller thread of the stream
+extern const std::string kMuxerThreads;
+// 转协议并行流水线每个阶段(复用器)最多积压的帧数，超过后该阶段丢帧直到下一个视频关键帧，置0则不限制
+// Maximum number of backlogged frames of each stage (muxer) of the parallel muxer pipeline,
+// when exceeded, the stage drops frames until the next video key frame, set to 0 to disable the limit
+extern const std::string kMuxerQueueSize;
+// 是否开启每路流的流水线延时统计(拆包、排序、解复用、转协议、分发各阶段)，可通过getStreamLatency接口查询
+// Whether to enable the pipeline latency statistics of each stream (splitting, sorting, demuxing, protocol muxing, dispatching),
+// which can be queried through the getStreamLatency api
+extern const std::string kLatencyStatistic;
+// 是否在h264/h265视频帧前插入携带该帧进入MultiMediaSourceMuxer时(解复用完成后)系统时间的SEI，用于测量到各协议播放端的端到端延时
+// Whether to insert an SEI carrying the system time when the frame enters MultiMediaSourceMuxer (after demuxing) before h264/h265 video frames,
+// used to measure the end-to-end latency to players of each protocol
+extern const std::string kLatencyStamp;
+// 共享解码线程池线程个数，大于0时所有异步解码器分散到该线程池执行，同一解码器的帧按顺序解码；
+// 置0则每个异步解码器独占一个线程
+// Number of threads of the shared decoding thread pool, when it is greater than 0, all asynchronous decoders are spread over
+// this thread pool and the frames of the same decoder are decoded in order; set to 0 to give each asynchronous decoder a dedicated thread
+extern const std::string kDecodeThreads;
+// 是否开启ffmpeg视频帧级多线程解码，开启后4K等高分辨率视频可以利用多核解码，但是会增加与解码线程数相当的帧延时；
+// 关闭时只使用片级多线程(默认)
+// Whether to enable ffmpeg frame level multi-threaded video decoding, when enabled, high resolution videos such as 4K can be decoded
+// with multiple cores, but the latency increases by about as many frames as decoding threads; only slice level threading is used when disabled (default)
+extern const std::string kDecodeFrameThreads;
 } // namespace General
 
 namespace Protocol {
@@ -334,6 +377,11 @@ extern const std::string kRtspDemand;
 extern const std::string kRtmpDemand;
 extern const std::string kTSDemand;
 extern const std::string kFMP4Demand;
+
+// 是否开启共享gop缓存；开启后每路流只缓存一份帧级gop，按需转协议在第一个播放者到来时由此gop重新打包，实现秒开
+// Whether to enable the shared gop cache; when enabled, each stream only keeps one frame-level gop cache,
+// on-demand protocols repackage it when the first player arrives so that it can still start instantly
+extern const std::string kSharedGopCache;
 } // !Protocol
 
 // //////////HTTP配置///////////  [AUTO-TRANSLATED:a281d694]
@@ -456,6 +504,20 @@ extern const std::string kLowLatency;
 // H264 rtp打包模式是否采用stap-a模式(为了在老版本浏览器上兼容webrtc)还是采用Single NAL unit packet per H.264 模式  [AUTO-TRANSLATED:30632378]
 // Whether H264 RTP packaging mode uses stap-a mode (for compatibility with webrtc on older browsers) or Single NAL unit packet per H.264 mode
 extern const std::string kH264StapA;
+// H265 rtp打包时不超过该字节数的nal(例如vps/sps/pps/sei)与后续相同时间戳的小nal合并为AP(Aggregation Packet)，置0关闭
+// When packing H265 rtp, nal not exceeding this size (such as vps/sps/pps/sei) is merged with the following small nal
+// of the same timestamp into an AP (Aggregation Packet), set to 0 to disable
+extern const std::string kH265ApSize;
+// aac rtp打包时把多个au合并为一个rtp包(rfc3640)，该值为单个rtp包包含的最大音频时长(毫秒)，置0则每个au一个rtp包
+// When packing aac rtp, merge multiple au into one rtp packet (rfc3640), this value is the maximum audio duration (ms)
+// contained in a single rtp packet, set to 0 for one rtp packet per au
+extern const std::string kAacAggregateMS;
+// h264/h265 FU分片rtp包是否引用原始帧内存而不拷贝负载，发送时通过iovec拼接
+// 同时控制rtp解包时帧是否引用rtp包负载，只有消费者需要连续内存时才合并
+// Whether the h264/h265 FU fragment rtp packet references the memory of the original frame instead of copying the payload,
+// they are joined by iovec when sending
+// It also controls whether the frame references the rtp payload when unpacking rtp, merged only when the consumer needs contiguous memory
+extern const std::string kZeroCopy;
 } // namespace Rtp
 
 // //////////组播配置///////////  [AUTO-TRANSLATED:dc39b9d6]
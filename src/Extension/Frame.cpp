@@ -38,6 +38,61 @@ Frame::Ptr Frame::getCacheAbleFrame(const Frame::Ptr &frame){
     return std::make_shared<FrameCacheAble>(frame);
 }
 
+void FrameChain::append(const Buffer::Ptr &buf, const char *ptr, size_t size) {
+    if (_buffer.size() < _prefix_size + kHeadSize) {
+        auto head = MIN(size, _prefix_size + kHeadSize - _buffer.size());
+        _buffer.append(ptr, head);
+        ptr += head;
+        size -= head;
+    }
+    if (!size) {
+        return;
+    }
+    _fragments.emplace_back(std::make_shared<BufferOffset<Buffer::Ptr>>(buf, ptr - buf->data(), size));
+    _fragment_bytes += size;
+}
+
+char *FrameChain::data() const {
+    if (!_fragment_bytes) {
+        return FrameImp::data();
+    }
+    auto ptr = _merged_ptr.load(std::memory_order_acquire);
+    return ptr ? ptr : merge();
+}
+
+char *FrameChain::merge() const {
+    // 帧可能被多个复用器线程同时访问
+    // The frame may be accessed by multiple muxer threads at the same time
+    lock_guard<mutex> lck(_mtx);
+    auto ptr = _merged_ptr.load(std::memory_order_relaxed);
+    if (ptr) {
+        return ptr;
+    }
+    _merged = BufferRaw::create();
+    _merged->setCapacity(_buffer.size() + _fragment_bytes);
+    auto dst = _merged->data();
+    memcpy(dst, _buffer.data(), _buffer.size());
+    dst += _buffer.size();
+    for (auto &fragment : _fragments) {
+        memcpy(dst, fragment->data(), fragment->size());
+        dst += fragment->size();
+    }
+    _merged->setSize(_buffer.size() + _fragment_bytes);
+    // 合并后不再需要引用rtp包
+    // The rtp packets are no longer needed after merging
+    _fragments.clear();
+    _merged_ptr.store(_merged->data(), std::memory_order_release);
+    return _merged->data();
+}
+
+void FrameChain::clear() {
+    _buffer.clear();
+    _fragment_bytes = 0;
+    _fragments.clear();
+    _merged = nullptr;
+    _merged_ptr.store(nullptr, std::memory_order_relaxed);
+}
+
 FrameStamp::FrameStamp(Frame::Ptr frame) {
     setIndex(frame->getIndex());
     _frame = std::move(frame);
@@ -13,11 +13,13 @@
 
 #include <map>
 #include <mutex>
+#include <atomic>
 #include <functional>
 #include "Util/List.h"
 #include "Util/TimeTicker.h"
 #include "Common/Stamp.h"
 #include "Network/Buffer.h"
+#include "Common/PacketPool.h"
 
 namespace mediakit {
 
@@ -295,6 +297,14 @@ public:
         return !configFrame();
     }
 
+    /**
+     * 返回帧起始位置的指针，至少包含前缀与nal头，用于判断帧类型
+     * 由分片组成的帧只返回其连续的头部，避免为此合并内存
+     * Return the pointer to the start of the frame, which contains at least the prefix and the nal header, used to judge the frame type
+     * A frame composed of fragments only returns its contiguous head to avoid merging memory for this
+     */
+    virtual const char *head() const { return data(); }
+
     /**
      * 返回可缓存的frame
      * Return the cacheable frame
@@ -315,20 +325,19 @@ public:
 
     template <typename C = FrameImp>
     static std::shared_ptr<C> create() {
-#if 0
-        static ResourcePool<C> packet_pool;
-        static onceToken token([]() {
-            packet_pool.setSize(1024);
-        });
-        auto ret = packet_pool.obtain2();
+        // 子类(例如H264Frame)在构造函数中设置编码类型
+        // Subclasses (such as H264Frame) set the codec type in the constructor
+        static const CodecId s_codec_id = C()._codec_id;
+        auto ret = PacketPool<C>::obtain("FrameImp");
         ret->_buffer.clear();
         ret->_prefix_size = 0;
         ret->_dts = 0;
         ret->_pts = 0;
+        // 复用的对象不能沿用上个使用者的track index与编码类型，否则会被分发到错误的track
+        // The reused object must not keep the track index and codec type of the previous user, otherwise it is dispatched to the wrong track
+        ret->setIndex(-1);
+        ret->_codec_id = s_codec_id;
         return ret;
-#else
-        return std::shared_ptr<C>(new C());
-#endif
     }
 
     char *data() const override { return (char *)_buffer.data(); }
@@ -354,7 +363,83 @@ private:
 
 protected:
     friend class toolkit::ResourcePool_l<FrameImp>;
+    template <typename T, typename Impl>
+    friend class PacketPool;
     FrameImp() = default;
+
+    // 回收到对象池前释放大帧(例如关键帧)的内存，对象池只保留小块内存
+    // Release the memory of large frames (such as key frames) before recycling to the object pool, the pool only retains small blocks
+    void onRecycle() {
+        if (_buffer.capacity() > kMaxRecycleCapacity) {
+            _buffer = toolkit::BufferLikeString();
+        }
+    }
+
+private:
+    static constexpr size_t kMaxRecycleCapacity = 32 * 1024;
+};
+
+/**
+ * 由连续的头部与多个引用外部内存(例如rtp包负载)的分片组成的帧，拼接时不拷贝分片数据
+ * 只有调用data()时才合并为连续内存，只关心帧类型或帧大小的消费者无需合并
+ * A frame composed of a contiguous head and several fragments referencing external memory (such as the rtp payload),
+ * the fragment data is not copied when assembling
+ * It is merged into contiguous memory only when data() is called, consumers that only care about the frame type or size do not need to merge
+ */
+class FrameChain : public FrameImp {
+public:
+    using Ptr = std::shared_ptr<FrameChain>;
+
+    // 头部至少保留的帧数据字节数(不含前缀)，保证判断帧类型时无需合并
+    // Minimum number of frame data bytes (excluding the prefix) kept in the head, so that no merge is needed to judge the frame type
+    static constexpr size_t kHeadSize = 8;
+
+    /**
+     * 追加帧数据，头部不足kHeadSize时拷贝到头部，其余部分以引用方式追加
+     * 只能在帧输出前调用
+     * @param buf 数据所属的缓存，分片持有其引用
+     * @param ptr 数据指针，必须位于buf内
+     * @param size 数据长度
+     * Append frame data, copied to the head when the head is less than kHeadSize, the rest is appended by reference
+     * Can only be called before the frame is output
+     * @param buf The buffer to which the data belongs, the fragment holds its reference
+     * @param ptr Data pointer, must be inside buf
+     * @param size Data length
+     */
+    void append(const toolkit::Buffer::Ptr &buf, const char *ptr, size_t size);
+
+    /**
+     * 清空头部与分片，只能在帧输出前调用
+     * Clear the head and the fragments, can only be called before the frame is output
+     */
+    void clear();
+
+    char *data() const override;
+    size_t size() const override { return _buffer.size() + _fragment_bytes; }
+    const char *head() const override { return _buffer.data(); }
+
+protected:
+    friend class toolkit::ResourcePool_l<FrameChain>;
+    template <typename T, typename Impl>
+    friend class PacketPool;
+    FrameChain() = default;
+
+    // 回收到对象池前释放分片与合并后的内存
+    // Release the fragments and the merged memory before recycling to the object pool
+    void onRecycle() {
+        clear();
+        FrameImp::onRecycle();
+    }
+
+private:
+    char *merge() const;
+
+private:
+    size_t _fragment_bytes = 0;
+    mutable std::mutex _mtx;
+    mutable std::atomic<char *> _merged_ptr { nullptr };
+    mutable toolkit::BufferRaw::Ptr _merged;
+    mutable std::vector<toolkit::Buffer::Ptr> _fragments;
 };
 
 // 包装一个指针成不可缓存的frame  [AUTO-TRANSLATED:c3e5d65e]
@@ -549,6 +634,7 @@ public:
     bool decodeAble() const override { return _frame->decodeAble(); }
     char *data() const override { return _frame->data(); }
     size_t size() const override { return _frame->size(); }
+    const char *head() const override { return _frame->head(); }
     CodecId getCodecId() const override { return _frame->getCodecId(); }
     void setStamp(int64_t dts, int64_t pts);
 
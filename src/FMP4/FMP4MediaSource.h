@@ -99,6 +99,12 @@ public:
         return _ring ? _ring->readerCount() : 0;
     }
 
+    /**
+     * 获取gop缓存占用的字节数
+     * Get the bytes occupied by the gop cache
+     */
+    size_t getGopCacheBytes() const override { return _gop_budget.bytes(); }
+
     /**
      * 输入FMP4包
      * @param packet FMP4包
@@ -130,6 +136,7 @@ public:
     void clearCache() override {
         PacketCache<FMP4Packet>::clearCache();
         _ring->clearCache();
+        _gop_budget.reset();
     }
 
 private:
@@ -160,12 +167,13 @@ private:
     void onFlush(std::shared_ptr<toolkit::List<FMP4Packet::Ptr> > packet_list, bool key_pos) override {
         // 如果不存在视频，那么就没有存在GOP缓存的意义，所以确保一直清空GOP缓存  [AUTO-TRANSLATED:66208f94]
         // If there is no video, then there is no meaning to the existence of GOP cache, so make sure to clear the GOP cache all the time
-        _ring->write(std::move(packet_list), _have_video ? key_pos : true);
+        _gop_budget.write(*_ring, std::move(packet_list), _have_video ? key_pos : true, _ring_size);
     }
 
 private:
     bool _have_video = false;
     int _ring_size;
+    GopCacheBudget _gop_budget;
     std::string _init_segment;
     RingType::Ptr _ring;
 };
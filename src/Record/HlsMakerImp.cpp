@@ -54,6 +54,9 @@ HlsMakerImp::~HlsMakerImp() {
     if (!isLive() || isKeep()) {
         saveCurrentDir();
     }
+    // 等待磁盘io任务完成，它们引用了本对象
+    // Wait for the disk io tasks to be completed, they refer to this object
+    _io.sync();
 }
 
 void HlsMakerImp::clearCache() {
@@ -90,7 +93,7 @@ void HlsMakerImp::clearCache(bool immediately, bool eof) {
         // Delete file only after hls live streaming
         GET_CONFIG(uint32_t, delay, Hls::kDeleteDelaySec);
         if (!delay || immediately) {
-            clearHls(lst);
+            _io.async([lst]() { clearHls(lst); });
         } else {
             _poller->doDelayTask(delay * 1000, [lst]() {
                 clearHls(lst);
@@ -100,7 +103,7 @@ void HlsMakerImp::clearCache(bool immediately, bool eof) {
     }
 
     clear();
-    _file = nullptr;
+    _io.async([this]() { _file = nullptr; });
     _segment_file_paths.clear();
 }
 
@@ -111,7 +114,9 @@ void HlsMakerImp::saveCurrentDir() {
     }
     if (isFmp4()) {
         // 写入init.mp4文件
-        File::saveFile(_current_dir_init_file, _path_prefix + "/" + _current_dir + "init.mp4");
+        auto init_file = _current_dir_init_file;
+        auto init_path = _path_prefix + "/" + _current_dir + "init.mp4";
+        _io.async([init_file, init_path]() { File::saveFile(init_file, init_path); });
     }
 
     int maxSegmentDuration = 0;
@@ -141,7 +146,8 @@ void HlsMakerImp::saveCurrentDir() {
     index_str += "#EXT-X-ENDLIST\n";
 
     /** 写入该目录的m3u8文件 **/
-    File::saveFile(index_str, _path_prefix + "/" + _current_dir + (isFmp4() ? "vod.fmp4.m3u8" : "vod.m3u8"));
+    auto index_path = _path_prefix + "/" + _current_dir + (isFmp4() ? "vod.fmp4.m3u8" : "vod.m3u8");
+    _io.async([index_str, index_path]() { File::saveFile(index_str, index_path); });
 }
 
 string HlsMakerImp::onOpenSegment(uint64_t index) {
@@ -165,7 +171,12 @@ string HlsMakerImp::onOpenSegment(uint64_t index) {
             _current_dir = std::move(current_dir);
         }
     }
-    _file = makeFile(segment_path, true);
+    _io.async([this, segment_path]() {
+        _file = makeFile(segment_path, true);
+        if (!_file) {
+            WarnL << "Create file failed," << segment_path << " " << get_uv_errmsg();
+        }
+    });
 
     // 保存本切片的元数据  [AUTO-TRANSLATED:64e6f692]
     // Save metadata for this slice
@@ -174,9 +185,6 @@ string HlsMakerImp::onOpenSegment(uint64_t index) {
     _info.file_path = segment_path;
     _info.url = _info.app + "/" + _info.stream + "/" + segment_name;
 
-    if (!_file) {
-        WarnL << "Create file failed," << segment_path << " " << get_uv_errmsg();
-    }
     if (_params.empty()) {
         return segment_name;
     }
@@ -188,8 +196,9 @@ void HlsMakerImp::onDelSegment(uint64_t index) {
     if (it == _segment_file_paths.end()) {
         return;
     }
-    File::delete_file(it->second.data(), true);
+    auto path = std::move(it->second);
     _segment_file_paths.erase(it);
+    _io.async([path]() { File::delete_file(path.data(), true); });
 }
 
 void HlsMakerImp::onWriteInitSegment(const char *data, size_t len) {
@@ -197,18 +206,31 @@ void HlsMakerImp::onWriteInitSegment(const char *data, size_t len) {
         _current_dir_init_file.assign(data, len);
     }
     string init_seg_path = _path_prefix + "/init.mp4";
-    auto file = makeFile(init_seg_path);
-    if (file) {
-        fwrite(data, len, 1, file.get());
-        _path_init = std::move(init_seg_path);
-    } else {
-        WarnL << "Create file failed," << init_seg_path << " " << get_uv_errmsg();
-    }
+    _path_init = init_seg_path;
+    string init_seg(data, len);
+    _io.async([this, init_seg_path, init_seg]() {
+        auto file = makeFile(init_seg_path);
+        if (file) {
+            fwrite(init_seg.data(), init_seg.size(), 1, file.get());
+        } else {
+            WarnL << "Create file failed," << init_seg_path << " " << get_uv_errmsg();
+        }
+    });
 }
 
 void HlsMakerImp::onWriteSegment(const char *data, size_t len) {
-    if (_file) {
-        fwrite(data, len, 1, _file.get());
+    if (!_io.isAsync()) {
+        if (_file) {
+            fwrite(data, len, 1, _file.get());
+        }
+    } else {
+        auto buffer = BufferRaw::create();
+        buffer->assign(data, len);
+        _io.async([this, buffer]() {
+            if (_file) {
+                fwrite(buffer->data(), buffer->size(), 1, _file.get());
+            }
+        });
     }
     if (_media_src) {
         _media_src->onSegmentSize(len);
@@ -217,30 +239,45 @@ void HlsMakerImp::onWriteSegment(const char *data, size_t len) {
 
 void HlsMakerImp::onWriteHls(const std::string &data, bool include_delay) {
     auto path = include_delay ? _path_hls_delay : _path_hls;
-    auto hls = makeFile(path);
-    if (hls) {
+    auto media_src = include_delay ? nullptr : _media_src;
+    // 异步写文件时，m3u8写入磁盘后再回到本线程更新内存中的m3u8，确保播放器不会请求到尚未写完的切片
+    // When writing files asynchronously, return to this thread to update the m3u8 in memory after it is written to disk,
+    // to ensure that the player will not request a segment that has not been written yet
+    auto poller = _io.isAsync() ? EventPoller::getCurrentPoller() : nullptr;
+    _io.async([this, path, data, media_src, poller]() {
+        auto hls = makeFile(path);
+        if (!hls) {
+            WarnL << "Create hls file failed," << path << " " << get_uv_errmsg();
+            return;
+        }
         fwrite(data.data(), data.size(), 1, hls.get());
         hls.reset();
-        if (_media_src && !include_delay) {
-            _media_src->setIndexFile(data);
+        if (!media_src) {
+            return;
         }
-    } else {
-        WarnL << "Create hls file failed," << path << " " << get_uv_errmsg();
-    }
+        if (poller) {
+            poller->async([media_src, data]() { media_src->setIndexFile(data); }, false);
+        } else {
+            media_src->setIndexFile(data);
+        }
+    });
 }
 
 void HlsMakerImp::onFlushLastSegment(uint64_t duration_ms) {
     // 关闭并flush文件到磁盘  [AUTO-TRANSLATED:9798ec4d]
     // Close and flush file to disk
-    _file = nullptr;
+    _io.async([this]() { _file = nullptr; });
     if (!isLive() || isKeep()) {
         _current_dir_seg_list.emplace_back(duration_ms, _info.file_name.erase(0, _current_dir.size()));
     }
     GET_CONFIG(bool, broadcastRecordTs, Hls::kBroadcastRecordTs);
     if (broadcastRecordTs) {
         _info.time_len = duration_ms / 1000.0f;
-        _info.file_size = File::fileSize(_info.file_path.data());
-        NOTICE_EMIT(BroadcastRecordTsArgs, Broadcast::kBroadcastRecordTs, _info);
+        auto info = _info;
+        _io.async([info]() mutable {
+            info.file_size = File::fileSize(info.file_path.data());
+            NOTICE_EMIT(BroadcastRecordTsArgs, Broadcast::kBroadcastRecordTs, info);
+        });
     }
 }
 
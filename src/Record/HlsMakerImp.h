@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include "HlsMaker.h"
 #include "HlsMediaSource.h"
+#include "Common/DiskIO.h"
 
 namespace mediakit {
 
@@ -75,8 +76,11 @@ private:
     std::string _current_dir;
     std::string _current_dir_init_file;
     RecordInfo _info;
+    // 切片文件，仅在磁盘io任务中访问
+    // Segment file, only accessed in disk io tasks
     std::shared_ptr<FILE> _file;
     std::shared_ptr<char> _file_buf;
+    DiskIOQueue _io;
     HlsMediaSource::Ptr _media_src;
     toolkit::EventPoller::Ptr _poller;
     std::map<uint64_t/*index*/,std::string/*file_path*/> _segment_file_paths;
@@ -58,8 +58,7 @@ public:
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
-        if (_clear_cache && _option.hls_demand) {
-            _clear_cache = false;
+        if (_option.hls_demand && _clear_cache.exchange(false)) {
             // 清空旧的m3u8索引文件于ts切片  [AUTO-TRANSLATED:a4ce0664]
             // Clear the old m3u8 index file and ts slices
             _hls->clearCache();
@@ -74,12 +73,14 @@ public:
     bool isEnabled() {
         // 缓存尚未清空时，还允许触发inputFrame函数，以便及时清空缓存  [AUTO-TRANSLATED:7cfd4d49]
         // When the cache has not been cleared, it is still allowed to trigger the inputFrame function to clear the cache in time
-        return _option.hls_demand ? (_clear_cache ? true : _enabled) : true;
+        return _option.hls_demand ? (_clear_cache || _enabled) : true;
     }
 
 protected:
-    bool _enabled = true;
-    bool _clear_cache = false;
+    // onReaderChanged在归属线程触发，inputFrame可能在转协议流水线线程执行
+    // onReaderChanged is triggered in the owner thread, while inputFrame may run in the muxer pipeline thread
+    std::atomic<bool> _enabled { true };
+    std::atomic<bool> _clear_cache { false };
     ProtocolOption _option;
     std::shared_ptr<HlsMakerImp> _hls;
 };
@@ -13,6 +13,7 @@
 #include "MP4.h"
 #include "Util/File.h"
 #include "Util/logger.h"
+#include "Network/Buffer.h"
 #include "Common/config.h"
 
 using namespace toolkit;
@@ -111,28 +112,73 @@ void MP4FileDisk::openFile(const char *file, const char *mode) {
         fflush(fp);
         fclose(fp);
     });
+
+    _offset = 0;
+    _io = nullptr;
+    if (mode[0] == 'w' && DiskIOPool::enabled()) {
+        // 写文件时，写操作与seek在磁盘io线程执行，本线程只记录文件偏移量
+        // When writing files, write and seek are executed in the disk io thread, this thread only records the file offset
+        _io = std::make_shared<DiskIOQueue>();
+    }
 }
 
 void MP4FileDisk::closeFile() {
+    if (_io) {
+        // 在磁盘io线程关闭文件，并等待写完，以便调用者可以立即获取文件大小
+        // Close the file in the disk io thread and wait for it to be written,
+        // so that the caller can get the file size immediately
+        auto file = std::move(_file);
+        _io->async([file]() mutable { file = nullptr; });
+        _io->sync();
+        _io = nullptr;
+    }
     _file = nullptr;
 }
 
 int MP4FileDisk::onRead(void *data, size_t bytes) {
+    if (_io) {
+        // 读之前需要等待之前的写操作完成
+        // Need to wait for the previous write operations to complete before reading
+        _io->sync();
+    }
     if (bytes == fread(data, 1, bytes, _file.get())){
+        _offset += bytes;
         return 0;
     }
+    _offset = ftell64(_file.get());
     return 0 != ferror(_file.get()) ? ferror(_file.get()) : -1 /*EOF*/;
 }
 
 int MP4FileDisk::onWrite(const void *data, size_t bytes) {
+    if (_io) {
+        auto buffer = BufferRaw::create();
+        buffer->assign((const char *)data, bytes);
+        auto file = _file;
+        _io->async([file, buffer]() {
+            if (buffer->size() != fwrite(buffer->data(), 1, buffer->size(), file.get())) {
+                WarnL << "Write mp4 file failed: " << ferror(file.get());
+            }
+        });
+        _offset += bytes;
+        return 0;
+    }
     return bytes == fwrite(data, 1, bytes, _file.get()) ? 0 : ferror(_file.get());
 }
 
 int MP4FileDisk::onSeek(uint64_t offset) {
+    if (_io) {
+        auto file = _file;
+        _io->async([file, offset]() { fseek64(file.get(), offset, SEEK_SET); });
+        _offset = offset;
+        return 0;
+    }
     return fseek64(_file.get(), offset, SEEK_SET);
 }
 
 uint64_t MP4FileDisk::onTell() {
+    if (_io) {
+        return _offset;
+    }
     return ftell64(_file.get());
 }
 
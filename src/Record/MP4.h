@@ -23,6 +23,7 @@
 #include "mpeg4-aac.h"
 #include "mov-buffer.h"
 #include "mov-format.h"
+#include "Common/DiskIO.h"
 
 namespace mediakit {
 
@@ -142,7 +143,11 @@ protected:
     int onWrite(const void *data, size_t bytes) override;
 
 private:
+    // 开启异步磁盘io时，由本线程维护的文件偏移量
+    // The file offset maintained by this thread when asynchronous disk io is enabled
+    uint64_t _offset = 0;
     std::shared_ptr<FILE> _file;
+    std::shared_ptr<DiskIOQueue> _io;
 };
 
 class MP4FileMemory : public MP4FileIO{
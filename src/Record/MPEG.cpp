@@ -15,15 +15,19 @@
 
 #include "mpeg-ts.h"
 #include "mpeg-muxer.h"
+#include "Common/PacketPool.h"
 
 using namespace toolkit;
 
 namespace mediakit {
 
+// BufferRaw的构造函数为protected，通过子类在对象池中构造
+// The constructor of BufferRaw is protected, construct it in the object pool through a subclass
+class MpegBuffer : public BufferRaw {};
+
 MpegMuxer::MpegMuxer(bool is_ps) {
     _is_ps = is_ps;
     createContext();
-    _buffer_pool.setSize(64);
 }
 
 MpegMuxer::~MpegMuxer() {
@@ -109,7 +113,7 @@ void MpegMuxer::createContext() {
                     if (thiz->_current_buffer) {
                         thiz->flushCache();
                     }
-                    thiz->_current_buffer = thiz->_buffer_pool.obtain2();
+                    thiz->_current_buffer = PacketPool<BufferRaw, MpegBuffer>::obtain("BufferRaw");
                     thiz->_current_buffer->setSize(0);
                     thiz->_current_buffer->setCapacity(MAX(thiz->_max_cache_size, bytes));
                 }
@@ -102,7 +102,6 @@ private:
     };
     std::unordered_map<int, MP4Track> _tracks;
     toolkit::BufferRaw::Ptr _current_buffer;
-    toolkit::ResourcePool<toolkit::BufferRaw> _buffer_pool;
 };
 
 }//mediakit
@@ -97,6 +97,12 @@ public:
         return _ring ? _ring->readerCount() : 0;
     }
 
+    /**
+     * 获取gop缓存占用的字节数
+     * Get the bytes occupied by the gop cache
+     */
+    size_t getGopCacheBytes() const override { return _gop_budget.bytes(); }
+
     /**
      * 获取metadata
      * Get metadata
@@ -154,6 +160,7 @@ public:
     void clearCache() override{
         PacketCache<RtmpPacket>::clearCache();
         _ring->clearCache();
+        _gop_budget.reset();
     }
 
     bool haveVideo() const {
@@ -178,13 +185,14 @@ private:
     void onFlush(std::shared_ptr<toolkit::List<RtmpPacket::Ptr> > rtmp_list, bool key_pos) override {
         // 如果不存在视频，那么就没有存在GOP缓存的意义，所以is_key一直为true确保一直清空GOP缓存  [AUTO-TRANSLATED:5818a8d8]
         // If there is no video, then there is no point in having a GOP cache, so is_key is always true to ensure that the GOP cache is always cleared
-        _ring->write(std::move(rtmp_list), _have_video ? key_pos : true);
+        _gop_budget.write(*_ring, std::move(rtmp_list), _have_video ? key_pos : true, _ring_size);
     }
 
 private:
     bool _have_video = false;
     bool _have_audio = false;
     int _ring_size;
+    GopCacheBudget _gop_budget;
     uint32_t _track_stamps[TrackMax] = {0};
     AMFValue _metadata;
     RingType::Ptr _ring;
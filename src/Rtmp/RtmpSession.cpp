@@ -10,6 +10,7 @@
 
 #include "RtmpSession.h"
 #include "Common/config.h"
+#include "Common/LatencyStatistic.h"
 #include "Util/onceToken.h"
 
 using namespace std;
@@ -65,8 +66,12 @@ void RtmpSession::onManager() {
 }
 
 void RtmpSession::onRecv(const Buffer::Ptr &buf) {
+    // 推流数据的延时追踪从读取socket数据开始
+    // Latency tracing of the pushed data starts from reading the socket data
+    LatencyTrace::Scope trace;
     _ticker.resetTime();
     _total_bytes += buf->size();
+    Metrics::add(kMetricsRtmp, kMetricsBytesIn, buf->size());
     onParseRtmp(buf->data(), buf->size());
 }
 
@@ -552,6 +557,8 @@ void RtmpSession::onRtmpChunk(RtmpPacket::Ptr packet) {
             return;
         }
 
+        LatencyTrace::mark(kLatencySplit);
+        Metrics::add(kMetricsRtmp, kMetricsPacketsIn);
         if (!_set_meta_data) {
             _set_meta_data = true;
             _push_src->setMetaData(_push_metadata ? _push_metadata : TitleMeta().getMetadata());
@@ -587,6 +594,7 @@ void RtmpSession::onCmd_seek(AMFDecoder &dec) {
 }
 
 void RtmpSession::onSendMedia(const RtmpPacket::Ptr &pkt) {
+    Metrics::add(kMetricsRtmp, kMetricsPacketsOut);
     sendRtmp(pkt->type_id, pkt->stream_index, pkt, pkt->time_stamp, pkt->chunk_id);
 }
 
@@ -19,6 +19,7 @@
 #include "RtmpMediaSourceImp.h"
 #include "Util/TimeTicker.h"
 #include "Network/Session.h"
+#include "Common/Metrics.h"
 
 namespace mediakit {
 
@@ -54,6 +55,7 @@ private:
     void onSendMedia(const RtmpPacket::Ptr &pkt);
     void onSendRawData(toolkit::Buffer::Ptr buffer) override{
         _total_bytes += buffer->size();
+        Metrics::add(kMetricsRtmp, kMetricsBytesOut, buffer->size());
         send(std::move(buffer));
     }
     void onRtmpChunk(RtmpPacket::Ptr chunk_data) override;
@@ -40,6 +40,7 @@ public:
         // GB28181推流不支持ntp时间戳  [AUTO-TRANSLATED:f661f052]
         // GB28181 streaming does not support ntp timestamps
         setNtpStamp(0, 0);
+        setMetricsProtocol(kMetricsRtp);
     }
 
     bool inputRtp(TrackType type, uint8_t *ptr, size_t len) {
@@ -355,7 +355,7 @@ void RtpSender::onSendRtpUdp(const toolkit::Buffer::Ptr &buf, bool check) {
         return;
     }
     auto rtp = static_pointer_cast<RtpPacket>(buf);
-    _rtcp_context->onRtp(rtp->getSeq(), rtp->getStamp(), rtp->ntp_stamp, 90000 /*not used*/, rtp->size());
+    _rtcp_context->onRtp(rtp->getSeq(), rtp->getStamp(), rtp->ntp_stamp, 90000 /*not used*/, rtp->getTotalSize());
 
     if (!check) {
         // 减少判断次数  [AUTO-TRANSLATED:0cfaddd8]
@@ -404,28 +404,43 @@ void RtpSender::onFlushRtpList(shared_ptr<List<Buffer::Ptr>> rtp_list) {
         size_t i = 0;
         auto size = rtp_list->size();
         rtp_list->for_each([&](Buffer::Ptr &packet) {
+            // 零拷贝rtp包引用的负载，需要紧跟rtp头发送
+            // The payload referenced by the zero copy rtp packet, which needs to be sent right after the rtp header
+            auto ref = static_pointer_cast<RtpPacket>(packet)->getPayloadRef();
             switch (_args.con_type) {
                 case MediaSourceEvent::SendRtpArgs::kUdpActive:
                 case MediaSourceEvent::SendRtpArgs::kUdpPassive: {
                     onSendRtpUdp(packet, i == 0);
                     // udp模式，rtp over tcp前4个字节可以忽略  [AUTO-TRANSLATED:5d648f4b]
                     // UDP mode, the first 4 bytes of rtp over tcp can be ignored
-                    _socket_rtp->send(std::make_shared<BufferRtp>(std::move(packet), RtpPacket::kRtpTcpHeaderSize), nullptr, 0, ++i == size);
+                    _udp_batch.addPacket(std::move(packet), RtpPacket::kRtpTcpHeaderSize, std::move(ref));
+                    if (++i == size) {
+                        _udp_batch.flush(_socket_rtp);
+                    }
                     break;
                 }
                 case MediaSourceEvent::SendRtpArgs::kTcpActive:
                 case MediaSourceEvent::SendRtpArgs::kTcpPassive: {
                     // tcp模式, rtp over tcp前2个字节可以忽略,只保留后续rtp长度的2个字节  [AUTO-TRANSLATED:a3bc338a]
                     // TCP mode, the first 2 bytes of rtp over tcp can be ignored, only the subsequent 2 bytes of rtp length are retained
-                    _socket_rtp->send(std::make_shared<BufferRtp>(std::move(packet), 2), nullptr, 0, ++i == size);
+                    _socket_rtp->send(std::make_shared<BufferRtp>(std::move(packet), 2), nullptr, 0, ++i == size && !ref);
+                    if (ref) {
+                        _socket_rtp->send(std::move(ref), nullptr, 0, i == size);
+                    }
                     break;
                 }
                 case MediaSourceEvent::SendRtpArgs::kVoiceTalk: {
                     auto type = _socket_rtp->alive() ? _socket_rtp->sockType() : SockNum::Sock_Invalid;
                     if (type == SockNum::Sock_UDP) {
-                        _socket_rtp->send(std::make_shared<BufferRtp>(std::move(packet), RtpPacket::kRtpTcpHeaderSize), nullptr, 0, ++i == size);
+                        // udp逐包发送，零拷贝rtp包需要拼接为连续内存
+                        // Udp sends packet by packet, the zero copy rtp packet needs to be joined into contiguous memory
+                        auto rtp = RtpPacket::flatten(static_pointer_cast<RtpPacket>(packet));
+                        _socket_rtp->send(std::make_shared<BufferRtp>(std::move(rtp), RtpPacket::kRtpTcpHeaderSize), nullptr, 0, ++i == size);
                     } else if (type == SockNum::Sock_TCP) {
-                        _socket_rtp->send(std::make_shared<BufferRtp>(std::move(packet), 2), nullptr, 0, ++i == size);
+                        _socket_rtp->send(std::make_shared<BufferRtp>(std::move(packet), 2), nullptr, 0, ++i == size && !ref);
+                        if (ref) {
+                            _socket_rtp->send(std::move(ref), nullptr, 0, i == size);
+                        }
                     } else {
                         onErr(SockException(Err_other, "dst socket disconnected"));
                     }
@@ -462,6 +477,7 @@ size_t RtpSender::getSendSpeed() const {
     if (_socket_rtp) {
         ret += _socket_rtp->getSendSpeed();
     }
+    ret += _udp_batch.getSendSpeed();
     if (_socket_rtcp) {
         ret += _socket_rtcp->getSendSpeed();
     }
@@ -495,6 +511,7 @@ size_t RtpSender::getSendTotalBytes() const {
     if (_socket_rtp) {
         ret += _socket_rtp->getSendTotalBytes();
     }
+    ret += _udp_batch.getSendTotalBytes();
     if (_socket_rtcp) {
         ret += _socket_rtcp->getSendTotalBytes();
     }
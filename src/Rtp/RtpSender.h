@@ -16,6 +16,7 @@
 #include "Rtcp/RtcpContext.h"
 #include "Common/MediaSource.h"
 #include "Common/MediaSink.h"
+#include "Common/UdpBatchSender.h"
 
 namespace mediakit{
 
@@ -119,6 +120,7 @@ private:
     MediaSourceEvent::SendRtpArgs _args;
     toolkit::Socket::Ptr _socket_rtp;
     toolkit::Socket::Ptr _socket_rtcp;
+    UdpBatchSender _udp_batch;
     toolkit::EventPoller::Ptr _poller;
     MediaSinkInterface::Ptr _interface;
     std::shared_ptr<RtcpContext> _rtcp_context;
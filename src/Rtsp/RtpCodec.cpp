@@ -13,10 +13,29 @@
 namespace mediakit{
 
 RtpPacket::Ptr RtpInfo::makeRtp(TrackType type, const void* data, size_t len, bool mark, uint64_t stamp) {
-    uint16_t payload_len = (uint16_t) (len + RtpPacket::kRtpHeaderSize);
-    auto rtp = RtpPacket::create();
-    rtp->setCapacity(payload_len + RtpPacket::kRtpTcpHeaderSize);
-    rtp->setSize(payload_len + RtpPacket::kRtpTcpHeaderSize);
+    auto rtp = makeRtp_l(type, len, len, mark, stamp);
+    // 有效负载  [AUTO-TRANSLATED:8530a274]
+    // payload
+    if (data) {
+        memcpy(rtp->data() + RtpPacket::kRtpHeaderSize + RtpPacket::kRtpTcpHeaderSize, data, len);
+    }
+    return rtp;
+}
+
+RtpPacket::Ptr RtpInfo::makeRtp(TrackType type, const void *head, size_t head_len, toolkit::Buffer::Ptr ref, bool mark, uint64_t stamp) {
+    auto rtp = makeRtp_l(type, head_len, head_len + ref->size(), mark, stamp);
+    memcpy(rtp->data() + RtpPacket::kRtpHeaderSize + RtpPacket::kRtpTcpHeaderSize, head, head_len);
+    rtp->setPayloadRef(std::move(ref));
+    return rtp;
+}
+
+RtpPacket::Ptr RtpInfo::makeRtp_l(TrackType type, size_t head_len, size_t payload_len, bool mark, uint64_t stamp) {
+    // tcp头中的长度为完整rtp包长度，零拷贝负载不在本对象内存中
+    // The length in the tcp header is the size of the whole rtp packet, the zero copy payload is not in the memory of this object
+    uint16_t rtp_len = (uint16_t) (payload_len + RtpPacket::kRtpHeaderSize);
+    auto rtp = RtpPacket::create(head_len != payload_len);
+    rtp->setCapacity(head_len + RtpPacket::kRtpHeaderSize + RtpPacket::kRtpTcpHeaderSize);
+    rtp->setSize(head_len + RtpPacket::kRtpHeaderSize + RtpPacket::kRtpTcpHeaderSize);
     rtp->sample_rate = _sample_rate;
     rtp->type = type;
     rtp->track_index = _track_index;
@@ -26,8 +45,8 @@ RtpPacket::Ptr RtpInfo::makeRtp(TrackType type, const void* data, size_t len, bo
     auto ptr = (uint8_t *) rtp->data();
     ptr[0] = '$';
     ptr[1] = _interleaved;
-    ptr[2] = payload_len >> 8;
-    ptr[3] = payload_len & 0xFF;
+    ptr[2] = rtp_len >> 8;
+    ptr[3] = rtp_len & 0xFF;
 
     // rtp头  [AUTO-TRANSLATED:64aef747]
     // rtp header
@@ -43,11 +62,6 @@ RtpPacket::Ptr RtpInfo::makeRtp(TrackType type, const void* data, size_t len, bo
     header->stamp = htonl(uint64_t(stamp) * _sample_rate / 1000);
     header->ssrc = htonl(_ssrc);
     rtp->ntp_stamp = stamp;
-    // 有效负载  [AUTO-TRANSLATED:8530a274]
-    // payload
-    if (data) {
-        memcpy(&ptr[RtpPacket::kRtpHeaderSize + RtpPacket::kRtpTcpHeaderSize], data, len);
-    }
     return rtp;
 }
 
@@ -84,6 +84,15 @@ public:
 
     RtpPacket::Ptr makeRtp(TrackType type,const void *data, size_t len, bool mark, uint64_t stamp);
 
+    /**
+     * 生成零拷贝rtp包，负载由拷贝的head(例如FU头)与引用的ref(原始帧内存)组成
+     * Make a zero copy rtp packet, the payload consists of the copied head (such as the FU header) and the referenced ref (memory of the original frame)
+     */
+    RtpPacket::Ptr makeRtp(TrackType type, const void *head, size_t head_len, toolkit::Buffer::Ptr ref, bool mark, uint64_t stamp);
+
+private:
+    RtpPacket::Ptr makeRtp_l(TrackType type, size_t head_len, size_t payload_len, bool mark, uint64_t stamp);
+
 private:
     uint8_t _pt;
     uint8_t _interleaved;
@@ -145,7 +145,9 @@ RtpMultiCaster::RtpMultiCaster(SocketHelper &helper, const string &local_ip, con
         auto size = pkt->size();
         pkt->for_each([&](const RtpPacket::Ptr &rtp) {
             auto &sock = _udp_sock[rtp->type];
-            sock->send(std::make_shared<BufferRtp>(rtp, 4), nullptr, 0, ++i == size);
+            // 组播逐包发送，零拷贝rtp包需要拼接为连续内存
+            // Multicast sends packet by packet, the zero copy rtp packet needs to be joined into contiguous memory
+            sock->send(std::make_shared<BufferRtp>(RtpPacket::flatten(rtp), 4), nullptr, 0, ++i == size);
         });
     });
 
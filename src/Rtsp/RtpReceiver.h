@@ -18,6 +18,7 @@
 #include "Extension/Frame.h"
 // for NtpStamp
 #include "Common/Stamp.h"
+#include "Common/Metrics.h"
 #include "Util/TimeTicker.h"
 
 namespace mediakit {
@@ -52,6 +53,12 @@ public:
      */
     size_t getJitterSize() const { return _pkt_sort_cache_map.size(); }
 
+    /**
+     * 设置丢包计入的统计指标协议，默认不统计
+     * Set the metrics protocol to which the lost packets are counted, not counted by default
+     */
+    void setMetricsProtocol(MetricsProtocol protocol) { _metrics_protocol = protocol; }
+
     /**
      * 输入并排序
      * @param seq 序列号
@@ -204,6 +211,9 @@ private:
                   << ", latest seq: " << _latest_seq
                   << ", jitter buffer size: " << _pkt_sort_cache_map.size()
                   << ", jitter buffer ms: " << _ticker.elapsedTime();
+            if (_metrics_protocol != kMetricsProtocolMax) {
+                Metrics::add(_metrics_protocol, kMetricsPacketsLost, static_cast<SEQ>(seq - _next_seq));
+            }
         }
         _next_seq = static_cast<SEQ>(seq + 1);
         _cb(seq, std::move(packet));
@@ -221,6 +231,9 @@ private:
     // seq最大跳跃距离  [AUTO-TRANSLATED:bb663e41]
     // Maximum seq jump distance
     size_t _max_distance = 256;
+    // 丢包计入的统计指标协议
+    // Metrics protocol to which the lost packets are counted
+    MetricsProtocol _metrics_protocol = kMetricsProtocolMax;
     // 记录上次output至今的时间  [AUTO-TRANSLATED:83e53e42]
     // Record the time since the last output
     toolkit::Ticker _ticker;
@@ -357,6 +370,12 @@ public:
         }
     }
 
+    void setMetricsProtocol(MetricsProtocol protocol) {
+        for (auto &track : _track) {
+            track.setMetricsProtocol(protocol);
+        }
+    }
+
     size_t getJitterSize(int index) const {
         assert(index < kCount && index >= 0);
         return _track[index].getJitterSize();
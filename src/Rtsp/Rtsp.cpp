@@ -689,18 +689,33 @@ size_t RtpPacket::getPayloadSize() const {
     return getHeader()->getPayloadSize(size() - kRtpTcpHeaderSize);
 }
 
-RtpPacket::Ptr RtpPacket::create() {
-#if 0
-    static ResourcePool<RtpPacket> packet_pool;
-    static onceToken token([]() {
-        packet_pool.setSize(1024);
-    });
-    auto ret = packet_pool.obtain2();
+// 零拷贝rtp包只保存头部，使用独立的对象池，防止复用到mtu大小的内存后被gop缓存长期占用
+// The zero copy rtp packet only saves the header, a separate object pool is used
+// to prevent it from reusing mtu-sized memory which would then be held by the gop cache
+class RtpPacketHead : public RtpPacket {};
+
+RtpPacket::Ptr RtpPacket::create(bool zero_copy) {
+    auto ret = zero_copy ? PacketPool<RtpPacket, RtpPacketHead>::obtain("RtpPacketHead") : PacketPool<RtpPacket>::obtain("RtpPacket");
     ret->setSize(0);
+    ret->_payload_ref = nullptr;
+    return ret;
+}
+
+RtpPacket::Ptr RtpPacket::flatten(const Ptr &rtp) {
+    auto &ref = rtp->_payload_ref;
+    if (!ref) {
+        return rtp;
+    }
+    auto ret = create();
+    ret->setCapacity(rtp->getTotalSize());
+    ret->setSize(rtp->getTotalSize());
+    memcpy(ret->data(), rtp->data(), rtp->size());
+    memcpy(ret->data() + rtp->size(), ref->data(), ref->size());
+    ret->type = rtp->type;
+    ret->sample_rate = rtp->sample_rate;
+    ret->ntp_stamp = rtp->ntp_stamp;
+    ret->track_index = rtp->track_index;
     return ret;
-#else
-    return Ptr(new RtpPacket);
-#endif
 }
 
 /**
@@ -186,6 +186,9 @@ public:
     uint8_t *getPayload();
     // 有效负载长度，不包括csrc、ext、padding  [AUTO-TRANSLATED:a93e4b08]
     // Valid payload length, excluding csrc, ext, padding
+    // 零拷贝rtp包的getPayload/getPayloadSize只包含本对象内存中的部分(例如FU头)，其余负载见getPayloadRef
+    // For a zero copy rtp packet, getPayload/getPayloadSize only cover the part in the memory of this object (such as the FU header),
+    // the rest of the payload is in getPayloadRef
     size_t getPayloadSize() const;
 
     // 音视频类型  [AUTO-TRANSLATED:dc0fa851]
@@ -200,18 +203,65 @@ public:
 
     int track_index;
 
-    static Ptr create();
+    /**
+     * 设置零拷贝负载，该负载引用原始帧内存，发送时追加在本对象数据之后
+     * 设置后data()/size()只包含4字节tcp头、rtp头与负载头部(例如FU头)，不包含该负载
+     * Set the zero copy payload, which references the memory of the original frame and is sent after the data of this object
+     * After setting, data()/size() only contains the 4-byte tcp header, the rtp header and the payload head (such as the FU header), excluding this payload
+     */
+    void setPayloadRef(toolkit::Buffer::Ptr ref) { _payload_ref = std::move(ref); }
+    const toolkit::Buffer::Ptr &getPayloadRef() const { return _payload_ref; }
+
+    // 完整rtp包长度，包括4字节tcp头与零拷贝负载
+    // Size of the whole rtp packet, including the 4-byte tcp header and the zero copy payload
+    size_t getTotalSize() const { return size() + (_payload_ref ? _payload_ref->size() : 0); }
+
+    /**
+     * 获取连续内存的rtp包，存在零拷贝负载时拷贝生成新的rtp包，否则返回其本身
+     * 用于需要整包连续内存的场景，例如udp逐包发送、负载解析
+     * Get the rtp packet in contiguous memory, copy to a new rtp packet if there is a zero copy payload, otherwise return itself
+     * Used in scenarios that require the whole packet in contiguous memory, such as sending udp packet by packet and payload parsing
+     */
+    static Ptr flatten(const Ptr &rtp);
+
+    /**
+     * @param zero_copy 是否用于零拷贝rtp包(只保存头部，使用独立的对象池)
+     * @param zero_copy Whether it is used for the zero copy rtp packet (only the header is saved, using a separate object pool)
+     */
+    static Ptr create(bool zero_copy = false);
+
+protected:
+    RtpPacket() = default;
 
 private:
     friend class toolkit::ResourcePool_l<RtpPacket>;
-    RtpPacket() = default;
+    template <typename T, typename Impl>
+    friend class PacketPool;
+
+    // 回收到对象池前缩小大包(例如rtp over tcp最大约64KB)的内存，对象池只保留小块内存
+    // Shrink the memory of large packets (such as rtp over tcp, up to about 64KB) before recycling to the object pool, the pool only retains small blocks
+    void onRecycle() {
+        _payload_ref = nullptr;
+        if (getCapacity() > kMaxRecycleCapacity) {
+            setCapacity(kMaxRecycleCapacity);
+        }
+    }
 
 private:
+    static constexpr size_t kMaxRecycleCapacity = 4 * 1024;
+
+    toolkit::Buffer::Ptr _payload_ref;
     // 对象个数统计  [AUTO-TRANSLATED:f4a012d0]
     // Object Count Statistics
     toolkit::ObjectStatistic<RtpPacket> _statistic;
 };
 
+// gop缓存字节预算需要统计零拷贝rtp包引用的负载
+// The gop cache byte budget needs to count the payload referenced by the zero copy rtp packet
+inline size_t getPacketBytes(const RtpPacket::Ptr &rtp) {
+    return rtp->getTotalSize();
+}
+
 class RtpPayload {
 public:
     static int getClockRate(int pt);
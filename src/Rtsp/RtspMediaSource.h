@@ -97,6 +97,12 @@ public:
         return _ring ? _ring->readerCount() : 0;
     }
 
+    /**
+     * 获取gop缓存占用的字节数
+     * Get the bytes occupied by the gop cache
+     */
+    size_t getGopCacheBytes() const override { return _gop_budget.bytes(); }
+
     /**
      * 获取该源的sdp
      * Get the sdp of this source
@@ -180,6 +186,7 @@ public:
     void clearCache() override{
         PacketCache<RtpPacket>::clearCache();
         _ring->clearCache();
+        _gop_budget.reset();
     }
 
 private:
@@ -196,12 +203,13 @@ private:
     void onFlush(std::shared_ptr<toolkit::List<RtpPacket::Ptr> > rtp_list, bool key_pos) override {
         // 如果不存在视频，那么就没有存在GOP缓存的意义，所以is_key一直为true确保一直清空GOP缓存  [AUTO-TRANSLATED:5818a8d8]
         // If there is no video, then there is no point in having a GOP cache, so is_key is always true to ensure that the GOP cache is always cleared
-        _ring->write(std::move(rtp_list), _have_video ? key_pos : true);
+        _gop_budget.write(*_ring, std::move(rtp_list), _have_video ? key_pos : true, _ring_size);
     }
 
 private:
     bool _have_video = false;
     int _ring_size;
+    GopCacheBudget _gop_budget;
     std::string _sdp;
     RingType::Ptr _ring;
     SdpTrack::Ptr _tracks[TrackMax];
@@ -50,7 +50,7 @@ void RtspMediaSource::setTimeStamp(uint32_t stamp) {
 }
 
 void RtspMediaSource::onWrite(RtpPacket::Ptr rtp, bool keyPos) {
-    _speed[rtp->type] += rtp->size();
+    _speed[rtp->type] += rtp->getTotalSize();
     assert(rtp->type >= 0 && rtp->type < TrackMax);
     auto &track = _tracks[rtp->type];
     auto stamp = rtp->getStampMS();
@@ -64,8 +64,7 @@ public:
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
-        if (_clear_cache && _option.rtsp_demand) {
-            _clear_cache = false;
+        if (_option.rtsp_demand && _clear_cache.exchange(false)) {
             _media_src->clearCache();
         }
         if (_enabled || !_option.rtsp_demand) {
@@ -77,12 +76,14 @@ public:
     bool isEnabled() {
         // 缓存尚未清空时，还允许触发inputFrame函数，以便及时清空缓存  [AUTO-TRANSLATED:7cfd4d49]
         // The inputFrame function is still allowed to be triggered when the cache has not been cleared, so that the cache can be cleared in time.
-        return _option.rtsp_demand ? (_clear_cache ? true : _enabled) : true;
+        return _option.rtsp_demand ? (_clear_cache || _enabled) : true;
     }
 
 private:
-    bool _enabled = true;
-    bool _clear_cache = false;
+    // onReaderChanged在归属线程触发，inputFrame可能在转协议流水线线程执行
+    // onReaderChanged is triggered in the owner thread, while inputFrame may run in the muxer pipeline thread
+    std::atomic<bool> _enabled { true };
+    std::atomic<bool> _clear_cache { false };
     ProtocolOption _option;
     RtspMediaSource::Ptr _media_src;
 };
@@ -31,7 +31,9 @@ enum PlayType { type_play = 0, type_pause, type_seek, type_speed };
 enum class BeatType : uint32_t { both = 0, rtcp, cmd  };
 
 RtspPlayer::RtspPlayer(const EventPoller::Ptr &poller)
-    : TcpClient(poller) {}
+    : TcpClient(poller) {
+    setMetricsProtocol(kMetricsRtsp);
+}
 
 RtspPlayer::~RtspPlayer(void) {
     DebugL;
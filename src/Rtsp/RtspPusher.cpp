@@ -370,7 +370,7 @@ void RtspPusher::updateRtcpContext(const RtpPacket::Ptr &rtp){
     int track_index = getTrackIndexByTrackType(rtp->type);
     auto &ticker = _rtcp_send_ticker[track_index];
     auto &rtcp_ctx = _rtcp_context[track_index];
-    rtcp_ctx->onRtp(rtp->getSeq(), rtp->getStamp(), rtp->ntp_stamp, rtp->sample_rate, rtp->size() - RtpPacket::kRtpTcpHeaderSize);
+    rtcp_ctx->onRtp(rtp->getSeq(), rtp->getStamp(), rtp->ntp_stamp, rtp->sample_rate, rtp->getTotalSize() - RtpPacket::kRtpTcpHeaderSize);
     if (!rtp->ntp_stamp && !rtp->getStamp()) {
         // 忽略时间戳都为0的rtp  [AUTO-TRANSLATED:6b793565]
         // Ignore RTP with all timestamps being 0
@@ -407,10 +407,19 @@ void RtspPusher::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
             setSendFlushFlag(false);
             pkt->for_each([&](const RtpPacket::Ptr &rtp) {
                 updateRtcpContext(rtp);
-                if (++i == size) {
+                auto &ref = rtp->getPayloadRef();
+                if (++i == size && !ref) {
                     setSendFlushFlag(true);
                 }
                 send(rtp);
+                if (ref) {
+                    // 零拷贝负载紧跟rtp头发送
+                    // The zero copy payload is sent right after the rtp header
+                    if (i == size) {
+                        setSendFlushFlag(true);
+                    }
+                    send(ref);
+                }
             });
             break;
         }
@@ -427,7 +436,9 @@ void RtspPusher::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
                     return;
                 }
 
-                pSock->send(std::make_shared<BufferRtp>(rtp, RtpPacket::kRtpTcpHeaderSize), nullptr, 0, ++i == size);
+                // udp逐包发送，零拷贝rtp包需要拼接为连续内存
+                // Udp sends packet by packet, the zero copy rtp packet needs to be joined into contiguous memory
+                pSock->send(std::make_shared<BufferRtp>(RtpPacket::flatten(rtp), RtpPacket::kRtpTcpHeaderSize), nullptr, 0, ++i == size);
             });
             break;
         }
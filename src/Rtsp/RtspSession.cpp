@@ -11,6 +11,7 @@
 #include <atomic>
 #include <iomanip>
 #include "Common/config.h"
+#include "Common/LatencyStatistic.h"
 #include "UDPServer.h"
 #include "RtspSession.h"
 #include "Util/MD5.h"
@@ -54,6 +55,7 @@ static recursive_mutex g_mtxGetter;
 RtspSession::RtspSession(const Socket::Ptr &sock) : Session(sock) {
     GET_CONFIG(uint32_t,keep_alive_sec,Rtsp::kKeepAliveSecond);
     sock->setSendTimeOutSecond(keep_alive_sec);
+    setMetricsProtocol(kMetricsRtsp);
 }
 
 void RtspSession::onError(const SockException &err) {
@@ -115,8 +117,12 @@ void RtspSession::onManager() {
 }
 
 void RtspSession::onRecv(const Buffer::Ptr &buf) {
+    // 推流数据的延时追踪从读取socket数据开始
+    // Latency tracing of the pushed data starts from reading the socket data
+    LatencyTrace::Scope trace;
     _alive_ticker.resetTime();
     _bytes_usage += buf->size();
+    Metrics::add(kMetricsRtsp, kMetricsBytesIn, buf->size());
     if (_on_recv) {
         //http poster的请求数据转发给http getter处理
         _on_recv(buf);
@@ -167,6 +173,8 @@ void RtspSession::onWholeRtspPacket(Parser &parser) {
 void RtspSession::onRtpPacket(const char *data, size_t len) {
     uint8_t interleaved = data[1];
     if (interleaved % 2 == 0) {
+        LatencyTrace::mark(kLatencySplit);
+        Metrics::add(kMetricsRtsp, kMetricsPacketsIn);
         CHECK(len > RtpPacket::kRtpHeaderSize + RtpPacket::kRtpTcpHeaderSize);
         RtpHeader *header = (RtpHeader *)(data + RtpPacket::kRtpTcpHeaderSize);
         auto track_idx = getTrackIndexByPT(header->pt);
@@ -970,6 +978,7 @@ void RtspSession::send_NotAcceptable() {
 }
 
 void RtspSession::onRtpSorted(RtpPacket::Ptr rtp, int track_idx) {
+    LatencyTrace::mark(kLatencySort);
     if (_push_src) {
         _push_src->onWrite(std::move(rtp), false);
     } else {
@@ -978,12 +987,15 @@ void RtspSession::onRtpSorted(RtpPacket::Ptr rtp, int track_idx) {
 }
 
 void RtspSession::onRcvPeerUdpData(int interleaved, const Buffer::Ptr &buf, const struct sockaddr_storage &addr) {
+    LatencyTrace::Scope trace;
     //这是rtcp心跳包，说明播放器还存活
     _alive_ticker.resetTime();
+    Metrics::add(kMetricsRtsp, kMetricsBytesIn, buf->size());
 
     if (interleaved % 2 == 0) {
         if (_push_src) {
             //这是rtsp推流上来的rtp包
+            Metrics::add(kMetricsRtsp, kMetricsPacketsIn);
             auto &ref = _sdp_track[interleaved / 2];
             handleOneRtp(interleaved / 2, ref->_type, ref->_samplerate, (uint8_t *) buf->data(), buf->size());
         } else if (!_udp_connected_flags.count(interleaved)) {
@@ -1193,6 +1205,36 @@ string RtspSession::getOriginUrl(MediaSource &sender) const {
     return _media_info.full_url;
 }
 
+size_t RtspSession::getSendSpeed() {
+    size_t ret = getSock()->getSendSpeed();
+    for (auto i = 0; i < 2; ++i) {
+        if (_rtp_socks[i]) {
+            ret += _rtp_socks[i]->getSendSpeed();
+        }
+        if (_rtcp_socks[i]) {
+            ret += _rtcp_socks[i]->getSendSpeed();
+        }
+        // sendmmsg直接写socket fd，不经过Socket的发送统计
+        // sendmmsg writes the socket fd directly, bypassing the send statistics of Socket
+        ret += _udp_batch[i].getSendSpeed();
+    }
+    return ret;
+}
+
+size_t RtspSession::getSendTotalBytes() {
+    size_t ret = getSock()->getSendTotalBytes();
+    for (auto i = 0; i < 2; ++i) {
+        if (_rtp_socks[i]) {
+            ret += _rtp_socks[i]->getSendTotalBytes();
+        }
+        if (_rtcp_socks[i]) {
+            ret += _rtcp_socks[i]->getSendTotalBytes();
+        }
+        ret += _udp_batch[i].getSendTotalBytes();
+    }
+    return ret;
+}
+
 std::shared_ptr<SockInfo> RtspSession::getOriginSock(MediaSource &sender) const {
     return const_cast<RtspSession *>(this)->shared_from_this();
 }
@@ -1208,7 +1250,7 @@ void RtspSession::onBeforeRtpSorted(const RtpPacket::Ptr &rtp, int track_index){
 void RtspSession::updateRtcpContext(const RtpPacket::Ptr &rtp){
     int track_index = getTrackIndexByTrackType(rtp->type);
     auto &rtcp_ctx = _rtcp_context[track_index];
-    rtcp_ctx->onRtp(rtp->getSeq(), rtp->getStamp(), rtp->ntp_stamp, rtp->sample_rate, rtp->size() - RtpPacket::kRtpTcpHeaderSize);
+    rtcp_ctx->onRtp(rtp->getSeq(), rtp->getStamp(), rtp->ntp_stamp, rtp->sample_rate, rtp->getTotalSize() - RtpPacket::kRtpTcpHeaderSize);
     if (!rtp->ntp_stamp && !rtp->getStamp()) {
         // 忽略时间戳都为0的rtp
         return;
@@ -1242,13 +1284,23 @@ void RtspSession::updateRtcpContext(const RtpPacket::Ptr &rtp){
 }
 
 void RtspSession::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
+    // 先在本地累加，每批只更新一次统计指标
+    // Accumulate locally first, update the metrics only once per batch
+    size_t bytes = 0, packets = 0;
     switch (_rtp_type) {
         case Rtsp::RTP_TCP: {
             setSendFlushFlag(false);
             pkt->for_each([&](const RtpPacket::Ptr &rtp) {
                 if (_target_play_track == TrackInvalid || _target_play_track == rtp->type) {
                     updateRtcpContext(rtp);
+                    bytes += rtp->getTotalSize();
+                    ++packets;
                     send(rtp);
+                    if (auto &ref = rtp->getPayloadRef()) {
+                        // 零拷贝负载紧跟rtp头发送，合并为同一次writev
+                        // The zero copy payload is sent right after the rtp header, merged into the same writev
+                        send(ref);
+                    }
                 }
             });
             flushAll();
@@ -1268,13 +1320,15 @@ void RtspSession::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
                         shutdown(SockException(Err_shutdown, "udp sock not opened yet"));
                         return;
                     }
-                    _bytes_usage += rtp->size() - RtpPacket::kRtpTcpHeaderSize;
-                    sock->send(std::make_shared<BufferRtp>(rtp, RtpPacket::kRtpTcpHeaderSize), nullptr, 0, false);
+                    _bytes_usage += rtp->getTotalSize() - RtpPacket::kRtpTcpHeaderSize;
+                    bytes += rtp->getTotalSize() - RtpPacket::kRtpTcpHeaderSize;
+                    ++packets;
+                    _udp_batch[rtp->type].addPacket(rtp, RtpPacket::kRtpTcpHeaderSize, rtp->getPayloadRef());
                 }
             });
-            for (auto &sock : rtp_socks) {
-                if (sock) {
-                    sock->flushAll();
+            for (auto i = 0; i < 2; ++i) {
+                if (rtp_socks[i]) {
+                    _udp_batch[i].flush(rtp_socks[i]);
                 }
             }
         }
@@ -1282,6 +1336,8 @@ void RtspSession::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
         default:
             break;
     }
+    Metrics::add(kMetricsRtsp, kMetricsBytesOut, bytes);
+    Metrics::add(kMetricsRtsp, kMetricsPacketsOut, packets);
 }
 
 void RtspSession::setSocketFlags(){
@@ -21,6 +21,7 @@
 #include "RtspMediaSource.h"
 #include "RtspMediaSourceImp.h"
 #include "RtpMultiCaster.h"
+#include "Common/UdpBatchSender.h"
 
 namespace mediakit {
 
@@ -36,6 +37,19 @@ public:
     using onAuth = std::function<void(bool encrypted, const std::string &pwd_or_md5)>;
 
     RtspSession(const toolkit::Socket::Ptr &sock);
+
+    /**
+     * 获取发送速率，单位bytes/s，包括rtsp信令、rtp/rtcp udp端口以及udp批量发送的数据
+     * Get the send speed, in bytes/s, including rtsp signaling, rtp/rtcp udp ports and the data sent in udp batch
+     */
+    size_t getSendSpeed();
+
+    /**
+     * 获取发送的总字节数，包括rtsp信令、rtp/rtcp udp端口以及udp批量发送的数据
+     * Get the total bytes sent, including rtsp signaling, rtp/rtcp udp ports and the data sent in udp batch
+     */
+    size_t getSendTotalBytes();
+
     ////Session override////
     void onRecv(const toolkit::Buffer::Ptr &buf) override;
     void onError(const toolkit::SockException &err) override;
@@ -252,6 +266,9 @@ private:
     // RTCP端口,trackid idx 为数组下标  [AUTO-TRANSLATED:446a7861]
     // RTCP port, trackid idx is the array index
     toolkit::Socket::Ptr _rtcp_socks[2];
+    // udp rtp批量发送器，TrackType为数组下标
+    // Udp rtp batch sender, TrackType is the array index
+    UdpBatchSender _udp_batch[2];
     // 标记是否收到播放的udp打洞包,收到播放的udp打洞包后才能知道其外网udp端口号  [AUTO-TRANSLATED:ad039c25]
     // Flag whether the UDP hole punching packet for playback has been received. The external UDP port number can only be known after receiving the UDP hole punching packet for playback.
     std::unordered_set<int> _udp_connected_flags;
@@ -52,8 +52,7 @@ public:
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
-        if (_clear_cache && _option.ts_demand) {
-            _clear_cache = false;
+        if (_option.ts_demand && _clear_cache.exchange(false)) {
             _media_src->clearCache();
         }
         if (_enabled || !_option.ts_demand) {
@@ -65,7 +64,7 @@ public:
     bool isEnabled() {
         // 缓存尚未清空时，还允许触发inputFrame函数，以便及时清空缓存  [AUTO-TRANSLATED:7cfd4d49]
         // Allow the inputFrame function to be triggered even when the cache is not yet cleared, so that the cache can be cleared in time.
-        return _option.ts_demand ? (_clear_cache ? true : _enabled) : true;
+        return _option.ts_demand ? (_clear_cache || _enabled) : true;
     }
 
 protected:
@@ -79,8 +78,10 @@ protected:
     }
 
 private:
-    bool _enabled = true;
-    bool _clear_cache = false;
+    // onReaderChanged在归属线程触发，inputFrame可能在转协议流水线线程执行
+    // onReaderChanged is triggered in the owner thread, while inputFrame may run in the muxer pipeline thread
+    std::atomic<bool> _enabled { true };
+    std::atomic<bool> _clear_cache { false };
     ProtocolOption _option;
     TSMediaSource::Ptr _media_src;
 };
@@ -7,6 +7,7 @@
 #include "Ack.hpp"
 #include "Packet.hpp"
 #include "SrtTransport.hpp"
+#include "Common/Metrics.h"
 
 namespace SRT {
 #define SRT_FIELD "srt."
@@ -93,6 +94,7 @@ void SrtTransport::createTimerForCheckAlive(){
 
 void SrtTransport::inputSockData(uint8_t *buf, int len, struct sockaddr_storage *addr) {
     _alive_ticker.resetTime();
+    mediakit::Metrics::add(mediakit::kMetricsSrt, mediakit::kMetricsBytesIn, len);
     if(!_timer){
         createTimerForCheckAlive();
     }
@@ -437,6 +439,7 @@ void SrtTransport::tryAnnounceKeyMaterial() {
 
 void SrtTransport::handleNAK(uint8_t *buf, int len, struct sockaddr_storage *addr) {
     // TraceL;
+    mediakit::Metrics::add(mediakit::kMetricsSrt, mediakit::kMetricsNackIn);
     NAKPacket pkt;
     pkt.loadFromData(buf, len);
     bool empty = false;
@@ -484,6 +487,7 @@ void SrtTransport::handleDropReq(uint8_t *buf, int len, struct sockaddr_storage
         // max_seq = data->packet_seq_number;
         if (_last_pkt_seq + 1 != data->packet_seq_number) {
             TraceL << "pkt lost " << _last_pkt_seq + 1 << "->" << data->packet_seq_number;
+            mediakit::Metrics::add(mediakit::kMetricsSrt, mediakit::kMetricsPacketsLost, (data->packet_seq_number - _last_pkt_seq - 1) & MAX_SEQ);
         }
         _last_pkt_seq = data->packet_seq_number;
         onSRTData(std::move(data));
@@ -680,6 +684,7 @@ void SrtTransport::sendLightACKPacket() {
 }
 
 void SrtTransport::sendNAKPacket(std::list<PacketQueue::LostPair> &lost_list) {
+    mediakit::Metrics::add(mediakit::kMetricsSrt, mediakit::kMetricsNackOut);
     NAKPacket::Ptr pkt = std::make_shared<NAKPacket>();
     std::list<PacketQueue::LostPair> tmp;
     auto size = NAKPacket::getCIFSize(lost_list);
@@ -747,6 +752,7 @@ void SrtTransport::sendShutDown() {
 }
 
 void SrtTransport::handleDataPacket(uint8_t *buf, int len, struct sockaddr_storage *addr) {
+    mediakit::Metrics::add(mediakit::kMetricsSrt, mediakit::kMetricsPacketsIn);
     DataPacket::Ptr pkt = std::make_shared<DataPacket>();
     pkt->loadFromData(buf, len);
 
@@ -774,6 +780,7 @@ void SrtTransport::handleDataPacket(uint8_t *buf, int len, struct sockaddr_stora
             // last_seq = data->packet_seq_number;
             if (_last_pkt_seq + 1 != data->packet_seq_number) {
                 TraceL << "pkt lost " << _last_pkt_seq + 1 << "->" << data->packet_seq_number;
+                mediakit::Metrics::add(mediakit::kMetricsSrt, mediakit::kMetricsPacketsLost, (data->packet_seq_number - _last_pkt_seq - 1) & MAX_SEQ);
             }
             _last_pkt_seq = data->packet_seq_number;
             onSRTData(std::move(data));
@@ -846,6 +853,7 @@ void SrtTransport::sendDataPacket(DataPacket::Ptr pkt, char *buf, int len, bool
     }
 
     pkt->storeToData((uint8_t *)data, size);
+    mediakit::Metrics::add(mediakit::kMetricsSrt, mediakit::kMetricsPacketsOut);
     sendPacket(pkt, flush);
     _send_buf->inputPacket(pkt);
     return;
@@ -859,6 +867,7 @@ void SrtTransport::sendPacket(Buffer::Ptr pkt, bool flush) {
     if (_selected_session) {
         auto tmp = _packet_pool.obtain2();
         tmp->assign(pkt->data(), pkt->size());
+        mediakit::Metrics::add(mediakit::kMetricsSrt, mediakit::kMetricsBytesOut, pkt->size());
         _selected_session->setSendFlushFlag(flush);
         _selected_session->send(std::move(tmp));
     } else {
@@ -0,0 +1,208 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_SAMPLESTREAM_H
+#define ZLMEDIAKIT_SAMPLESTREAM_H
+
+#include <string>
+#include <vector>
+#include "Extension/Factory.h"
+
+// 测试程序共用的合成码流，由固定种子生成，不依赖外部媒体文件
+// Synthetic bitstreams shared by the test programs, generated with a fixed seed, without depending on external media files
+
+namespace mediakit {
+
+// 固定种子的伪随机数，保证不同版本之间的样本码流完全一致
+// Pseudo-random numbers with a fixed seed, to ensure that the sample bitstreams are exactly the same between versions
+class SampleRandom {
+public:
+    uint8_t next() {
+        _seed = _seed * 1103515245 + 12345;
+        return (_seed >> 16) & 0xFF;
+    }
+
+private:
+    uint32_t _seed = 20160101;
+};
+
+class BitWriter {
+public:
+    void put(uint32_t value, int bits) {
+        for (int i = bits - 1; i >= 0; --i) {
+            _cur = (_cur << 1) | ((value >> i) & 1);
+            if (++_bits == 8) {
+                _buf.push_back(_cur);
+                _cur = 0;
+                _bits = 0;
+            }
+        }
+    }
+
+    void ue(uint32_t value) {
+        ++value;
+        int len = 0;
+        for (auto tmp = value; tmp > 1; tmp >>= 1) {
+            ++len;
+        }
+        put(0, len);
+        put(value, len + 1);
+    }
+
+    // rbsp_trailing_bits并插入防竞争字节
+    // rbsp_trailing_bits and insert emulation prevention bytes
+    std::string finish() {
+        put(1, 1);
+        while (_bits) {
+            put(0, 1);
+        }
+        std::string ret;
+        int zeros = 0;
+        for (auto byte : _buf) {
+            if (zeros >= 2 && (uint8_t)byte <= 3) {
+                ret.push_back(3);
+                zeros = 0;
+            }
+            ret.push_back(byte);
+            zeros = byte ? 0 : zeros + 1;
+        }
+        return ret;
+    }
+
+private:
+    std::string _buf;
+    uint8_t _cur = 0;
+    int _bits = 0;
+};
+
+struct SampleFrame {
+    std::string data;
+    uint64_t dts;
+};
+
+struct SampleStream {
+    CodecId codec;
+    // 一个gop的帧，每帧一个nal(带00 00 00 01前缀)
+    // Frames of a gop, one nal (with 00 00 00 01 prefix) per frame
+    std::vector<SampleFrame> frames;
+    // 整个gop的annexb码流
+    // Annexb bitstream of the whole gop
+    std::string annexb;
+    std::vector<Frame::Ptr> toFrames(uint64_t dts_offset = 0) const {
+        std::vector<Frame::Ptr> ret;
+        for (auto &frame : frames) {
+            ret.emplace_back(Factory::getFrameFromPtr(codec, frame.data.data(), frame.data.size(), frame.dts + dts_offset, frame.dts + dts_offset));
+        }
+        return ret;
+    }
+};
+
+inline void addNal(SampleStream &stream, const std::string &nal, uint64_t dts) {
+    std::string data = std::string("\x00\x00\x00\x01", 4) + nal;
+    stream.annexb += data;
+    stream.frames.emplace_back(SampleFrame { std::move(data), dts });
+}
+
+inline std::string makeSlice(SampleRandom &random, const std::string &header, size_t size) {
+    std::string ret = header;
+    // first_mb_in_slice/first_slice_segment_in_pic_flag为1，表示一帧的开始
+    // first_mb_in_slice/first_slice_segment_in_pic_flag is 1, indicating the beginning of a frame
+    ret.push_back((char)(0x80 | random.next()));
+    while (ret.size() < size) {
+        // 负载不包含0，无需防竞争字节
+        // The payload does not contain 0, no emulation prevention byte is needed
+        auto byte = random.next();
+        ret.push_back(byte ? byte : 1);
+    }
+    return ret;
+}
+
+// 720p 25fps，gop为50帧，关键帧60KB，其他帧8KB
+// 720p 25fps, gop is 50 frames, 60KB for key frames and 8KB for others
+static constexpr size_t kGopSize = 50;
+static constexpr size_t kKeyFrameBytes = 60 * 1024;
+static constexpr size_t kFrameBytes = 8 * 1024;
+static constexpr uint64_t kFrameDuration = 40;
+
+inline SampleStream makeH264Sample() {
+    SampleStream ret;
+    ret.codec = CodecH264;
+    SampleRandom random;
+
+    BitWriter sps;
+    sps.put(0x67, 8);
+    // baseline, level 3.1
+    sps.put(66, 8);
+    sps.put(0xC0, 8);
+    sps.put(31, 8);
+    // seq_parameter_set_id, log2_max_frame_num_minus4, pic_order_cnt_type, max_num_ref_frames
+    sps.ue(0);
+    sps.ue(0);
+    sps.ue(2);
+    sps.ue(1);
+    // gaps_in_frame_num_value_allowed_flag
+    sps.put(0, 1);
+    // 1280x720
+    sps.ue(1280 / 16 - 1);
+    sps.ue(720 / 16 - 1);
+    // frame_mbs_only_flag, direct_8x8_inference_flag, frame_cropping_flag, vui_parameters_present_flag
+    sps.put(1, 1);
+    sps.put(1, 1);
+    sps.put(0, 1);
+    sps.put(0, 1);
+
+    BitWriter pps;
+    pps.put(0x68, 8);
+    // pic_parameter_set_id, seq_parameter_set_id
+    pps.ue(0);
+    pps.ue(0);
+    // entropy_coding_mode_flag, bottom_field_pic_order_in_frame_present_flag
+    pps.put(0, 2);
+    // num_slice_groups_minus1, num_ref_idx_l0_default_active_minus1, num_ref_idx_l1_default_active_minus1
+    pps.ue(0);
+    pps.ue(0);
+    pps.ue(0);
+    // weighted_pred_flag, weighted_bipred_idc
+    pps.put(0, 3);
+    // pic_init_qp_minus26, pic_init_qs_minus26, chroma_qp_index_offset
+    pps.ue(0);
+    pps.ue(0);
+    pps.ue(0);
+    // deblocking_filter_control_present_flag, constrained_intra_pred_flag, redundant_pic_cnt_present_flag
+    pps.put(4, 3);
+
+    addNal(ret, sps.finish(), 0);
+    addNal(ret, pps.finish(), 0);
+    for (size_t i = 0; i < kGopSize; ++i) {
+        auto dts = i * kFrameDuration;
+        addNal(ret, i ? makeSlice(random, "\x41", kFrameBytes) : makeSlice(random, "\x65", kKeyFrameBytes), dts);
+    }
+    return ret;
+}
+
+inline SampleStream makeH265Sample() {
+    SampleStream ret;
+    ret.codec = CodecH265;
+    SampleRandom random;
+    // vps/sps/pps只用于rtp打包测试，内容不做解析
+    // Vps/sps/pps are only used for rtp packing tests, and the content is not parsed
+    addNal(ret, makeSlice(random, std::string("\x40\x01", 2), 24), 0);
+    addNal(ret, makeSlice(random, std::string("\x42\x01", 2), 40), 0);
+    addNal(ret, makeSlice(random, std::string("\x44\x01", 2), 8), 0);
+    for (size_t i = 0; i < kGopSize; ++i) {
+        auto dts = i * kFrameDuration;
+        // IDR_W_RADL / TRAIL_R
+        addNal(ret, i ? makeSlice(random, std::string("\x02\x01", 2), kFrameBytes) : makeSlice(random, std::string("\x26\x01", 2), kKeyFrameBytes), dts);
+    }
+    return ret;
+}
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_SAMPLESTREAM_H
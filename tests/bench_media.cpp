@@ -0,0 +1,448 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "Util/logger.h"
+#include "Util/CMD.h"
+#include "Common/config.h"
+#include "Extension/Factory.h"
+#include "ext-codec/H264.h"
+#include "ext-codec/NalScanner.h"
+#include "Rtsp/RtpReceiver.h"
+#include "Rtsp/RtspMuxer.h"
+#include "Rtmp/RtmpProtocol.h"
+#include "Record/MPEG.h"
+#include "Record/MP4Muxer.h"
+#include "Rtp/PSDecoder.h"
+#include "Http/WebSocketSplitter.h"
+#include "SampleStream.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+class CMD_main : public CMD {
+public:
+    CMD_main() {
+        _parser.reset(new OptionParser(nullptr));
+
+        (*_parser) << Option('l',/*该选项简称，如果是\x00则说明无简称*/
+                             "level",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             to_string(LWarn).data(),/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "日志等级,LTrace~LError(0~4)",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('t',/*该选项简称，如果是\x00则说明无简称*/
+                             "time",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "1000",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "每项测试的最短运行时间,单位毫秒",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('f',/*该选项简称，如果是\x00则说明无简称*/
+                             "filter",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "只运行名称包含该字符串的测试项",/*该选项说明文字*/
+                             nullptr);
+    }
+
+    ~CMD_main() override {}
+
+    const char *description() const override {
+        return "主程序命令参数";
+    }
+};
+
+static Track::Ptr makeTrack(const SampleStream &stream) {
+    auto track = Factory::getTrackByCodecId(stream.codec);
+    for (auto &frame : stream.toFrames()) {
+        track->inputFrame(frame);
+        if (track->ready()) {
+            break;
+        }
+    }
+    return track;
+}
+
+//////////////////////////////////////////测试框架//////////////////////////////////////////
+
+static size_t s_min_ms = 1000;
+static string s_filter;
+
+/**
+ * 运行一项测试，至少运行s_min_ms毫秒
+ * @param name 测试项名称
+ * @param bytes 每次迭代处理的字节数
+ * @param items 每次迭代处理的帧(包)数
+ * @param func 一次迭代
+ * Run a test item for at least s_min_ms milliseconds
+ * @param name Test item name
+ * @param bytes Bytes processed per iteration
+ * @param items Frames (packets) processed per iteration
+ * @param func One iteration
+ */
+static void runBench(const string &name, size_t bytes, size_t items, const function<void()> &func) {
+    if (!s_filter.empty() && name.find(s_filter) == string::npos) {
+        return;
+    }
+    // 预热
+    // Warm up
+    func();
+    size_t iterations = 0;
+    auto start = chrono::steady_clock::now();
+    double elapsed_ns = 0;
+    do {
+        func();
+        ++iterations;
+        elapsed_ns = (double)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    } while (elapsed_ns < s_min_ms * 1000000.0);
+
+    auto seconds = elapsed_ns / 1e9;
+    cout << left << setw(28) << name << right << setw(10) << iterations << setw(14) << fixed << setprecision(1)
+         << elapsed_ns / (iterations * items) << setw(12) << setprecision(1) << bytes * iterations / seconds / 1024 / 1024
+         << setw(14) << setprecision(0) << items * iterations / seconds << endl;
+}
+
+template <typename T>
+class RingDelegateImp : public RingDelegate<T> {
+public:
+    RingDelegateImp(function<void(T)> cb) { _cb = std::move(cb); }
+    void onWrite(T in, bool is_key) override { _cb(std::move(in)); }
+
+private:
+    function<void(T)> _cb;
+};
+
+// 样本码流的每帧都必须带4字节起始码，否则各测试项测量的是无效码流
+// Every frame of the sample bitstream must have a 4-byte start code, otherwise the test items measure an invalid bitstream
+static bool checkSample(const string &name, const SampleStream &stream) {
+    for (auto &frame : stream.frames) {
+        if (prefixSize(frame.data.data(), frame.data.size()) != 4) {
+            WarnL << name << " sample frame has no start code, dts: " << frame.dts;
+            return false;
+        }
+    }
+    return true;
+}
+
+//////////////////////////////////////////测试项//////////////////////////////////////////
+
+static void benchSplit(const SampleStream &h264) {
+    size_t count = 0;
+    runBench(string("splitH264/") + nalScannerName(), h264.annexb.size(), h264.frames.size(), [&]() {
+        splitH264(h264.annexb.data(), h264.annexb.size(), 4, [&](const char *ptr, size_t len, size_t prefix) { count += len; });
+    });
+
+    runBench(string("findEmulationPrevention/") + nalScannerName(), h264.annexb.size(), h264.frames.size(), [&]() {
+        auto ptr = h264.annexb.data();
+        auto end = ptr + h264.annexb.size();
+        while ((ptr = findEmulationPrevention(ptr, end))) {
+            ptr += 3;
+            ++count;
+        }
+    });
+
+    runBench("prefixSize", h264.annexb.size(), h264.frames.size(), [&]() {
+        for (auto &frame : h264.frames) {
+            count += prefixSize(frame.data.data(), frame.data.size());
+        }
+    });
+}
+
+static vector<RtpPacket::Ptr> benchRtp(const string &name, const SampleStream &stream) {
+    vector<RtpPacket::Ptr> rtps;
+    auto encoder = Factory::getRtpEncoderByCodecId(stream.codec, 96);
+    encoder->setRtpInfo(0, 1400, 90000, 96);
+    auto ring = std::make_shared<RtpRing::RingType>();
+    ring->setDelegate(std::make_shared<RingDelegateHelper>([&](RtpPacket::Ptr rtp, bool is_key) { rtps.emplace_back(std::move(rtp)); }));
+    encoder->setRtpRing(std::move(ring));
+
+    uint64_t dts_offset = 0;
+    runBench(name + " rtp encode", stream.annexb.size(), stream.frames.size(), [&]() {
+        rtps.clear();
+        for (auto &frame : stream.toFrames(dts_offset)) {
+            encoder->inputFrame(frame);
+        }
+        dts_offset += kGopSize * kFrameDuration;
+    });
+
+    auto decoder = Factory::getRtpDecoderByCodecId(stream.codec);
+    size_t bytes = 0;
+    decoder->addDelegate([&](const Frame::Ptr &frame) {
+        bytes += frame->size();
+        return true;
+    });
+    // 解码出的帧不能比输入的码流短，否则测量的是不完整的帧(例如只解析了零拷贝rtp包的FU头)
+    // The decoded frames must not be shorter than the input bitstream, otherwise incomplete frames are measured
+    // (such as only the FU header of the zero copy rtp packet is parsed)
+    for (auto &rtp : rtps) {
+        decoder->inputRtp(rtp, false);
+    }
+    if (bytes < stream.annexb.size()) {
+        WarnL << name << " rtp decode output " << bytes << " bytes, less than the input " << stream.annexb.size() << " bytes";
+    }
+    runBench(name + " rtp decode", stream.annexb.size(), rtps.size(), [&]() {
+        for (auto &rtp : rtps) {
+            decoder->inputRtp(rtp, false);
+        }
+    });
+    return rtps;
+}
+
+static void benchSortor(const vector<RtpPacket::Ptr> &rtps) {
+    PacketSortor<RtpPacket::Ptr> sortor;
+    size_t count = 0;
+    sortor.setOnSort([&](uint16_t seq, RtpPacket::Ptr rtp) { ++count; });
+    uint16_t seq = 0;
+    auto rtp = rtps[0];
+    runBench("PacketSortor::sortPacket", 0, rtps.size(), [&]() {
+        for (size_t i = 0; i < rtps.size(); ++i) {
+            // 每8个包有一次乱序
+            // There is one out-of-order every 8 packets
+            auto index = i % 8 == 2 ? i + 3 : (i % 8 == 5 ? i - 3 : i);
+            sortor.sortPacket(seq + index, rtp);
+        }
+        seq += rtps.size();
+    });
+}
+
+class RtmpProtocolImp : public RtmpProtocol {
+public:
+    using RtmpProtocol::sendRtmp;
+    using RtmpProtocol::sendChunkSize;
+
+    string sent;
+    size_t chunks = 0;
+
+protected:
+    void onSendRawData(Buffer::Ptr buffer) override { sent.append(buffer->data(), buffer->size()); }
+    void onRtmpChunk(RtmpPacket::Ptr chunk_data) override { ++chunks; }
+};
+
+static void benchRtmp(const SampleStream &h264) {
+    auto track = makeTrack(h264);
+    auto encoder = Factory::getRtmpEncoderByTrack(track);
+    vector<RtmpPacket::Ptr> packets;
+    auto ring = std::make_shared<RtmpRing::RingType>();
+    ring->setDelegate(std::make_shared<RingDelegateImp<RtmpPacket::Ptr> >([&](RtmpPacket::Ptr pkt) { packets.emplace_back(std::move(pkt)); }));
+    encoder->setRtmpRing(ring);
+
+    uint64_t dts_offset = 0;
+    runBench("H264 rtmp encode", h264.annexb.size(), h264.frames.size(), [&]() {
+        packets.clear();
+        for (auto &frame : h264.toFrames(dts_offset)) {
+            encoder->inputFrame(frame);
+        }
+        encoder->flush();
+        dts_offset += kGopSize * kFrameDuration;
+    });
+
+    // 在内存中完成握手
+    // Complete the handshake in memory
+    RtmpProtocolImp client, server;
+    bool handshake = false;
+    client.startClientSession([&]() { handshake = true; }, false);
+    while (!client.sent.empty() || !server.sent.empty()) {
+        auto data = std::move(client.sent);
+        client.sent.clear();
+        server.onParseRtmp(data.data(), data.size());
+        data = std::move(server.sent);
+        server.sent.clear();
+        client.onParseRtmp(data.data(), data.size());
+    }
+    if (!handshake) {
+        WarnL << "rtmp handshake failed";
+        return;
+    }
+    client.sendChunkSize(60000);
+    server.onParseRtmp(client.sent.data(), client.sent.size());
+    client.sent.clear();
+    for (auto &pkt : packets) {
+        client.sendRtmp(pkt->type_id, pkt->stream_index, pkt, pkt->time_stamp, pkt->chunk_id);
+    }
+    auto chunks = client.sent;
+    runBench("RtmpProtocol::onParseRtmp", chunks.size(), packets.size(), [&]() {
+        // 模拟每次从socket读取4KB
+        // Simulate reading 4KB from the socket each time
+        for (size_t offset = 0; offset < chunks.size(); offset += 4096) {
+            server.onParseRtmp(chunks.data() + offset, MIN((size_t)4096, chunks.size() - offset));
+        }
+    });
+}
+
+#if defined(ENABLE_HLS) || defined(ENABLE_RTPPROXY)
+class MpegMuxerImp : public MpegMuxer {
+public:
+    MpegMuxerImp(bool is_ps) : MpegMuxer(is_ps) {}
+
+    string output;
+
+protected:
+    void onWrite(std::shared_ptr<Buffer> buffer, uint64_t timestamp, bool key_pos) override {
+        if (buffer) {
+            output.append(buffer->data(), buffer->size());
+        }
+    }
+};
+
+static string benchMpeg(const SampleStream &h264, bool is_ps) {
+    MpegMuxerImp muxer(is_ps);
+    muxer.addTrack(makeTrack(h264));
+    muxer.addTrackCompleted();
+    uint64_t dts_offset = 0;
+    runBench(is_ps ? "MpegMuxer ps" : "MpegMuxer ts", h264.annexb.size(), h264.frames.size(), [&]() {
+        muxer.output.clear();
+        for (auto &frame : h264.toFrames(dts_offset)) {
+            muxer.inputFrame(frame);
+        }
+        muxer.flush();
+        dts_offset += kGopSize * kFrameDuration;
+    });
+    return muxer.output;
+}
+#endif
+
+#if defined(ENABLE_RTPPROXY)
+static void benchPSDecoder(const string &ps) {
+    PSDecoder decoder;
+    size_t count = 0;
+    decoder.setOnDecode([&](int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t bytes) { ++count; });
+    runBench("PSDecoder", ps.size(), kGopSize, [&]() {
+        // 模拟每个rtp包1400字节负载
+        // Simulate 1400 bytes of payload per rtp packet
+        for (size_t offset = 0; offset < ps.size(); offset += 1400) {
+            decoder.input((const uint8_t *)ps.data() + offset, MIN((size_t)1400, ps.size() - offset));
+        }
+    });
+}
+#endif
+
+#if defined(ENABLE_MP4)
+class MP4MuxerMemoryImp : public MP4MuxerMemory {
+public:
+    size_t bytes = 0;
+
+protected:
+    void onSegmentData(std::string string, uint64_t stamp, bool key_frame) override { bytes += string.size(); }
+};
+
+static void benchMP4(const SampleStream &h264) {
+    MP4MuxerMemoryImp muxer;
+    muxer.addTrack(makeTrack(h264));
+    muxer.addTrackCompleted();
+    uint64_t dts_offset = 0;
+    runBench("MP4MuxerMemory", h264.annexb.size(), h264.frames.size(), [&]() {
+        for (auto &frame : h264.toFrames(dts_offset)) {
+            muxer.inputFrame(frame);
+        }
+        dts_offset += kGopSize * kFrameDuration;
+    });
+}
+#endif
+
+class WebSocketSplitterImp : public WebSocketSplitter {
+public:
+    string encoded;
+    size_t decoded = 0;
+
+protected:
+    void onWebSocketEncodeData(Buffer::Ptr buffer) override { encoded.append(buffer->data(), buffer->size()); }
+    void onWebSocketDecodePayload(const WebSocketHeader &header, const uint8_t *ptr, size_t len, size_t recved) override { decoded += len; }
+};
+
+static void benchWebSocket(const SampleStream &h264) {
+    // 以ws-flv典型的每个消息一帧为例
+    // Take one frame per message, which is typical for ws-flv
+    vector<Buffer::Ptr> payloads;
+    for (auto &frame : h264.frames) {
+        payloads.emplace_back(std::make_shared<BufferString>(frame.data));
+    }
+    WebSocketSplitterImp splitter;
+    WebSocketHeader header;
+    header._fin = true;
+    header._reserved = 0;
+    header._opcode = WebSocketHeader::BINARY;
+    header._mask_flag = false;
+    runBench("WebSocketSplitter encode", h264.annexb.size(), payloads.size(), [&]() {
+        splitter.encoded.clear();
+        for (auto &payload : payloads) {
+            splitter.encode(header, payload);
+        }
+    });
+
+    // 客户端发送的消息带掩码
+    // Messages sent by the client are masked
+    header._mask_flag = true;
+    vector<string> messages;
+    for (auto &payload : payloads) {
+        splitter.encoded.clear();
+        splitter.encode(header, payload);
+        messages.emplace_back(splitter.encoded);
+    }
+    runBench("WebSocketSplitter decode", h264.annexb.size(), messages.size(), [&]() {
+        for (auto &message : messages) {
+            splitter.decode((uint8_t *)&message[0], message.size());
+        }
+    });
+}
+
+// 此程序用于测试热点编解码与复用函数的吞吐量，所有测试使用固定的合成码流，便于对比不同版本的性能
+// This program is used to test the throughput of hot codec and muxer functions,
+// all tests use fixed synthetic bitstreams, which is convenient for comparing the performance of different versions
+int main(int argc, char *argv[]) {
+    CMD_main cmd_main;
+    try {
+        cmd_main.operator()(argc, argv);
+    } catch (ExitException &) {
+        return 0;
+    } catch (std::exception &ex) {
+        cout << ex.what() << endl;
+        return -1;
+    }
+
+    LogLevel logLevel = (LogLevel) cmd_main["level"].as<int>();
+    logLevel = MIN(MAX(logLevel, LTrace), LError);
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", logLevel));
+    s_min_ms = MAX(cmd_main["time"].as<int>(), 1);
+    s_filter = cmd_main["filter"];
+
+    auto h264 = makeH264Sample();
+    auto h265 = makeH265Sample();
+    if (!checkSample("H264", h264) || !checkSample("H265", h265)) {
+        return -1;
+    }
+
+    cout << left << setw(28) << "benchmark" << right << setw(10) << "iterations" << setw(14) << "ns/item" << setw(12) << "MB/s" << setw(14)
+         << "items/s" << endl;
+    benchSplit(h264);
+    auto rtps = benchRtp("H264", h264);
+    benchRtp("H265", h265);
+    benchSortor(rtps);
+    benchRtmp(h264);
+#if defined(ENABLE_HLS) || defined(ENABLE_RTPPROXY)
+    benchMpeg(h264, false);
+    auto ps = benchMpeg(h264, true);
+#if defined(ENABLE_RTPPROXY)
+    benchPSDecoder(ps);
+#endif
+#endif
+#if defined(ENABLE_MP4)
+    benchMP4(h264);
+#endif
+    benchWebSocket(h264);
+    return 0;
+}
@@ -0,0 +1,688 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <signal.h>
+#include <thread>
+#include <fstream>
+#include <iostream>
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+#include "json/json.h"
+#include "Util/logger.h"
+#include "Util/util.h"
+#include "Util/CMD.h"
+#include "Util/TimeTicker.h"
+#include "Network/TcpServer.h"
+#include "Thread/WorkThreadPool.h"
+#include "Common/config.h"
+#include "Common/Device.h"
+#include "Common/LatencyStatistic.h"
+#include "Rtsp/RtspSession.h"
+#include "Rtmp/RtmpSession.h"
+#include "Rtmp/FlvSplitter.h"
+#include "Rtmp/utils.h"
+#include "Http/HttpSession.h"
+#include "Http/HttpClientImp.h"
+#include "Http/WebSocketClient.h"
+#include "Player/MediaPlayer.h"
+#include "SampleStream.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+class CMD_main : public CMD {
+public:
+    CMD_main() {
+        _parser.reset(new OptionParser(nullptr));
+
+        (*_parser) << Option('l',/*该选项简称，如果是\x00则说明无简称*/
+                             "level",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             to_string(LWarn).data(),/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "日志等级,LTrace~LError(0~4)",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('n',/*该选项简称，如果是\x00则说明无简称*/
+                             "streams",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "1",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "推流个数",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('m',/*该选项简称，如果是\x00则说明无简称*/
+                             "readers",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "1",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "每路流每个协议的播放器个数",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('p',/*该选项简称，如果是\x00则说明无简称*/
+                             "protocols",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "rtsp_tcp,rtsp_udp,rtmp,flv,ws_flv,hls,ts,fmp4",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "播放协议,以逗号分隔",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('w',/*该选项简称，如果是\x00则说明无简称*/
+                             "warmup",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "10",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "所有播放器启动后到开始统计的间隔,单位秒",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('t',/*该选项简称，如果是\x00则说明无简称*/
+                             "time",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "30",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "统计时长,单位秒",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('d',/*该选项简称，如果是\x00则说明无简称*/
+                             "delay",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "10",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "启动播放器间隔,单位毫秒",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('s',/*该选项简称，如果是\x00则说明无简称*/
+                             "server_threads",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             to_string(thread::hardware_concurrency()).data(),/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "服务器网络线程数",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('c',/*该选项简称，如果是\x00则说明无简称*/
+                             "client_threads",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             to_string(thread::hardware_concurrency()).data(),/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "播放器线程数",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('P',/*该选项简称，如果是\x00则说明无简称*/
+                             "port",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "25540",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "rtsp端口,rtmp与http端口依次加1",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('o',/*该选项简称，如果是\x00则说明无简称*/
+                             "out",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "json报告保存路径,为空时打印到标准输出",/*该选项说明文字*/
+                             nullptr);
+    }
+
+    ~CMD_main() override {}
+
+    const char *description() const override {
+        return "主程序命令参数";
+    }
+};
+
+static constexpr char kApp[] = "bench";
+static uint16_t s_rtsp_port = 0;
+static uint16_t s_rtmp_port = 0;
+static uint16_t s_http_port = 0;
+
+// 同一协议所有播放器的统计
+// Statistics of all players of the same protocol
+struct ProtocolStat {
+    string name;
+    atomic<uint64_t> frames { 0 };
+    atomic<uint64_t> bytes { 0 };
+    atomic<uint64_t> playing { 0 };
+    atomic<uint64_t> failures { 0 };
+    // 从发起播放到收到第一帧视频的耗时，单位微秒
+    // Time from starting to play to receiving the first video frame, in microseconds
+    LatencyHistogram startup;
+    // 帧到达抖动(相邻两帧到达间隔与时间戳间隔之差的绝对值)，单位微秒
+    // Frame arrival jitter (absolute difference between the arrival interval and the timestamp interval of adjacent frames), in microseconds
+    LatencyHistogram jitter;
+};
+
+static string makeUrl(const string &protocol, size_t index) {
+    auto stream = "s" + to_string(index);
+    if (protocol == "rtsp_tcp" || protocol == "rtsp_udp") {
+        return StrPrinter << "rtsp://127.0.0.1:" << s_rtsp_port << "/" << kApp << "/" << stream;
+    }
+    if (protocol == "rtmp") {
+        return StrPrinter << "rtmp://127.0.0.1:" << s_rtmp_port << "/" << kApp << "/" << stream;
+    }
+    if (protocol == "flv") {
+        return StrPrinter << "http://127.0.0.1:" << s_http_port << "/" << kApp << "/" << stream << ".live.flv";
+    }
+    if (protocol == "ws_flv") {
+        return StrPrinter << "ws://127.0.0.1:" << s_http_port << "/" << kApp << "/" << stream << ".live.flv";
+    }
+    if (protocol == "hls") {
+        return StrPrinter << "http://127.0.0.1:" << s_http_port << "/" << kApp << "/" << stream << "/hls.m3u8";
+    }
+    if (protocol == "ts") {
+        return StrPrinter << "http://127.0.0.1:" << s_http_port << "/" << kApp << "/" << stream << ".live.ts";
+    }
+    if (protocol == "fmp4") {
+        return StrPrinter << "http://127.0.0.1:" << s_http_port << "/" << kApp << "/" << stream << ".live.mp4";
+    }
+    throw std::invalid_argument("not supported protocol: " + protocol);
+}
+
+//////////////////////////////////////////播放器//////////////////////////////////////////
+
+using onVideo = function<void(uint64_t stamp, size_t bytes)>;
+using onFailed = function<void(const SockException &ex)>;
+
+// MediaPlayer不支持ws-flv，直接解析websocket负载中的flv tag
+// MediaPlayer does not support ws-flv, parse the flv tags in the websocket payload directly
+class WsFlvClient : public TcpClient, public FlvSplitter {
+public:
+    WsFlvClient(const EventPoller::Ptr &poller) : TcpClient(poller) {}
+
+    onVideo on_video;
+    onFailed on_failed;
+
+protected:
+    void onConnect(const SockException &ex) override {
+        if (ex) {
+            on_failed(ex);
+        }
+    }
+    void onRecv(const Buffer::Ptr &buf) override { input(buf->data(), buf->size()); }
+    void onError(const SockException &ex) override { on_failed(ex); }
+    bool onRecvMetadata(const AMFValue &metadata) override { return true; }
+    void onRecvRtmpPacket(RtmpPacket::Ptr packet) override {
+        if (packet->type_id == MSG_VIDEO && !packet->isConfigFrame()) {
+            on_video(packet->time_stamp, packet->size());
+        }
+    }
+};
+
+// MediaPlayer不支持http-fmp4，按box切分，每个moof+mdat为一帧，时间戳取自tfdt
+// MediaPlayer does not support http-fmp4, split it by box, each moof+mdat is a frame, and the timestamp is taken from tfdt
+class Fmp4Client : public HttpClientImp {
+public:
+    Fmp4Client(const EventPoller::Ptr &poller) { setPoller(poller); }
+
+    onVideo on_video;
+    onFailed on_failed;
+
+protected:
+    void onResponseHeader(const string &status, const HttpHeader &headers) override {
+        if (status != "200") {
+            shutdown(SockException(Err_other, "bad http status code:" + status));
+        }
+    }
+
+    void onResponseBody(const char *buf, size_t size) override {
+        _buffer.append(buf, size);
+        size_t offset = 0;
+        while (_buffer.size() - offset >= 8) {
+            auto ptr = (const uint8_t *)_buffer.data() + offset;
+            size_t box_size = load_be32(ptr);
+            if (box_size < 8) {
+                shutdown(SockException(Err_other, "invalid mp4 box"));
+                return;
+            }
+            if (_buffer.size() - offset < box_size) {
+                break;
+            }
+            if (!memcmp(ptr + 4, "moof", 4)) {
+                _stamp = parseTfdt(ptr, box_size);
+                _moof_size = box_size;
+            } else if (!memcmp(ptr + 4, "mdat", 4)) {
+                on_video(_stamp, _moof_size + box_size);
+            }
+            offset += box_size;
+        }
+        _buffer.erase(0, offset);
+    }
+
+    void onResponseCompleted(const SockException &ex) override {
+        // 直播流不会正常结束
+        // The live stream will not end normally
+        on_failed(ex ? ex : SockException(Err_eof, "http-fmp4 stream ended"));
+    }
+
+private:
+    // fmp4直播的时间刻度为毫秒
+    // The timescale of fmp4 live streaming is milliseconds
+    static uint64_t parseTfdt(const uint8_t *ptr, size_t size) {
+        auto end = ptr + size;
+        for (auto pos = ptr + 8; pos + 16 <= end; ++pos) {
+            if (memcmp(pos, "tfdt", 4)) {
+                continue;
+            }
+            if (pos[4] == 1) {
+                return ((uint64_t)load_be32(pos + 8) << 32) | load_be32(pos + 12);
+            }
+            return load_be32(pos + 8);
+        }
+        return 0;
+    }
+
+private:
+    string _buffer;
+    uint64_t _stamp = 0;
+    size_t _moof_size = 0;
+};
+
+class BenchReader : public std::enable_shared_from_this<BenchReader> {
+public:
+    using Ptr = std::shared_ptr<BenchReader>;
+
+    BenchReader(ProtocolStat &stat, string url, EventPoller::Ptr poller) : _stat(stat) {
+        _url = std::move(url);
+        _poller = std::move(poller);
+    }
+
+    bool failed() const { return _failed; }
+
+    /**
+     * 在播放器线程(重新)开始播放
+     * (Re)start playing in the player thread
+     */
+    void start() {
+        weak_ptr<BenchReader> weak_self = shared_from_this();
+        _poller->async([weak_self]() {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->start_l();
+            }
+        });
+    }
+
+private:
+    void start_l() {
+        _failed = false;
+        _got_first = false;
+        _start_time = getCurrentMicrosecond();
+
+        weak_ptr<BenchReader> weak_self = shared_from_this();
+        auto on_video = [weak_self](uint64_t stamp, size_t bytes) {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->onVideo(stamp, bytes);
+            }
+        };
+        auto on_failed = [weak_self](const SockException &ex) {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->onFailed(ex);
+            }
+        };
+
+        if (_stat.name == "ws_flv") {
+            auto client = std::make_shared<WebSocketClient<WsFlvClient, WebSocketHeader::BINARY> >(_poller);
+            client->on_video = std::move(on_video);
+            client->on_failed = std::move(on_failed);
+            client->startWebSocket(_url);
+            _client = std::move(client);
+            return;
+        }
+
+        if (_stat.name == "fmp4") {
+            auto client = std::make_shared<Fmp4Client>(_poller);
+            client->on_video = std::move(on_video);
+            client->on_failed = std::move(on_failed);
+            client->setMethod("GET");
+            client->sendRequest(_url);
+            _client = std::move(client);
+            return;
+        }
+
+        auto player = std::make_shared<MediaPlayer>(_poller);
+        weak_ptr<MediaPlayer> weak_player = player;
+        player->setOnPlayResult([weak_player, on_video, on_failed](const SockException &ex) {
+            auto strong_player = weak_player.lock();
+            if (!strong_player) {
+                return;
+            }
+            if (ex) {
+                on_failed(ex);
+                return;
+            }
+            auto video = strong_player->getTrack(TrackVideo, false);
+            if (!video) {
+                on_failed(SockException(Err_other, "no video track"));
+                return;
+            }
+            video->addDelegate([on_video](const Frame::Ptr &frame) {
+                if (!frame->configFrame()) {
+                    on_video(frame->dts(), frame->size());
+                }
+                return true;
+            });
+        });
+        player->setOnShutdown(on_failed);
+        (*player)[Client::kRtpType] = (int)(_stat.name == "rtsp_udp" ? Rtsp::RTP_UDP : Rtsp::RTP_TCP);
+        player->play(_url);
+        _client = std::move(player);
+    }
+
+    void onVideo(uint64_t stamp, size_t bytes) {
+        auto now = getCurrentMicrosecond();
+        if (!_got_first) {
+            _got_first = true;
+            ++_stat.playing;
+            _stat.startup.record(now - _start_time);
+        } else {
+            int64_t diff = (int64_t)(now - _last_arrival) - ((int64_t)stamp - (int64_t)_last_stamp) * 1000;
+            _stat.jitter.record(diff > 0 ? diff : -diff);
+        }
+        _last_arrival = now;
+        _last_stamp = stamp;
+        ++_stat.frames;
+        _stat.bytes += bytes;
+    }
+
+    void onFailed(const SockException &ex) {
+        if (_failed) {
+            return;
+        }
+        WarnL << "play " << _url << " failed: " << ex;
+        _failed = true;
+        ++_stat.failures;
+        if (_got_first) {
+            --_stat.playing;
+        }
+    }
+
+private:
+    bool _got_first = false;
+    atomic<bool> _failed { false };
+    uint64_t _start_time = 0;
+    uint64_t _last_arrival = 0;
+    uint64_t _last_stamp = 0;
+    string _url;
+    ProtocolStat &_stat;
+    EventPoller::Ptr _poller;
+    std::shared_ptr<void> _client;
+};
+
+//////////////////////////////////////////推流//////////////////////////////////////////
+
+class BenchStream : public std::enable_shared_from_this<BenchStream> {
+public:
+    using Ptr = std::shared_ptr<BenchStream>;
+
+    BenchStream(const SampleStream &sample, size_t index) : _sample(sample) {
+        _poller = EventPollerPool::Instance().getPoller();
+        ProtocolOption option;
+        option.enable_rtsp = true;
+        option.enable_rtmp = true;
+        option.enable_hls = true;
+        option.enable_ts = true;
+        option.enable_fmp4 = true;
+        option.enable_mp4 = false;
+        option.rtsp_demand = option.rtmp_demand = option.hls_demand = option.ts_demand = option.fmp4_demand = false;
+        // 在归属线程创建DevChannel，确保线程安全
+        // Create DevChannel in the owner thread to ensure thread safety
+        _poller->sync([&]() {
+            _channel = std::make_shared<DevChannel>(MediaTuple { DEFAULT_VHOST, kApp, "s" + to_string(index) }, 0, option);
+            VideoInfo info;
+            info.codecId = _sample.codec;
+            info.iWidth = 1280;
+            info.iHeight = 720;
+            info.iFrameRate = 1000.0f / kFrameDuration;
+            _channel->initVideo(info);
+            _channel->addTrackCompleted();
+        });
+    }
+
+    void start() {
+        weak_ptr<BenchStream> weak_self = shared_from_this();
+        _poller->doDelayTask(kFrameDuration / 4, [weak_self]() -> uint64_t {
+            auto strong_self = weak_self.lock();
+            if (!strong_self) {
+                return 0;
+            }
+            strong_self->onTimer();
+            return kFrameDuration / 4;
+        });
+    }
+
+private:
+    // 按时间戳匀速输入帧，循环使用样本gop
+    // Input frames at a constant rate according to the timestamp, looping the sample gop
+    void onTimer() {
+        auto &frames = _sample.frames;
+        while (true) {
+            auto &frame = frames[_index];
+            auto dts = _loop * kGopSize * kFrameDuration + frame.dts;
+            if (dts > _ticker.elapsedTime()) {
+                break;
+            }
+            _channel->inputH264(frame.data.data(), frame.data.size(), dts, dts);
+            if (++_index == frames.size()) {
+                _index = 0;
+                ++_loop;
+            }
+        }
+    }
+
+private:
+    size_t _index = 0;
+    uint64_t _loop = 0;
+    Ticker _ticker;
+    const SampleStream &_sample;
+    EventPoller::Ptr _poller;
+    DevChannel::Ptr _channel;
+};
+
+//////////////////////////////////////////统计//////////////////////////////////////////
+
+static uint64_t getProcessCpuTime() {
+#if !defined(_WIN32)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    }
+#endif
+    return 0;
+}
+
+static Json::Value makeHistogram(const LatencyHistogram &histogram) {
+    auto value = histogram.getValue();
+    Json::Value ret;
+    ret["count"] = (Json::UInt64)value.count;
+    ret["avg"] = value.avg / 1000.0;
+    ret["p50"] = value.p50 / 1000.0;
+    ret["p90"] = value.p90 / 1000.0;
+    ret["p99"] = value.p99 / 1000.0;
+    ret["max"] = value.max / 1000.0;
+    return ret;
+}
+
+// 此程序在进程内启动rtsp/rtmp/http服务器，推送N路合成码流，每路流每个协议启动M个播放器，全部通过回环网络，
+// 统计各协议的吞吐量、播放器启动耗时、帧到达抖动以及每路流的服务器cpu占用，并输出json报告，用于部署前评估硬件规格。
+// 服务器使用网络线程池，播放器使用后台线程池，服务器cpu占用由网络线程的负载估算
+// This program starts rtsp/rtmp/http servers in process, pushes N synthetic streams, and starts M players per protocol per stream, all over the loopback network.
+// It measures the throughput of each protocol, player startup time, frame arrival jitter and server cpu usage per stream, and outputs a json report,
+// which is used to size the hardware before deployment.
+// The servers use the network thread pool and the players use the background thread pool, the server cpu usage is estimated from the load of the network threads
+int main(int argc, char *argv[]) {
+    CMD_main cmd_main;
+    try {
+        cmd_main.operator()(argc, argv);
+    } catch (ExitException &) {
+        return 0;
+    } catch (std::exception &ex) {
+        cout << ex.what() << endl;
+        return -1;
+    }
+
+    LogLevel logLevel = (LogLevel) cmd_main["level"].as<int>();
+    logLevel = MIN(MAX(logLevel, LTrace), LError);
+    size_t stream_count = MAX(cmd_main["streams"].as<int>(), 1);
+    size_t reader_count = MAX(cmd_main["readers"].as<int>(), 0);
+    auto warmup_sec = MAX(cmd_main["warmup"].as<int>(), 0);
+    auto duration_sec = MAX(cmd_main["time"].as<int>(), 1);
+    auto delay_ms = cmd_main["delay"].as<int>();
+    auto server_threads = MAX(cmd_main["server_threads"].as<int>(), 1);
+    auto client_threads = MAX(cmd_main["client_threads"].as<int>(), 1);
+    s_rtsp_port = cmd_main["port"].as<uint16_t>();
+    s_rtmp_port = s_rtsp_port + 1;
+    s_http_port = s_rtsp_port + 2;
+
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", logLevel));
+    Logger::Instance().setWriter(std::make_shared<AsyncLogWriter>());
+
+    // 服务器与播放器分别使用不同的线程池，以便单独统计服务器的cpu占用
+    // The servers and the players use different thread pools, so that the cpu usage of the servers can be measured separately
+    EventPollerPool::setPoolSize(server_threads);
+    WorkThreadPool::setPoolSize(client_threads);
+
+    vector<std::shared_ptr<ProtocolStat> > protocols;
+    for (auto &name : split(cmd_main["protocols"], ",")) {
+        auto stat = std::make_shared<ProtocolStat>();
+        stat->name = trim(name);
+        try {
+            makeUrl(stat->name, 0);
+        } catch (std::exception &ex) {
+            cout << ex.what() << endl;
+            return -1;
+        }
+        protocols.emplace_back(std::move(stat));
+    }
+
+    TcpServer::Ptr rtsp_server(new TcpServer());
+    TcpServer::Ptr rtmp_server(new TcpServer());
+    TcpServer::Ptr http_server(new TcpServer());
+    try {
+        rtsp_server->start<RtspSession>(s_rtsp_port, "127.0.0.1");
+        rtmp_server->start<RtmpSession>(s_rtmp_port, "127.0.0.1");
+        http_server->start<HttpSession>(s_http_port, "127.0.0.1");
+    } catch (std::exception &ex) {
+        ErrorL << "start server failed: " << ex.what();
+        return -1;
+    }
+
+    auto sample = makeH264Sample();
+    vector<BenchStream::Ptr> streams;
+    for (size_t i = 0; i < stream_count; ++i) {
+        auto stream = std::make_shared<BenchStream>(sample, i);
+        stream->start();
+        streams.emplace_back(std::move(stream));
+    }
+    // 等待第一个gop，使播放器能立即开始播放
+    // Wait for the first gop so that the players can start playing immediately
+    sleep(1);
+
+    static bool exit_flag = false;
+    signal(SIGINT, [](int) { exit_flag = true; });
+
+    vector<BenchReader::Ptr> readers;
+    for (size_t i = 0; i < stream_count && !exit_flag; ++i) {
+        for (auto &stat : protocols) {
+            for (size_t j = 0; j < reader_count && !exit_flag; ++j) {
+                auto reader = std::make_shared<BenchReader>(*stat, makeUrl(stat->name, i), WorkThreadPool::Instance().getPoller());
+                reader->start();
+                readers.emplace_back(std::move(reader));
+                if (delay_ms > 0) {
+                    usleep(1000 * delay_ms);
+                }
+            }
+        }
+    }
+
+    auto restart_failed = [&]() {
+        for (auto &reader : readers) {
+            if (reader->failed()) {
+                reader->start();
+            }
+        }
+    };
+
+    for (auto i = 0; i < warmup_sec && !exit_flag; ++i) {
+        sleep(1);
+        restart_failed();
+    }
+
+    // 开始统计
+    // Start statistics
+    vector<uint64_t> frames_start, bytes_start;
+    for (auto &stat : protocols) {
+        frames_start.emplace_back(stat->frames);
+        bytes_start.emplace_back(stat->bytes);
+    }
+    vector<uint64_t> load_sum(server_threads, 0);
+    size_t load_samples = 0;
+    auto cpu_start = getProcessCpuTime();
+    Ticker ticker;
+    for (auto i = 0; i < duration_sec && !exit_flag; ++i) {
+        sleep(1);
+        auto loads = EventPollerPool::Instance().getExecutorLoad();
+        for (size_t j = 0; j < loads.size() && j < load_sum.size(); ++j) {
+            load_sum[j] += loads[j];
+        }
+        ++load_samples;
+        restart_failed();
+    }
+    auto elapsed_sec = MAX(ticker.elapsedTime(), (uint64_t)1) / 1000.0;
+    auto cpu_used = getProcessCpuTime() - cpu_start;
+
+    Json::Value report;
+    auto &config = report["config"];
+    config["streams"] = (Json::UInt64)stream_count;
+    config["readers_per_protocol"] = (Json::UInt64)reader_count;
+    config["server_threads"] = server_threads;
+    config["client_threads"] = client_threads;
+    config["duration_sec"] = elapsed_sec;
+    config["stream_kbps"] = sample.annexb.size() * 8.0 / (kGopSize * kFrameDuration);
+
+    auto &server = report["server"];
+    double load_total = 0;
+    for (auto load : load_sum) {
+        auto avg = load_samples ? (double)load / load_samples : 0;
+        server["thread_load"].append(avg);
+        load_total += avg;
+    }
+    // 100表示占满一个cpu核
+    // 100 means one cpu core is fully occupied
+    server["cpu_percent"] = load_total;
+    server["cpu_percent_per_stream"] = load_total / stream_count;
+#if !defined(_WIN32)
+    // 包含播放器的cpu占用
+    // Including the cpu usage of the players
+    server["process_cpu_percent"] = cpu_used / 10000.0 / elapsed_sec;
+#endif
+
+    auto &protocol_report = report["protocols"];
+    for (size_t i = 0; i < protocols.size(); ++i) {
+        auto &stat = *protocols[i];
+        auto &item = protocol_report[stat.name];
+        item["readers"] = (Json::UInt64)(reader_count * stream_count);
+        item["playing"] = (Json::UInt64)stat.playing.load();
+        item["failures"] = (Json::UInt64)stat.failures.load();
+        item["frames_per_sec"] = (stat.frames - frames_start[i]) / elapsed_sec;
+        item["kbps"] = (stat.bytes - bytes_start[i]) * 8 / 1000.0 / elapsed_sec;
+        item["startup_ms"] = makeHistogram(stat.startup);
+        item["jitter_ms"] = makeHistogram(stat.jitter);
+    }
+
+    auto out = cmd_main["out"];
+    if (out.empty()) {
+        cout << report.toStyledString() << endl;
+    } else {
+        ofstream(out) << report.toStyledString();
+        InfoL << "report saved to: " << out;
+    }
+    return 0;
+}
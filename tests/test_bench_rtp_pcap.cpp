@@ -0,0 +1,592 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+#include <thread>
+#include <signal.h>
+#include <unordered_set>
+#include <iostream>
+#include <iomanip>
+#include <pcap.h>
+#include "Util/logger.h"
+#include "Util/util.h"
+#include "Util/CMD.h"
+#include "Util/TimeTicker.h"
+#include "Network/Socket.h"
+#include "Thread/WorkThreadPool.h"
+#include "Common/config.h"
+#include "Common/Metrics.h"
+#include "Common/MultiMediaSourceMuxer.h"
+#include "Rtsp/Rtsp.h"
+#include "Rtmp/utils.h"
+#include "Rtp/RtpServer.h"
+#include "Rtp/RtpProcess.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+class CMD_main : public CMD {
+public:
+    CMD_main() {
+        _parser.reset(new OptionParser(nullptr));
+
+        (*_parser) << Option('l',/*该选项简称，如果是\x00则说明无简称*/
+                             "level",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             to_string(LWarn).data(),/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "日志等级,LTrace~LError(0~4)",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('i',/*该选项简称，如果是\x00则说明无简称*/
+                             "in",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             nullptr,/*该选项默认值*/
+                             true,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "pcap文件路径,多个文件以逗号分隔,文件中每个ssrc为一路流",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('k',/*该选项简称，如果是\x00则说明无简称*/
+                             "copies",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "1",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "每路流复制的份数,每份使用不同的ssrc与源端口,模拟不同设备",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('x',/*该选项简称，如果是\x00则说明无简称*/
+                             "speed",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "1,2,5,10,20,50,100",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "回放倍速,多个倍速以逗号分隔,依次测试",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('t',/*该选项简称，如果是\x00则说明无简称*/
+                             "time",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "10",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "每个倍速的统计时长,单位秒",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('w',/*该选项简称，如果是\x00则说明无简称*/
+                             "warmup",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "5",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "开始统计前以第一个倍速预热的时长,单位秒",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('m',/*该选项简称，如果是\x00则说明无简称*/
+                             "mode",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "server",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "server:通过回环udp发送到RtpServer; process:直接输入RtpProcess,不经过网络",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('P',/*该选项简称，如果是\x00则说明无简称*/
+                             "port",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "30000",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "server模式下第一个RtpServer的端口",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('p',/*该选项简称，如果是\x00则说明无简称*/
+                             "ports",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "1",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "server模式下RtpServer的个数(单端口多路复用),流依次分配到各端口",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('s',/*该选项简称，如果是\x00则说明无简称*/
+                             "server_threads",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             to_string(thread::hardware_concurrency()).data(),/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "服务器网络线程数",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('c',/*该选项简称，如果是\x00则说明无简称*/
+                             "sender_threads",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             to_string(thread::hardware_concurrency()).data(),/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "server模式下发送线程数",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('L',/*该选项简称，如果是\x00则说明无简称*/
+                             "loss",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "0.1",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "相对第一个倍速增加的丢包率超过该百分比时，认为处理能力已饱和",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('a',/*该选项简称，如果是\x00则说明无简称*/
+                             "all_protocol",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "0",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "是否按配置文件转协议,默认只转rtsp以便聚焦解复用性能",/*该选项说明文字*/
+                             nullptr);
+    }
+
+    ~CMD_main() override {}
+
+    const char *description() const override {
+        return "主程序命令参数";
+    }
+};
+
+//////////////////////////////////////////pcap加载//////////////////////////////////////////
+
+struct ReplayPacket {
+    // 相对该流第一个包的时间，单位微秒
+    // Time relative to the first packet of the stream, in microseconds
+    uint64_t time;
+    string data;
+};
+
+// pcap中的一路rtp流(一个ssrc)
+// An rtp stream (one ssrc) in the pcap
+struct ReplayFlow {
+    vector<ReplayPacket> packets;
+    // 循环一次的时长、序号跨度与时间戳跨度，用于循环回放时保持序号与时间戳连续
+    // Duration, sequence span and timestamp span of one loop, used to keep sequence and timestamp continuous when looping
+    uint64_t duration = 0;
+    uint32_t seq_span = 0;
+    uint32_t stamp_span = 0;
+};
+
+static bool loadPcap(const string &path, vector<std::shared_ptr<ReplayFlow> > &flows) {
+    char errbuf[PCAP_ERRBUF_SIZE] = { '\0' };
+    std::shared_ptr<pcap_t> handle(pcap_open_offline(path.data(), errbuf), [](pcap_t *handle) {
+        if (handle) {
+            pcap_close(handle);
+        }
+    });
+    if (!handle) {
+        WarnL << "open file failed:" << path << ", error: " << errbuf;
+        return false;
+    }
+
+    size_t link_len;
+    switch (pcap_datalink(handle.get())) {
+        case DLT_EN10MB: link_len = 14; break;
+        case DLT_LINUX_SLL: link_len = 16; break;
+        case DLT_NULL: link_len = 4; break;
+        case DLT_RAW: link_len = 0; break;
+        default: WarnL << "unsupported pcap link type: " << pcap_datalink(handle.get()); return false;
+    }
+
+    struct FlowContext {
+        std::shared_ptr<ReplayFlow> flow;
+        uint64_t first_time = 0;
+        uint32_t first_stamp = 0;
+        uint32_t last_stamp = 0;
+        uint16_t last_seq = 0;
+        uint32_t seq_span = 0;
+        size_t stamp_count = 0;
+    };
+    map<uint32_t, FlowContext> contexts;
+
+    struct pcap_pkthdr *header;
+    const u_char *pkt;
+    while (pcap_next_ex(handle.get(), &header, &pkt) == 1) {
+        size_t offset = link_len;
+        if (link_len == 14 && header->caplen >= 18 && pkt[12] == 0x81 && pkt[13] == 0x00) {
+            // vlan
+            offset += 4;
+        }
+        // 只支持ipv4 udp，且不处理ip分片
+        // Only ipv4 udp is supported, and ip fragments are not processed
+        if (header->caplen < offset + 20 || (pkt[offset] >> 4) != 4 || pkt[offset + 9] != 17 || (load_be16(pkt + offset + 6) & 0x3FFF)) {
+            continue;
+        }
+        offset += (pkt[offset] & 0x0F) * 4;
+        if (header->caplen < offset + 8) {
+            continue;
+        }
+        size_t len = load_be16(pkt + offset + 4);
+        offset += 8;
+        if (len < 8 + RtpPacket::kRtpHeaderSize || header->caplen < offset + len - 8) {
+            continue;
+        }
+        len -= 8;
+        auto rtp = (const RtpHeader *)(pkt + offset);
+        // 跳过rtcp(pt 200~204)与非rtp包
+        // Skip rtcp (pt 200~204) and non-rtp packets
+        if (rtp->version != RtpPacket::kRtpVersion || (pkt[offset + 1] >= 200 && pkt[offset + 1] <= 204)) {
+            continue;
+        }
+
+        auto time = header->ts.tv_sec * 1000000ULL + header->ts.tv_usec;
+        auto seq = ntohs(rtp->seq);
+        auto stamp = ntohl(rtp->stamp);
+        auto &ctx = contexts[ntohl(rtp->ssrc)];
+        if (!ctx.flow) {
+            ctx.flow = std::make_shared<ReplayFlow>();
+            ctx.first_time = time;
+            ctx.first_stamp = ctx.last_stamp = stamp;
+            ctx.last_seq = seq - 1;
+        }
+        ctx.seq_span += (uint16_t)(seq - ctx.last_seq);
+        ctx.last_seq = seq;
+        if (stamp != ctx.last_stamp) {
+            ctx.last_stamp = stamp;
+            ++ctx.stamp_count;
+        }
+        ctx.flow->packets.emplace_back(ReplayPacket { time > ctx.first_time ? time - ctx.first_time : 0, string((const char *)rtp, len) });
+    }
+
+    for (auto &pr : contexts) {
+        auto &ctx = pr.second;
+        auto &flow = *ctx.flow;
+        if (flow.packets.size() < 2 || !ctx.stamp_count) {
+            continue;
+        }
+        // 末尾补上一个平均帧间隔，作为下一次循环的开始
+        // Append an average frame interval at the end as the start of the next loop
+        auto stamp_span = ctx.last_stamp - ctx.first_stamp;
+        flow.stamp_span = stamp_span + stamp_span / ctx.stamp_count;
+        flow.duration = flow.packets.back().time + flow.packets.back().time / ctx.stamp_count;
+        flow.seq_span = ctx.seq_span;
+        InfoL << path << ": ssrc=" << printSSRC(pr.first) << ", packets=" << flow.packets.size() << ", duration=" << flow.duration / 1000 << "ms";
+        flows.emplace_back(ctx.flow);
+    }
+    return true;
+}
+
+//////////////////////////////////////////回放//////////////////////////////////////////
+
+// 回放倍速
+// Replay speed
+static atomic<double> s_speed { 1.0 };
+static atomic<uint64_t> s_sent_packets { 0 };
+static atomic<uint64_t> s_sent_bytes { 0 };
+
+class ReplayStream : public std::enable_shared_from_this<ReplayStream> {
+public:
+    using Ptr = std::shared_ptr<ReplayStream>;
+    using onOutput = function<void(const char *data, size_t len)>;
+
+    ReplayStream(std::shared_ptr<ReplayFlow> flow, uint32_t ssrc, EventPoller::Ptr poller) {
+        _flow = std::move(flow);
+        _ssrc = htonl(ssrc);
+        _poller = std::move(poller);
+    }
+
+    const EventPoller::Ptr &getPoller() const { return _poller; }
+
+    /**
+     * 开始回放
+     * @param delay_ms 延时开始，避免所有流的关键帧同时发送
+     * @param output 输出rtp
+     * Start replaying
+     * @param delay_ms Delay to start, to avoid sending the key frames of all streams at the same time
+     * @param output Output rtp
+     */
+    void start(uint64_t delay_ms, onOutput output) {
+        _output = std::move(output);
+        weak_ptr<ReplayStream> weak_self = shared_from_this();
+        _poller->doDelayTask(delay_ms + 1, [weak_self]() -> uint64_t {
+            auto strong_self = weak_self.lock();
+            if (!strong_self) {
+                return 0;
+            }
+            strong_self->onTimer();
+            return kTimerMS;
+        });
+    }
+
+private:
+    void onTimer() {
+        auto now = getCurrentMicrosecond();
+        if (_last_tick) {
+            _media_time += (now - _last_tick) * s_speed.load(memory_order_relaxed);
+        }
+        _last_tick = now;
+
+        auto &packets = _flow->packets;
+        size_t count = 0;
+        size_t bytes = 0;
+        while (true) {
+            auto &pkt = packets[_index];
+            if (_loop * _flow->duration + pkt.time > _media_time) {
+                break;
+            }
+            // 改写ssrc，并使循环回放时序号与时间戳连续
+            // Rewrite ssrc, and keep sequence and timestamp continuous when looping
+            _buffer.assign(pkt.data);
+            auto header = (RtpHeader *)&_buffer[0];
+            header->ssrc = _ssrc;
+            header->seq = htons((uint16_t)(ntohs(header->seq) + _loop * _flow->seq_span));
+            header->stamp = htonl((uint32_t)(ntohl(header->stamp) + _loop * _flow->stamp_span));
+            _output(_buffer.data(), _buffer.size());
+            ++count;
+            bytes += pkt.data.size();
+            if (++_index == packets.size()) {
+                _index = 0;
+                ++_loop;
+            }
+        }
+        if (count) {
+            s_sent_packets += count;
+            s_sent_bytes += bytes;
+        }
+    }
+
+private:
+    static constexpr uint64_t kTimerMS = 5;
+
+    size_t _index = 0;
+    uint64_t _loop = 0;
+    uint32_t _ssrc;
+    double _media_time = 0;
+    uint64_t _last_tick = 0;
+    string _buffer;
+    onOutput _output;
+    EventPoller::Ptr _poller;
+    std::shared_ptr<ReplayFlow> _flow;
+};
+
+//////////////////////////////////////////统计//////////////////////////////////////////
+
+struct Snapshot {
+    uint64_t sent_packets = 0;
+    uint64_t sent_bytes = 0;
+    uint64_t recv_packets = 0;
+    uint64_t lost_packets = 0;
+    uint64_t frames = 0;
+    size_t streams = 0;
+
+    static Snapshot get() {
+        Snapshot ret;
+        ret.sent_packets = s_sent_packets;
+        ret.sent_bytes = s_sent_bytes;
+        ret.recv_packets = Metrics::get(kMetricsRtp, kMetricsPacketsIn);
+        ret.lost_packets = Metrics::get(kMetricsRtp, kMetricsPacketsLost);
+        // 每路流的MultiMediaSourceMuxer输入帧数，同一路流的多个协议共用一个muxer
+        // Frames input to the MultiMediaSourceMuxer of each stream, multiple protocols of the same stream share one muxer
+        unordered_set<MultiMediaSourceMuxer *> visited;
+        MediaSource::for_each_media([&](const MediaSource::Ptr &media) {
+            auto muxer = media->getMuxer();
+            if (!muxer || !muxer->getLatency() || !visited.emplace(muxer.get()).second) {
+                return;
+            }
+            ret.frames += muxer->getLatency()->getValue(kLatencyMuxer).count;
+        }, "", "", kRtpAppName);
+        ret.streams = visited.size();
+        return ret;
+    }
+};
+
+static uint64_t delta(uint64_t end, uint64_t start) {
+    return end > start ? end - start : 0;
+}
+
+// 此程序把一个或多个pcap中的rtp流(ps/ts over udp)复制为K路不同ssrc的流，按指定倍速回放到RtpServer或直接输入RtpProcess，
+// 依次测试多个倍速，统计GB28181解复用路径能承受的包率与帧率，以及开始丢包的倍速，用于离线复现大规模国标接入的负载
+// This program copies the rtp streams (ps/ts over udp) in one or more pcaps into K streams with different ssrc,
+// replays them to RtpServer or directly inputs them to RtpProcess at the specified speeds,
+// tests multiple speeds in turn, and measures the packet rate and frame rate that the GB28181 demuxing path can sustain,
+// and the speed at which packet loss begins, which is used to reproduce the load of large-scale GB28181 access offline
+int main(int argc, char *argv[]) {
+    CMD_main cmd_main;
+    try {
+        cmd_main.operator()(argc, argv);
+    } catch (ExitException &) {
+        return 0;
+    } catch (std::exception &ex) {
+        cout << ex.what() << endl;
+        return -1;
+    }
+
+#if defined(ENABLE_RTPPROXY)
+    LogLevel logLevel = (LogLevel) cmd_main["level"].as<int>();
+    logLevel = MIN(MAX(logLevel, LTrace), LError);
+    size_t copies = MAX(cmd_main["copies"].as<int>(), 1);
+    auto step_sec = MAX(cmd_main["time"].as<int>(), 1);
+    auto warmup_sec = MAX(cmd_main["warmup"].as<int>(), 0);
+    auto server_mode = cmd_main["mode"] != "process";
+    uint16_t base_port = cmd_main["port"].as<uint16_t>();
+    size_t port_count = MAX(cmd_main["ports"].as<int>(), 1);
+    auto loss_threshold = cmd_main["loss"].as<double>();
+
+    vector<double> speeds;
+    for (auto &item : split(cmd_main["speed"], ",")) {
+        auto speed = atof(trim(item).data());
+        if (speed > 0) {
+            speeds.emplace_back(speed);
+        }
+    }
+    if (speeds.empty()) {
+        cout << "invalid speed: " << cmd_main["speed"] << endl;
+        return -1;
+    }
+
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", logLevel));
+    Logger::Instance().setWriter(std::make_shared<AsyncLogWriter>());
+    loadIniConfig((exeDir() + "config.ini").data());
+
+    // 服务器与发送端分别使用不同的线程池，线程负载只反映服务器
+    // The server and the senders use different thread pools, and the thread load only reflects the server
+    EventPollerPool::setPoolSize(MAX(cmd_main["server_threads"].as<int>(), 1));
+    WorkThreadPool::setPoolSize(MAX(cmd_main["sender_threads"].as<int>(), 1));
+
+    // 通过每路流的延时统计获取帧数
+    // Get the number of frames through the latency statistics of each stream
+    mINI::Instance()[General::kLatencyStatistic] = 1;
+    if (!cmd_main["all_protocol"].as<int>()) {
+        // 只保留一个不按需的rtsp复用器，否则无人观看时RtpProcess会直接丢弃数据而不解复用
+        // Only keep one rtsp muxer that is not on demand, otherwise RtpProcess will discard the data directly without demuxing when no one is watching
+        mINI::Instance()[Protocol::kEnableRtsp] = 1;
+        mINI::Instance()[Protocol::kRtspDemand] = 0;
+        mINI::Instance()[Protocol::kEnableRtmp] = 0;
+        mINI::Instance()[Protocol::kEnableHls] = 0;
+        mINI::Instance()[Protocol::kEnableHlsFmp4] = 0;
+        mINI::Instance()[Protocol::kEnableMP4] = 0;
+        mINI::Instance()[Protocol::kEnableTS] = 0;
+        mINI::Instance()[Protocol::kEnableFMP4] = 0;
+    }
+
+    vector<std::shared_ptr<ReplayFlow> > flows;
+    for (auto &path : split(cmd_main["in"], ",")) {
+        loadPcap(trim(path), flows);
+    }
+    if (flows.empty()) {
+        ErrorL << "no rtp stream found in pcap files";
+        return -1;
+    }
+
+    vector<RtpServer::Ptr> servers;
+    if (server_mode) {
+        try {
+            for (size_t i = 0; i < port_count; ++i) {
+                auto server = std::make_shared<RtpServer>();
+                server->start(base_port + 2 * i, "127.0.0.1", MediaTuple { DEFAULT_VHOST, kRtpAppName, "", "" }, RtpServer::NONE);
+                servers.emplace_back(std::move(server));
+            }
+        } catch (std::exception &ex) {
+            ErrorL << "start rtp server failed: " << ex.what();
+            return -1;
+        }
+    }
+
+    // 每路流一个ssrc与一个发送socket，模拟不同设备
+    // One ssrc and one sending socket per stream, simulating different devices
+    vector<ReplayStream::Ptr> streams;
+    vector<Socket::Ptr> sockets;
+    vector<RtpProcess::Ptr> processes;
+    auto total = copies * flows.size();
+    for (size_t i = 0; i < total; ++i) {
+        uint32_t ssrc = 0x10000000 + i;
+        auto poller = server_mode ? WorkThreadPool::Instance().getPoller() : EventPollerPool::Instance().getPoller();
+        auto stream = std::make_shared<ReplayStream>(flows[i % flows.size()], ssrc, poller);
+        auto sock = Socket::createSocket(poller, false);
+        ReplayStream::onOutput output;
+        if (server_mode) {
+            sock->bindUdpSock(0, "127.0.0.1");
+            auto addr = SockUtil::make_sockaddr("127.0.0.1", base_port + 2 * (i % port_count));
+            sock->bindPeerAddr((struct sockaddr *)&addr, 0, true);
+            SockUtil::setSendBuf(sock->rawFD(), 1024 * 1024);
+            output = [sock](const char *data, size_t len) { sock->send(data, len); };
+        } else {
+            RtpProcess::Ptr process;
+            poller->sync([&]() { process = RtpProcess::createProcess(MediaTuple { DEFAULT_VHOST, kRtpAppName, printSSRC(ssrc), "" }); });
+            auto addr = std::make_shared<struct sockaddr_storage>(SockUtil::make_sockaddr("127.0.0.1", 10000 + i % 50000));
+            auto dts = std::make_shared<uint64_t>(0);
+            weak_ptr<RtpProcess> weak_process = process;
+            output = [weak_process, sock, addr, dts](const char *data, size_t len) {
+                if (auto strong_process = weak_process.lock()) {
+                    try {
+                        // 传入dts_out，确保无人观看时也解复用
+                        // Pass in dts_out to ensure demuxing even when no one is watching
+                        strong_process->inputRtp(true, sock, data, len, (struct sockaddr *)addr.get(), dts.get());
+                    } catch (std::exception &ex) {
+                        WarnL << "input rtp failed: " << ex.what();
+                    }
+                }
+            };
+            processes.emplace_back(std::move(process));
+        }
+        stream->start(i * 7 % 1000, std::move(output));
+        sockets.emplace_back(std::move(sock));
+        streams.emplace_back(std::move(stream));
+    }
+
+    static bool exit_flag = false;
+    signal(SIGINT, [](int) { exit_flag = true; });
+
+    s_speed = speeds[0];
+    for (auto i = 0; i < warmup_sec && !exit_flag; ++i) {
+        sleep(1);
+    }
+
+    cout << "streams: " << total << ", mode: " << (server_mode ? "server" : "process") << endl;
+    cout << setw(8) << "speed" << setw(10) << "streams" << setw(12) << "sent pps" << setw(12) << "recv pps" << setw(12) << "frames/s" << setw(10)
+         << "Mbps" << setw(10) << "loss%" << setw(10) << "load%" << endl;
+
+    double base_loss = -1;
+    double max_speed = 0;
+    bool saturated = false;
+    for (auto speed : speeds) {
+        if (exit_flag) {
+            break;
+        }
+        s_speed = speed;
+        // 等待上一个倍速积压的数据处理完毕
+        // Wait for the backlog of the previous speed to be processed
+        sleep(1);
+        auto start = Snapshot::get();
+        Ticker ticker;
+        uint64_t load_sum = 0;
+        size_t load_samples = 0;
+        for (auto i = 0; i < step_sec && !exit_flag; ++i) {
+            sleep(1);
+            for (auto load : EventPollerPool::Instance().getExecutorLoad()) {
+                load_sum += load;
+            }
+            ++load_samples;
+        }
+        auto end = Snapshot::get();
+        auto seconds = MAX(ticker.elapsedTime(), (uint64_t)1) / 1000.0;
+
+        auto sent = delta(end.sent_packets, start.sent_packets);
+        auto recv = server_mode ? delta(end.recv_packets, start.recv_packets) : sent;
+        // 发送后未被接收的包(socket缓存溢出)与序号空洞均计为丢包
+        // Packets not received after being sent (socket buffer overflow) and sequence gaps are both counted as lost
+        auto lost = delta(sent, recv) + delta(end.lost_packets, start.lost_packets);
+        auto loss = sent ? 100.0 * lost / sent : 0;
+        if (base_loss < 0) {
+            base_loss = loss;
+        }
+        if (loss - base_loss > loss_threshold) {
+            saturated = true;
+        } else if (!saturated) {
+            max_speed = speed;
+        }
+        cout << setw(8) << fixed << setprecision(1) << speed << setw(10) << end.streams << setw(12) << setprecision(0) << sent / seconds << setw(12) << recv / seconds
+             << setw(12) << delta(end.frames, start.frames) / seconds << setw(10) << setprecision(1)
+             << delta(end.sent_bytes, start.sent_bytes) * 8 / 1000000.0 / seconds << setw(10) << setprecision(3) << loss << setw(10)
+             << setprecision(0) << (load_samples ? (double)load_sum / load_samples : 0) << endl;
+    }
+    cout << "max sustained speed: " << max_speed << "x" << endl;
+    return 0;
+#else
+    cout << "ENABLE_RTPPROXY is required" << endl;
+    return -1;
+#endif // defined(ENABLE_RTPPROXY)
+}
@@ -0,0 +1,173 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <signal.h>
+#include <iostream>
+#include "Util/logger.h"
+#include "Util/util.h"
+#include "Util/CMD.h"
+#include "Common/config.h"
+#include "Common/LatencyStamp.h"
+#include "Common/LatencyStatistic.h"
+#include "Player/MediaPlayer.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+class CMD_main : public CMD {
+public:
+    CMD_main() {
+        _parser.reset(new OptionParser(nullptr));
+
+        (*_parser) << Option('l',/*该选项简称，如果是\x00则说明无简称*/
+                             "level",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             to_string(LInfo).data(),/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "日志等级,LTrace~LError(0~4)",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('i',/*该选项简称，如果是\x00则说明无简称*/
+                             "in",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             nullptr,/*该选项默认值*/
+                             true,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "拉流url,多个url以逗号分隔,例如同一路流的rtsp/rtmp/http-flv/hls播放地址",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('T',/*该选项简称，如果是\x00则说明无简称*/
+                             "rtp",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             to_string((int) (Rtsp::RTP_TCP)).data(),/*该选项默认值*/
+                             true,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "rtsp拉流方式,支持tcp/udp/multicast:0/1/2",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('s',/*该选项简称，如果是\x00则说明无简称*/
+                             "interval",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "5",/*该选项默认值*/
+                             true,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "打印延时统计的间隔,单位秒",/*该选项说明文字*/
+                             nullptr);
+    }
+
+    ~CMD_main() override {}
+
+    const char *description() const override {
+        return "主程序命令参数";
+    }
+};
+
+struct LatencyPlayer {
+    string url;
+    MediaPlayer::Ptr player;
+    // 端到端延时分布，单位微秒
+    // End-to-end latency distribution, in microseconds
+    LatencyHistogram histogram;
+    atomic<bool> failed { false };
+};
+
+static void startPlay(const std::shared_ptr<LatencyPlayer> &item, int rtp_type) {
+    item->failed = false;
+    item->player = std::make_shared<MediaPlayer>();
+    weak_ptr<MediaPlayer> weak_player = item->player;
+    weak_ptr<LatencyPlayer> weak_item = item;
+    item->player->setOnPlayResult([weak_player, weak_item](const SockException &ex) {
+        auto strong_player = weak_player.lock();
+        auto strong_item = weak_item.lock();
+        if (!strong_player || !strong_item) {
+            return;
+        }
+        if (ex) {
+            WarnL << "play " << strong_item->url << " failed: " << ex;
+            strong_item->failed = true;
+            return;
+        }
+        auto video = strong_player->getTrack(TrackVideo, false);
+        if (!video) {
+            WarnL << strong_item->url << " has no video track";
+            return;
+        }
+        video->addDelegate([weak_item](const Frame::Ptr &frame) {
+            auto strong_item = weak_item.lock();
+            uint64_t stamp_ms;
+            if (strong_item && LatencyStamp::parse(frame->data(), frame->size(), stamp_ms)) {
+                auto now_ms = getCurrentMillisecond(true);
+                // 两端系统时间未同步时可能为负
+                // It may be negative when the system time of both ends is not synchronized
+                strong_item->histogram.record(now_ms > stamp_ms ? (now_ms - stamp_ms) * 1000 : 0);
+            }
+            return true;
+        });
+    });
+    item->player->setOnShutdown([weak_item](const SockException &ex) {
+        auto strong_item = weak_item.lock();
+        if (strong_item) {
+            WarnL << "play " << strong_item->url << " shutdown: " << ex;
+            strong_item->failed = true;
+        }
+    });
+    (*item->player)[Client::kRtpType] = rtp_type;
+    item->player->play(item->url);
+}
+
+// 此程序用于测量服务器到各协议播放端的端到端延时，需要服务器开启general.latency_stamp
+// 同时拉取同一路流的多个协议地址，周期性打印每个地址的延时分布(毫秒)
+// This program is used to measure the end-to-end latency from the server to players of each protocol, general.latency_stamp needs to be enabled on the server
+// It pulls multiple protocol urls of the same stream at the same time, and periodically prints the latency distribution (milliseconds) of each url
+int main(int argc, char *argv[]) {
+    CMD_main cmd_main;
+    try {
+        cmd_main.operator()(argc, argv);
+    } catch (ExitException &) {
+        return 0;
+    } catch (std::exception &ex) {
+        cout << ex.what() << endl;
+        return -1;
+    }
+
+    LogLevel logLevel = (LogLevel) cmd_main["level"].as<int>();
+    logLevel = MIN(MAX(logLevel, LTrace), LError);
+    auto rtp_type = cmd_main["rtp"].as<int>();
+    auto interval = MAX(cmd_main["interval"].as<int>(), 1);
+
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", logLevel));
+    Logger::Instance().setWriter(std::make_shared<AsyncLogWriter>());
+
+    vector<std::shared_ptr<LatencyPlayer> > players;
+    for (auto &url : split(cmd_main["in"], ",")) {
+        auto item = std::make_shared<LatencyPlayer>();
+        item->url = trim(url);
+        startPlay(item, rtp_type);
+        players.emplace_back(std::move(item));
+    }
+
+    static bool exit_flag = false;
+    signal(SIGINT, [](int) { exit_flag = true; });
+    while (!exit_flag) {
+        sleep(interval);
+        _StrPrinter printer;
+        printer << "end-to-end latency(ms):\n";
+        for (auto &item : players) {
+            auto value = item->histogram.getValue();
+            printer << item->url << ": count=" << value.count << ", avg=" << value.avg / 1000.0 << ", p50=" << value.p50 / 1000.0
+                    << ", p90=" << value.p90 / 1000.0 << ", p99=" << value.p99 / 1000.0 << ", max=" << value.max / 1000.0 << "\n";
+            if (item->failed) {
+                // 播放失败或中断，重新播放
+                // Playback failed or interrupted, play again
+                startPlay(item, rtp_type);
+            }
+        }
+        InfoL << printer;
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string>
+#include <iostream>
+#include "Util/logger.h"
+#include "Util/util.h"
+#include "Common/LatencyStamp.h"
+#include "Extension/Factory.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+static const char s_uuid[] = "ZLM-latency-stmp";
+
+static string hexDump(const char *data, size_t size) {
+    _StrPrinter printer;
+    for (size_t i = 0; i < size; ++i) {
+        char buf[4];
+        snprintf(buf, sizeof(buf), "%02X ", (uint8_t)data[i]);
+        printer << buf;
+    }
+    return printer;
+}
+
+// 检查打点SEI帧的每个字节，并确认能从中解析出打点时间
+// Check every byte of the stamp SEI frame, and make sure the stamp time can be parsed from it
+static bool testCodec(CodecId codec, const string &slice, const string &nal_header) {
+    auto frame = Factory::getFrameFromPtr(codec, slice.data(), slice.size(), 100, 120);
+    auto before = getCurrentMillisecond(true);
+    auto sei = LatencyStamp::makeSeiFrame(frame);
+    auto after = getCurrentMillisecond(true);
+    if (!sei) {
+        cout << getCodecName(codec) << ": 未生成SEI帧" << endl;
+        return false;
+    }
+    cout << getCodecName(codec) << ": " << hexDump(sei->data(), sei->size()) << endl;
+
+    string expect("\x00\x00\x00\x01", 4);
+    expect += nal_header;
+    // payload_type: user_data_unregistered, payload_size: uuid + 8字节时间戳
+    // payload_type: user_data_unregistered, payload_size: uuid + 8-byte timestamp
+    expect.push_back(5);
+    expect.push_back(sizeof(s_uuid) - 1 + 8);
+    expect.append(s_uuid, sizeof(s_uuid) - 1);
+
+    string bytes(sei->data(), sei->size());
+    if (sei->prefixSize() != 4 || bytes.size() < expect.size() + 9 || bytes.compare(0, expect.size(), expect) != 0) {
+        cout << getCodecName(codec) << ": SEI头部错误, 期望: " << hexDump(expect.data(), expect.size()) << endl;
+        return false;
+    }
+    if ((uint8_t)bytes.back() != 0x80) {
+        cout << getCodecName(codec) << ": 缺少rbsp_trailing_bits" << endl;
+        return false;
+    }
+    if (sei->getCodecId() != codec || sei->dts() != frame->dts() || sei->pts() != frame->pts() || !sei->dropAble()) {
+        cout << getCodecName(codec) << ": SEI帧属性错误" << endl;
+        return false;
+    }
+    uint64_t stamp_ms = 0;
+    if (!LatencyStamp::parse(sei->data(), sei->size(), stamp_ms) || stamp_ms < before || stamp_ms > after) {
+        cout << getCodecName(codec) << ": 打点时间解析错误: " << stamp_ms << endl;
+        return false;
+    }
+    // 非一帧第一个slice的帧不插入SEI
+    // No SEI is inserted before a frame that is not the first slice of a frame
+    auto next_slice = slice;
+    next_slice[4 + nal_header.size()] = 0;
+    if (LatencyStamp::makeSeiFrame(Factory::getFrameFromPtr(codec, next_slice.data(), next_slice.size(), 100, 120))) {
+        cout << getCodecName(codec) << ": 非第一个slice也插入了SEI" << endl;
+        return false;
+    }
+    return true;
+}
+
+// 该测试程序用于检验端到端延时打点SEI的码流格式
+// This test program is used to verify the bitstream format of the end-to-end latency stamp SEI
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+
+    // h264 idr slice, first_mb_in_slice = 0
+    auto h264_ok = testCodec(CodecH264, string("\x00\x00\x00\x01\x65\x88\x84\x00", 8), string("\x06", 1));
+    // h265 idr_w_radl slice, first_slice_segment_in_pic_flag = 1
+    auto h265_ok = testCodec(CodecH265, string("\x00\x00\x00\x01\x26\x01\xAF\x00", 8), string("\x4E\x01", 2));
+    cout << (h264_ok && h265_ok ? "测试通过" : "测试失败") << endl;
+    return h264_ok && h265_ok ? 0 : -1;
+}
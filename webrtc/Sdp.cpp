@@ -1847,6 +1847,9 @@ void RtcConfigure::setPlayRtspInfo(const string &sdp) {
 
 static const string kProfile { "profile-level-id" };
 static const string kMode { "packetization-mode" };
+static const string kAV1Profile { "profile" };
+static const string kAV1LevelIdx { "level-idx" };
+static const string kAV1Tier { "tier" };
 
 bool RtcConfigure::onCheckCodecProfile(const RtcCodecPlan &plan, CodecId codec) const {
     if (_rtsp_audio_plan && codec == getCodecId(_rtsp_audio_plan->codec)) {
@@ -1867,6 +1870,15 @@ bool RtcConfigure::onCheckCodecProfile(const RtcCodecPlan &plan, CodecId codec)
         }
         return true;
     }
+    if (_rtsp_video_plan && codec == CodecAV1 && getCodecId(_rtsp_video_plan->codec) == CodecAV1) {
+        // av1时，profile必须一致，缺省为0
+        // When av1, the profile must be the same, defaults to 0
+        auto &fmtp = const_cast<RtcCodecPlan &>(plan).fmtp;
+        if (atoi(_rtsp_video_plan->fmtp[kAV1Profile].data()) != atoi(fmtp[kAV1Profile].data())) {
+            return false;
+        }
+        return true;
+    }
 
     return true;
 }
@@ -1889,6 +1901,16 @@ void RtcConfigure::onSelectPlan(RtcCodecPlan &plan, CodecId codec) const {
         GET_CONFIG(bool, h264_stap_a, Rtp::kH264StapA);
         plan.fmtp[kMode] = mode.empty() ? std::to_string(h264_stap_a) : mode;
     }
+    if (_rtsp_video_plan && codec == CodecAV1 && getCodecId(_rtsp_video_plan->codec) == CodecAV1) {
+        // av1时，answer中的profile、level-idx、tier与发送的码流一致
+        // When av1, the profile, level-idx and tier in the answer are consistent with the sent stream
+        for (auto &key : { kAV1Profile, kAV1LevelIdx, kAV1Tier }) {
+            auto value = _rtsp_video_plan->fmtp[key];
+            if (!value.empty()) {
+                plan.fmtp[key] = value;
+            }
+        }
+    }
 }
 
 } // namespace mediakit
\ No newline at end of file
@@ -66,6 +66,18 @@ RtpPacket::Ptr H264BFrameFilter::processPacket(const RtpPacket::Ptr &packet) {
 bool H264BFrameFilter::isH264BFrame(const RtpPacket::Ptr &packet) const {
     uint8_t *payload = packet->getPayload();
     size_t payload_size = packet->getPayloadSize();
+    uint8_t probe[32];
+    if (auto &ref = packet->getPayloadRef()) {
+        // 零拷贝rtp包的负载在引用中，判断slice类型只需要nal头与slice头的前几个字节，拷贝到栈上即可，无需合并整包
+        // The payload of the zero copy rtp packet is in the reference, judging the slice type only needs the nal header
+        // and the first few bytes of the slice header, so copy them to the stack instead of merging the whole packet
+        auto head_size = std::min(payload_size, sizeof(probe));
+        auto ref_size = std::min(ref->size(), sizeof(probe) - head_size);
+        memcpy(probe, payload, head_size);
+        memcpy(probe + head_size, ref->data(), ref_size);
+        payload = probe;
+        payload_size = head_size + ref_size;
+    }
 
     if (payload_size < 1) {
         return false;
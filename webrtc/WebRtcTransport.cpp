@@ -13,6 +13,7 @@
 #include "Util/base64.h"
 #include "Network/sockutil.h"
 #include "Common/config.h"
+#include "Common/Metrics.h"
 #include "Nack.h"
 #include "RtpExt.h"
 #include "Rtcp/Rtcp.h"
@@ -454,6 +455,7 @@ static bool isDtls(char *buf) {
 }
 
 void WebRtcTransport::inputSockData(char *buf, int len, RTC::TransportTuple *tuple) {
+    Metrics::add(kMetricsWebrtc, kMetricsBytesIn, len);
     if (RTC::StunPacket::IsStun((const uint8_t *)buf, len)) {
         std::unique_ptr<RTC::StunPacket> packet(RTC::StunPacket::Parse((const uint8_t *)buf, len));
         if (!packet) {
@@ -473,6 +475,7 @@ void WebRtcTransport::inputSockData(char *buf, int len, RTC::TransportTuple *tup
             return;
         }
         if (_srtp_session_recv->DecryptSrtp((uint8_t *)buf, &len)) {
+            Metrics::add(kMetricsWebrtc, kMetricsPacketsIn);
             onRtp(buf, len, _ticker.createdTime());
         }
         return;
@@ -490,12 +493,24 @@ void WebRtcTransport::inputSockData(char *buf, int len, RTC::TransportTuple *tup
 }
 
 void WebRtcTransport::sendRtpPacket(const char *buf, int len, bool flush, void *ctx) {
+    sendRtpPacket(buf, len, nullptr, flush, ctx);
+}
+
+void WebRtcTransport::sendRtpPacket(const char *buf, int len, const Buffer::Ptr &tail, bool flush, void *ctx) {
     if (_srtp_session_send) {
+        Metrics::add(kMetricsWebrtc, kMetricsPacketsOut);
         auto pkt = _packet_pool.obtain2();
+        int tail_len = tail ? (int)tail->size() : 0;
         // 预留rtx加入的两个字节  [AUTO-TRANSLATED:d1eb5cd7]
         // Reserve two bytes for rtx joining
-        pkt->setCapacity((size_t)len + SRTP_MAX_TRAILER_LEN + 2);
+        pkt->setCapacity((size_t)len + tail_len + SRTP_MAX_TRAILER_LEN + 2);
         memcpy(pkt->data(), buf, len);
+        if (tail_len) {
+            // srtp加密需要连续内存，零拷贝负载在此处合并，替代了打包时的拷贝
+            // Srtp encryption requires contiguous memory, the zero copy payload is merged here instead of being copied when packing
+            memcpy(pkt->data() + len, tail->data(), tail_len);
+            len += tail_len;
+        }
         onBeforeEncryptRtp(pkt->data(), len, ctx);
         if (_srtp_session_send->EncryptRtp(reinterpret_cast<uint8_t *>(pkt->data()), &len)) {
             pkt->setSize(len);
@@ -574,10 +589,28 @@ void WebRtcTransportImp::onSendSockData(Buffer::Ptr buf, bool flush, RTC::Transp
             return;
         }
     }
+    Metrics::add(kMetricsWebrtc, kMetricsBytesOut, buf->size());
 
     // 一次性发送一帧的rtp数据，提高网络io性能  [AUTO-TRANSLATED:fbab421e]
     // Send one frame of rtp data at a time to improve network io performance
-    if (tuple->getSock()->sockType() == SockNum::Sock_TCP) {
+    auto sock = tuple->getSock();
+    if (sock->sockType() == SockNum::Sock_UDP) {
+        if (_udp_batch_sock != sock) {
+            // 切换了传输通道，先发送之前缓存的包
+            // The transport tuple has changed, send the previously cached packets first
+            if (_udp_batch_sock) {
+                _udp_batch.flush(_udp_batch_sock);
+            }
+            _udp_batch_sock = sock;
+        }
+        _udp_batch.addPacket(std::move(buf));
+        if (flush) {
+            _udp_batch.flush(_udp_batch_sock);
+            _udp_batch_sock = nullptr;
+        }
+        return;
+    }
+    if (sock->sockType() == SockNum::Sock_TCP) {
         // 增加tcp两字节头  [AUTO-TRANSLATED:62159f79]
         // Add two-byte header to tcp
         auto len = buf->size();
@@ -839,6 +872,7 @@ public:
         _poller = std::move(poller);
         _on_nack = std::move(on_nack);
         setOnSorted(std::move(cb));
+        setMetricsProtocol(kMetricsWebrtc);
         // 设置jitter buffer参数  [AUTO-TRANSLATED:eede98b6]
         // Set jitter buffer parameters
         GET_CONFIG(uint32_t, nack_maxms, Rtc::kNackMaxMS);
@@ -1008,6 +1042,7 @@ void WebRtcTransportImp::onRtcp(const char *buf, size_t len) {
                 }
                 auto &track = it->second;
                 auto &fci = fb->getFci<FCI_NACK>();
+                Metrics::add(kMetricsWebrtc, kMetricsNackIn);
                 track->nack_list.forEach(fci, [&](const RtpPacket::Ptr &rtp) {
                     // rtp重传  [AUTO-TRANSLATED:62a37e46]
                     // rtp retransmission
@@ -1155,6 +1190,7 @@ void WebRtcTransportImp::onSendNack(MediaTrack &track, const FCI_NACK &nack, uin
     auto rtcp = RtcpFB::create(RTPFBType::RTCP_RTPFB_NACK, &nack, FCI_NACK::kSize);
     rtcp->ssrc = htonl(track.answer_ssrc_rtp);
     rtcp->ssrc_media = htonl(ssrc);
+    Metrics::add(kMetricsWebrtc, kMetricsNackOut);
     sendRtcpPacket((char *)rtcp.get(), rtcp->getSize(), true);
 }
 
@@ -1199,7 +1235,7 @@ void WebRtcTransportImp::onSendRtp(const RtpPacket::Ptr &rtp, bool flush, bool r
         // Statistics of RTP sending, for SR reporting
         track->rtcp_context_send->onRtp(
             rtp->getSeq(), rtp->getStamp(), rtp->ntp_stamp, rtp->sample_rate,
-            rtp->size() - RtpPacket::kRtpTcpHeaderSize);
+            rtp->getTotalSize() - RtpPacket::kRtpTcpHeaderSize);
         track->nack_list.pushBack(rtp);
 #if 0
         // 此处模拟发送丢包  [AUTO-TRANSLATED:9612f08e]
@@ -1214,8 +1250,8 @@ void WebRtcTransportImp::onSendRtp(const RtpPacket::Ptr &rtp, bool flush, bool r
         // TraceL << "send rtx rtp:" << rtp->getSeq();
     }
     pair<bool /*rtx*/, MediaTrack *> ctx { rtx, track.get() };
-    sendRtpPacket(rtp->data() + RtpPacket::kRtpTcpHeaderSize, rtp->size() - RtpPacket::kRtpTcpHeaderSize, flush, &ctx);
-    _bytes_usage += rtp->size() - RtpPacket::kRtpTcpHeaderSize;
+    sendRtpPacket(rtp->data() + RtpPacket::kRtpTcpHeaderSize, rtp->size() - RtpPacket::kRtpTcpHeaderSize, rtp->getPayloadRef(), flush, &ctx);
+    _bytes_usage += rtp->getTotalSize() - RtpPacket::kRtpTcpHeaderSize;
 }
 
 void WebRtcTransportImp::onBeforeEncryptRtp(const char *buf, int &len, void *ctx) {
@@ -1289,6 +1325,24 @@ uint64_t WebRtcTransportImp::getBytesUsage() const {
     return _bytes_usage;
 }
 
+size_t WebRtcTransportImp::getSendSpeed() const {
+    // sendmmsg直接写socket fd，不经过Socket的发送统计
+    // sendmmsg writes the socket fd directly, bypassing the send statistics of Socket
+    size_t ret = _udp_batch.getSendSpeed();
+    if (auto tuple = _ice_server ? _ice_server->GetSelectedTuple() : nullptr) {
+        ret += tuple->getSock()->getSendSpeed();
+    }
+    return ret;
+}
+
+size_t WebRtcTransportImp::getSendTotalBytes() const {
+    size_t ret = _udp_batch.getSendTotalBytes();
+    if (auto tuple = _ice_server ? _ice_server->GetSelectedTuple() : nullptr) {
+        ret += tuple->getSock()->getSendTotalBytes();
+    }
+    return ret;
+}
+
 uint64_t WebRtcTransportImp::getDuration() const {
     return _alive_ticker.createdTime() / 1000;
 }
@@ -25,6 +25,7 @@
 #include "TwccContext.h"
 #include "SctpAssociation.hpp"
 #include "Rtcp/RtcpContext.h"
+#include "Common/UdpBatchSender.h"
 
 namespace mediakit {
 
@@ -137,6 +138,11 @@ public:
      * [AUTO-TRANSLATED:aa833695]
      */
     void sendRtpPacket(const char *buf, int len, bool flush, void *ctx = nullptr);
+    /**
+     * 发送rtp，rtp包由buf与tail(零拷贝rtp包引用的负载)拼接而成，在srtp加密前拷贝合并
+     * Send rtp, the rtp packet consists of buf and tail (the payload referenced by the zero copy rtp packet), which are joined before srtp encryption
+     */
+    void sendRtpPacket(const char *buf, int len, const toolkit::Buffer::Ptr &tail, bool flush, void *ctx = nullptr);
     void sendRtcpPacket(const char *buf, int len, bool flush, void *ctx = nullptr);
     void sendDatachannel(uint16_t streamId, uint32_t ppid, const char *msg, size_t len);
 
@@ -275,6 +281,10 @@ public:
 
     uint64_t getBytesUsage() const;
     uint64_t getDuration() const;
+    // 获取发送速率与发送的总字节数，包括当前传输通道socket以及udp批量发送的数据
+    // Get the send speed and the total bytes sent, including the socket of the current transport tuple and the data sent in udp batch
+    size_t getSendSpeed() const;
+    size_t getSendTotalBytes() const;
     bool canSendRtp() const;
     bool canRecvRtp() const;
     void onSendRtp(const RtpPacket::Ptr &rtp, bool flush, bool rtx = false);
@@ -352,6 +362,10 @@ private:
     // http访问时的host ip  [AUTO-TRANSLATED:e8fe6957]
     // Host ip for http access
     std::string _local_ip;
+    // udp方式发送时，一帧的srtp包先缓存再批量发送
+    // In udp mode, the srtp packets of a frame are cached first and then sent in batch
+    UdpBatchSender _udp_batch;
+    Socket::Ptr _udp_batch_sock;
 };
 
 class WebRtcTransportManager {